@@ -0,0 +1,32 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import Foundation;
+@import ZMCDataModel;
+
+@interface ZMConversation (UnreadCount)
+
+/// Matches the conversations counted by +[ZMConversation unreadConversationCountInContext:]: not self, not invalid, not blocked,
+/// and either with unread messages or with a pending connection request.
+/// It can be used in a fetch request and evaluated on a single conversation.
+///
+/// @note This belongs next to the count in ZMCDataModel, which should then build its fetch from it, so the two can not drift apart.
++ (NSPredicate *)predicateForConversationsCountedAsUnread;
+
+@end
@@ -0,0 +1,37 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#import "ZMConversation+UnreadCount.h"
+
+@implementation ZMConversation (UnreadCount)
+
++ (NSPredicate *)predicateForConversationsCountedAsUnread
+{
+    static NSPredicate *predicate;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        predicate = [NSPredicate predicateWithFormat:@"conversationType != %d AND conversationType != %d "
+                     @"AND (connection == nil OR connection.status != %d) "
+                     @"AND (internalEstimatedUnreadCount > 0 OR (connection != nil AND connection.status == %d))",
+                     ZMConversationTypeSelf, ZMConversationTypeInvalid, ZMConnectionStatusBlocked, ZMConnectionStatusPending];
+    });
+    return predicate;
+}
+
+@end
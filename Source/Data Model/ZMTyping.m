@@ -80,9 +80,14 @@ const NSTimeInterval ZMTypingRelativeSendTimeout = 5;
 
 - (void)setIsTyping:(BOOL)isTyping forUser:(ZMUser *)user inConversation:(ZMConversation *)conversation;
 {
-    BOOL const wasTyping = [self.typingUserTimeout containsUser:user conversation:conversation];
+    NSDate *currentTimeout = [self.typingUserTimeout timeoutForUser:user conversation:conversation];
+    BOOL const wasTyping = (currentTimeout != nil);
     if (isTyping) {
-        [self.typingUserTimeout addUser:user conversation:conversation withTimeout:[NSDate dateWithTimeIntervalSinceNow:self.timeout]];
+        NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:self.timeout];
+        if (wasTyping && ! [self shouldExtendTimeout:currentTimeout toTimeout:timeout]) {
+            return;
+        }
+        [self.typingUserTimeout addUser:user conversation:conversation withTimeout:timeout];
     }
     if (wasTyping != isTyping) {
         if (! isTyping) {
@@ -93,6 +98,14 @@ const NSTimeInterval ZMTypingRelativeSendTimeout = 5;
     [self updateExpirationWithDate:self.typingUserTimeout.firstTimeout];
 }
 
+/// Typing events for a user that is already typing are coalesced when they would extend the timeout by less than half
+/// the interval at which clients send typing events, e.g. duplicates of the same event or events from several clients of the same user.
+- (BOOL)shouldExtendTimeout:(NSDate *)currentTimeout toTimeout:(NSDate *)timeout
+{
+    NSTimeInterval const coalescingInterval = self.timeout / ZMTypingRelativeSendTimeout / 2;
+    return [timeout timeIntervalSinceDate:currentTimeout] >= coalescingInterval;
+}
+
 - (void)sendNotificationForConversation:(ZMConversation *)conversation
 {
     NSSet *userIds = [self.typingUserTimeout userIDsInConversation:conversation];
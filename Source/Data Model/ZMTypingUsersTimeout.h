@@ -29,6 +29,8 @@
 - (void)removeUser:(ZMUser *)user conversation:(ZMConversation *)conversation;
 
 - (BOOL)containsUser:(ZMUser *)user conversation:(ZMConversation *)conversation;
+/// Returns the timeout for the user in the conversation, or nil if the user is not typing in it
+- (NSDate *)timeoutForUser:(ZMUser *)user conversation:(ZMConversation *)conversation;
 
 @property (nonatomic, readonly) NSDate *firstTimeout;
 
@@ -35,9 +35,39 @@
 
 
 
+/// A timeout in the heap. It is stale once the user has been removed, or added again with a different timeout.
+@interface ZMTypingTimeoutEntry : NSObject
+
+@property (nonatomic, readonly) ZMUserAndConversationKey *key;
+@property (nonatomic, readonly) NSDate *timeout;
+
+@end
+
+
+
+@implementation ZMTypingTimeoutEntry
+
+- (instancetype)initWithKey:(ZMUserAndConversationKey *)key timeout:(NSDate *)timeout
+{
+    self = [super init];
+    if (self) {
+        _key = key;
+        _timeout = timeout;
+    }
+    return self;
+}
+
+@end
+
+
+
 @interface ZMTypingUsersTimeout ()
 
-@property (nonatomic, readonly) NSMutableDictionary *timeouts;
+/// Conversation object ID -> (user object ID -> ZMTypingTimeoutEntry)
+@property (nonatomic, readonly) NSMutableDictionary *entriesByConversation;
+/// Min-heap of ZMTypingTimeoutEntry ordered by timeout. Stale entries are dropped lazily when they reach the top.
+@property (nonatomic, readonly) NSMutableArray<ZMTypingTimeoutEntry *> *heap;
+@property (nonatomic) NSUInteger count;
 
 @end
 
@@ -49,7 +79,8 @@
 {
     self = [super init];
     if (self) {
-        _timeouts = [NSMutableDictionary dictionary];
+        _entriesByConversation = [NSMutableDictionary dictionary];
+        _heap = [NSMutableArray array];
     }
     return self;
 }
@@ -60,7 +91,18 @@
     Require(conversation != nil);
     Require(timeout != nil);
     ZMUserAndConversationKey *key = [ZMUserAndConversationKey keyWithUser:user conversation:conversation];
-    self.timeouts[key] = timeout;
+    NSMutableDictionary *entriesByUser = self.entriesByConversation[key.conversationObjectID];
+    if (entriesByUser == nil) {
+        entriesByUser = [NSMutableDictionary dictionary];
+        self.entriesByConversation[key.conversationObjectID] = entriesByUser;
+    }
+    if (entriesByUser[key.userObjectID] == nil) {
+        ++self.count;
+    }
+    ZMTypingTimeoutEntry *entry = [[ZMTypingTimeoutEntry alloc] initWithKey:key timeout:timeout];
+    entriesByUser[key.userObjectID] = entry;
+    [self pushEntry:entry];
+    [self compactHeapIfNeeded];
 }
 
 - (void)removeUser:(ZMUser *)user conversation:(ZMConversation *)conversation;
@@ -68,54 +110,142 @@
     Require(user != nil);
     Require(conversation != nil);
     ZMUserAndConversationKey *key = [ZMUserAndConversationKey keyWithUser:user conversation:conversation];
-    [self.timeouts removeObjectForKey:key];
+    [self removeEntryForKey:key];
+}
+
+- (void)removeEntryForKey:(ZMUserAndConversationKey *)key
+{
+    NSMutableDictionary *entriesByUser = self.entriesByConversation[key.conversationObjectID];
+    if (entriesByUser[key.userObjectID] == nil) {
+        return;
+    }
+    --self.count;
+    [entriesByUser removeObjectForKey:key.userObjectID];
+    if (entriesByUser.count == 0) {
+        [self.entriesByConversation removeObjectForKey:key.conversationObjectID];
+    }
 }
 
+- (ZMTypingTimeoutEntry *)entryForKey:(ZMUserAndConversationKey *)key
+{
+    return self.entriesByConversation[key.conversationObjectID][key.userObjectID];
+}
 
 - (BOOL)containsUser:(ZMUser *)user conversation:(ZMConversation *)conversation;
+{
+    return [self timeoutForUser:user conversation:conversation] != nil;
+}
+
+- (NSDate *)timeoutForUser:(ZMUser *)user conversation:(ZMConversation *)conversation;
 {
     Require(user != nil);
     Require(conversation != nil);
     ZMUserAndConversationKey *key = [ZMUserAndConversationKey keyWithUser:user conversation:conversation];
-    return self.timeouts[key] != nil;
+    return [self entryForKey:key].timeout;
 }
 
 - (NSDate *)firstTimeout;
 {
-    NSDate *minDate;
-    for (NSDate *date in self.timeouts.allValues) {
-        if (minDate == nil ||
-            [minDate compare:date] == NSOrderedDescending){
-            minDate = date;
-        }
-    }
-    return minDate;
+    [self dropStaleEntriesFromTop];
+    return self.heap.firstObject.timeout;
 }
 
 - (NSSet *)userIDsInConversation:(ZMConversation *)conversation
 {
-    NSArray *userIDs = [self.timeouts.allKeys mapWithBlock:^id(ZMUserAndConversationKey *key) {
-        return ([key.conversationObjectID isEqual:conversation.objectID] ? key.userObjectID : nil);
-    }];
-    return [NSSet setWithArray:userIDs];
+    NSDictionary *entriesByUser = self.entriesByConversation[conversation.objectID];
+    return (entriesByUser == nil) ? [NSSet set] : [NSSet setWithArray:entriesByUser.allKeys];
 }
 
 - (NSSet *)pruneConversationsThatHaveTimedOutAfter:(NSDate *)pruneDate;
 {
     NSMutableSet *conversations = [NSMutableSet set];
-    NSMutableArray *keysToRemove = [NSMutableArray array];
-    [self.timeouts enumerateKeysAndObjectsUsingBlock:^(ZMUserAndConversationKey *key, NSDate *timeout, BOOL * __unused stop) {
-        if ([timeout compare:pruneDate] == NSOrderedAscending){
-            [conversations addObject:key.conversationObjectID];
-            [keysToRemove addObject:key];
-        }
-    }];
-    for (id key in keysToRemove) {
-        [self.timeouts removeObjectForKey:key];
+    [self dropStaleEntriesFromTop];
+    while (self.heap.count > 0 && [self.heap.firstObject.timeout compare:pruneDate] == NSOrderedAscending) {
+        ZMTypingTimeoutEntry *entry = [self popEntry];
+        [conversations addObject:entry.key.conversationObjectID];
+        [self removeEntryForKey:entry.key];
+        [self dropStaleEntriesFromTop];
     }
     return conversations;
 }
 
+#pragma mark - Heap
+
+- (BOOL)isStale:(ZMTypingTimeoutEntry *)entry
+{
+    return [self entryForKey:entry.key] != entry;
+}
+
+- (void)dropStaleEntriesFromTop
+{
+    while (self.heap.count > 0 && [self isStale:self.heap.firstObject]) {
+        [self popEntry];
+    }
+}
+
+/// Every typing event adds an entry, so rebuild the heap from the live entries once the stale ones dominate
+- (void)compactHeapIfNeeded
+{
+    if (self.heap.count <= 2 * self.count + 16) {
+        return;
+    }
+    [self.heap removeAllObjects];
+    for (NSDictionary *entriesByUser in self.entriesByConversation.objectEnumerator) {
+        for (ZMTypingTimeoutEntry *entry in entriesByUser.objectEnumerator) {
+            [self pushEntry:entry];
+        }
+    }
+}
+
+- (BOOL)entryAtIndex:(NSUInteger)index isBeforeEntryAtIndex:(NSUInteger)otherIndex
+{
+    return [self.heap[index].timeout compare:self.heap[otherIndex].timeout] == NSOrderedAscending;
+}
+
+- (void)pushEntry:(ZMTypingTimeoutEntry *)entry
+{
+    [self.heap addObject:entry];
+    NSUInteger index = self.heap.count - 1;
+    while (index > 0) {
+        NSUInteger const parent = (index - 1) / 2;
+        if (! [self entryAtIndex:index isBeforeEntryAtIndex:parent]) {
+            break;
+        }
+        [self.heap exchangeObjectAtIndex:index withObjectAtIndex:parent];
+        index = parent;
+    }
+}
+
+- (ZMTypingTimeoutEntry *)popEntry
+{
+    ZMTypingTimeoutEntry *top = self.heap.firstObject;
+    ZMTypingTimeoutEntry *last = self.heap.lastObject;
+    [self.heap removeLastObject];
+    if (self.heap.count == 0) {
+        return top;
+    }
+    self.heap[0] = last;
+    NSUInteger index = 0;
+    NSUInteger const count = self.heap.count;
+    while (YES) {
+        NSUInteger const left = 2 * index + 1;
+        NSUInteger const right = left + 1;
+        NSUInteger smallest = index;
+        if (left < count && [self entryAtIndex:left isBeforeEntryAtIndex:smallest]) {
+            smallest = left;
+        }
+        if (right < count && [self entryAtIndex:right isBeforeEntryAtIndex:smallest]) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        [self.heap exchangeObjectAtIndex:index withObjectAtIndex:smallest];
+        index = smallest;
+    }
+    return top;
+}
+
 @end
 
 
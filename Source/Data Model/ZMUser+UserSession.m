@@ -66,8 +66,7 @@
 
 - (ZMAddressBookContact *)contactInUserSession:(ZMUserSession *)userSession
 {
-    ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithUserSession:userSession];
-    return [matcher contactForUser:self];
+    return [userSession.addressBookMatcher contactForUser:self];
 }
 
 @end
\ No newline at end of file
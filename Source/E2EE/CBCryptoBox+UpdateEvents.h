@@ -24,6 +24,38 @@
 
 
 
+/// The outcome of decrypting a single update event
+@interface ZMUpdateEventDecryptionResult : NSObject
+
+- (instancetype)initWithEvent:(ZMUpdateEvent *)event decryptedEvent:(ZMUpdateEvent *)decryptedEvent;
+
+/// The event as it was received
+@property (nonatomic, readonly) ZMUpdateEvent *event;
+/// The decrypted copy of the event, the event itself if it did not need decryption,
+/// or nil if it was not sent to this client or could not be decrypted
+@property (nonatomic, readonly) ZMUpdateEvent *decryptedEvent;
+/// The identifier of the session that was created while decrypting the event, if any
+@property (nonatomic, readonly, copy) NSString *createdSessionIdentifier;
+/// YES if decryption was attempted and failed
+@property (nonatomic, readonly) BOOL failedToDecrypt;
+@property (nonatomic, readonly) NSError *error;
+
+@end
+
+
+
+/// The outcome of decrypting a batch of update events
+@interface ZMUpdateEventsDecryptionBatchResult : NSObject
+
+/// One result per event, in the order the events were passed in
+@property (nonatomic, readonly) NSArray<ZMUpdateEventDecryptionResult *> *results;
+/// The identifiers of the clients for which a session was created while decrypting, by user ID
+@property (nonatomic, readonly) NSDictionary<NSUUID *, NSSet<NSString *> *> *discoveredClientIdentifiersByUserID;
+
+@end
+
+
+
 @interface CBCryptoBox (UpdateEvents)
 
 /// Decrypts an event (if needed) and return a decrypted copy (or the original if no
@@ -31,4 +63,16 @@
 ///
 - (ZMUpdateEvent *)decryptUpdateEventAndAddClient:(ZMUpdateEvent *)event managedObjectContext:(NSManagedObjectContext *)moc;
 
+/// Decrypts the events (if needed) without accessing any managed object context.
+/// The results need to be passed to -processDecryptionResults:managedObjectContext: afterwards.
+/// The box is not thread safe, so this has to be called on the sync context's queue like any other use of the box.
+///
+/// Events are grouped by session. Each session is loaded once, decrypts its events in the order they were passed in,
+/// and is marked to require saving once at the end.
+- (ZMUpdateEventsDecryptionBatchResult *)decryptUpdateEvents:(NSArray<ZMUpdateEvent *> *)events selfClientIdentifier:(NSString *)selfClientIdentifier;
+
+/// Creates the clients that were discovered while decrypting and appends a system message for each event that could not be decrypted.
+/// Returns the decrypted events that need to be processed, in the order of the results.
+- (NSArray<ZMUpdateEvent *> *)processDecryptionResults:(NSArray<ZMUpdateEventDecryptionResult *> *)results managedObjectContext:(NSManagedObjectContext *)moc;
+
 @end
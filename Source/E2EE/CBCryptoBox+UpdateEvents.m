@@ -21,17 +21,60 @@
 @import ZMUtilities;
 
 #import "CBCryptoBox+UpdateEvents.h"
+#import "ZMUpdateEvent+DecryptedData.h"
 #import <zmessaging/zmessaging-Swift.h>
 
 
 NSString * CBErrorCodeToString(CBErrorCode errorCode);
 
+@interface ZMUpdateEventDecryptionResult ()
+
+@property (nonatomic) ZMUpdateEvent *event;
+@property (nonatomic) ZMUpdateEvent *decryptedEvent;
+@property (nonatomic, copy) NSString *createdSessionIdentifier;
+@property (nonatomic) BOOL failedToDecrypt;
+@property (nonatomic) NSError *error;
+
+@end
+
+
+
+@implementation ZMUpdateEventDecryptionResult
+
+- (instancetype)initWithEvent:(ZMUpdateEvent *)event decryptedEvent:(ZMUpdateEvent *)decryptedEvent
+{
+    self = [super init];
+    if (self) {
+        self.event = event;
+        self.decryptedEvent = decryptedEvent;
+    }
+    return self;
+}
+
+@end
+
+
+
+@interface ZMUpdateEventsDecryptionBatchResult ()
+
+@property (nonatomic) NSArray<ZMUpdateEventDecryptionResult *> *results;
+@property (nonatomic) NSDictionary<NSUUID *, NSSet<NSString *> *> *discoveredClientIdentifiersByUserID;
+
+@end
+
+
+
+@implementation ZMUpdateEventsDecryptionBatchResult
+@end
+
+
+
 @implementation CBCryptoBox (UpdateEvents)
 
-- (BOOL)isEvent:(ZMUpdateEvent *)event forSelfClient:(UserClient *)selfClient
+- (BOOL)isEvent:(ZMUpdateEvent *)event forClientWithIdentifier:(NSString *)clientIdentifier
 {
     NSString *recipient = [[event.payload.asDictionary optionalDictionaryForKey:@"data"] optionalStringForKey:@"recipient"];
-    return recipient != nil && [recipient isEqualToString:selfClient.remoteIdentifier];
+    return recipient != nil && [recipient isEqualToString:clientIdentifier];
 }
 
 - (ZMUpdateEvent *)decryptUpdateEventAndAddClient:(ZMUpdateEvent *)event managedObjectContext:(NSManagedObjectContext *)moc
@@ -39,41 +82,169 @@ NSString * CBErrorCodeToString(CBErrorCode errorCode);
     VerifyReturnNil(event != nil);
     
     // check if decrypted already
-    ZMUpdateEvent *decryptedEvent;
     if (event.wasDecrypted) {
         return event;
     }
     
-    // is it for the current client?
     ZMUser *selfUser = [ZMUser selfUserInContext:moc];
-    BOOL checkRecipient = event.type == ZMUpdateEventConversationOtrMessageAdd || event.type == ZMUpdateEventConversationOtrAssetAdd;
-    if(checkRecipient && ![self isEvent:event forSelfClient:selfUser.selfClient]) {
-        return nil;
+    ZMUpdateEventsDecryptionBatchResult *batchResult = [self decryptUpdateEvents:@[event] selfClientIdentifier:selfUser.selfClient.remoteIdentifier];
+    return [self processDecryptionResults:batchResult.results managedObjectContext:moc].firstObject;
+}
+
+- (ZMUpdateEventsDecryptionBatchResult *)decryptUpdateEvents:(NSArray<ZMUpdateEvent *> *)events selfClientIdentifier:(NSString *)selfClientIdentifier
+{
+    NSMutableArray *results = [NSMutableArray arrayWithCapacity:events.count];
+    NSMutableDictionary<NSString *, NSMutableIndexSet *> *indexesBySessionIdentifier = [NSMutableDictionary dictionary];
+    
+    [events enumerateObjectsUsingBlock:^(ZMUpdateEvent *event, NSUInteger idx, BOOL * __unused stop) {
+        ZMUpdateEventDecryptionResult *result = [self resultForEventNotRequiringDecryption:event selfClientIdentifier:selfClientIdentifier];
+        [results addObject:result ?: [NSNull null]];
+        if (result != nil) {
+            return;
+        }
+        
+        // the session is identified by the sender client
+        NSString *sessionIdentifier = [[event.payload.asDictionary optionalDictionaryForKey:@"data"] optionalStringForKey:@"sender"];
+        if (sessionIdentifier == nil) {
+            results[idx] = [self failedResultForEvent:event error:nil];
+            return;
+        }
+        NSMutableIndexSet *indexes = indexesBySessionIdentifier[sessionIdentifier];
+        if (indexes == nil) {
+            indexes = [NSMutableIndexSet indexSet];
+            indexesBySessionIdentifier[sessionIdentifier] = indexes;
+        }
+        [indexes addIndex:idx];
+    }];
+    
+    [indexesBySessionIdentifier enumerateKeysAndObjectsUsingBlock:^(NSString *sessionIdentifier, NSIndexSet *indexes, BOOL * __unused stop) {
+        [self decryptEvents:[events objectsAtIndexes:indexes] sessionIdentifier:sessionIdentifier intoResults:results atIndexes:indexes];
+    }];
+    
+    ZMUpdateEventsDecryptionBatchResult *batchResult = [[ZMUpdateEventsDecryptionBatchResult alloc] init];
+    batchResult.results = results;
+    batchResult.discoveredClientIdentifiersByUserID = [self.class discoveredClientIdentifiersByUserIDFromResults:results];
+    return batchResult;
+}
+
++ (NSDictionary<NSUUID *, NSSet<NSString *> *> *)discoveredClientIdentifiersByUserIDFromResults:(NSArray<ZMUpdateEventDecryptionResult *> *)results
+{
+    NSMutableDictionary<NSUUID *, NSMutableSet<NSString *> *> *discoveredClients = [NSMutableDictionary dictionary];
+    for (ZMUpdateEventDecryptionResult *result in results) {
+        NSUUID *userID = [result.event.payload.asDictionary optionalUuidForKey:@"from"];
+        if (result.createdSessionIdentifier == nil || userID == nil) {
+            continue;
+        }
+        NSMutableSet *clientIdentifiers = discoveredClients[userID];
+        if (clientIdentifiers == nil) {
+            clientIdentifiers = [NSMutableSet set];
+            discoveredClients[userID] = clientIdentifiers;
+        }
+        [clientIdentifiers addObject:result.createdSessionIdentifier];
+    }
+    return discoveredClients;
+}
+
+/// Returns the result for events that can not or do not need to be decrypted, or nil if the event needs to be decrypted
+- (ZMUpdateEventDecryptionResult *)resultForEventNotRequiringDecryption:(ZMUpdateEvent *)event selfClientIdentifier:(NSString *)selfClientIdentifier
+{
+    // check if decrypted already
+    if (event.wasDecrypted) {
+        return [[ZMUpdateEventDecryptionResult alloc] initWithEvent:event decryptedEvent:event];
     }
     
-    // decrypt
-    NSString *newSessionId;
-    NSError *error = nil;
-    if (event.type == ZMUpdateEventConversationOtrMessageAdd) {
-        decryptedEvent = [self decryptOTRClientMessageUpdateEvent:event newSessionId:&newSessionId error:&error];
-    } else if (event.type == ZMUpdateEventConversationOtrAssetAdd) {
-        decryptedEvent = [self decryptOTRAssetUpdateEvent:event newSessionId:&newSessionId error:&error];
-    } else {
-        return event;
+    if (event.type != ZMUpdateEventConversationOtrMessageAdd && event.type != ZMUpdateEventConversationOtrAssetAdd) {
+        return [[ZMUpdateEventDecryptionResult alloc] initWithEvent:event decryptedEvent:event];
     }
     
-    // new client discovered?
-    if (newSessionId != nil) {
-        NSUUID *userID = [event.payload.asDictionary optionalUuidForKey:@"from"];
-        [self didDiscoverNewClientWithSessionId:newSessionId senderId:userID moc:moc];
+    // is it for the current client?
+    if (![self isEvent:event forClientWithIdentifier:selfClientIdentifier]) {
+        return [[ZMUpdateEventDecryptionResult alloc] initWithEvent:event decryptedEvent:nil];
+    }
+    return nil;
+}
+
+- (ZMUpdateEventDecryptionResult *)failedResultForEvent:(ZMUpdateEvent *)event error:(NSError *)error
+{
+    ZMUpdateEventDecryptionResult *result = [[ZMUpdateEventDecryptionResult alloc] initWithEvent:event decryptedEvent:nil];
+    result.failedToDecrypt = YES;
+    result.error = error;
+    return result;
+}
+
+/// Decrypts the events of one session in order. The session is loaded once and marked to require saving at the end.
+- (void)decryptEvents:(NSArray<ZMUpdateEvent *> *)events
+    sessionIdentifier:(NSString *)sessionIdentifier
+          intoResults:(NSMutableArray *)results
+            atIndexes:(NSIndexSet *)indexes
+{
+    __block CBSession *session = [self sessionById:sessionIdentifier error:NULL];
+    __block NSUInteger eventIndex = 0;
+    
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger resultIndex, BOOL * __unused stop) {
+        ZMUpdateEvent *event = events[eventIndex++];
+        NSData *encryptedData = [self encryptedDataForEvent:event];
+        NSData *decryptedData;
+        NSError *error;
+        BOOL createdSession = NO;
+        
+        if (encryptedData != nil && session != nil) {
+            decryptedData = [session decrypt:encryptedData error:&error];
+        }
+        else if (encryptedData != nil) {
+            //if we don't have session with sender yet we create it
+            CBSessionMessage *sessionMessage = [self sessionMessageWithId:sessionIdentifier fromMessage:encryptedData error:&error];
+            if (sessionMessage.session != nil) {
+                session = sessionMessage.session;
+                decryptedData = sessionMessage.data;
+                createdSession = YES;
+            }
+        }
+        
+        ZMUpdateEvent *decryptedEvent;
+        if (decryptedData != nil) {
+            decryptedEvent = [self decryptedUpdateEventFromEvent:event decryptedData:decryptedData];
+        }
+        else if (encryptedData != nil) {
+            ZMLogError(@"Failed to decrypt message <%@>: %@, update Event: %@", CBErrorCodeToString(error.code), error, event.debugInformation);
+        }
+        
+        ZMUpdateEventDecryptionResult *result = [[ZMUpdateEventDecryptionResult alloc] initWithEvent:event decryptedEvent:decryptedEvent];
+        result.createdSessionIdentifier = createdSession ? sessionIdentifier : nil;
+        result.failedToDecrypt = (decryptedEvent == nil);
+        result.error = error;
+        results[resultIndex] = result;
+    }];
+    
+    if (session != nil) {
+        [self setSessionToRequireSave:session];
     }
+}
+
+- (NSArray<ZMUpdateEvent *> *)processDecryptionResults:(NSArray<ZMUpdateEventDecryptionResult *> *)results managedObjectContext:(NSManagedObjectContext *)moc
+{
+    // new clients discovered?
+    [self didDiscoverNewClientsWithIdentifiersByUserID:[self.class discoveredClientIdentifiersByUserIDFromResults:results] moc:moc];
     
-    // failure?
-    if (decryptedEvent == nil) {
-        [self appendFailedToDecryptMessageForEvent:event error:error managedObjectContext:moc];
+    NSMutableArray *decryptedEvents = [NSMutableArray arrayWithCapacity:results.count];
+    for (ZMUpdateEventDecryptionResult *result in results) {
+        ZMUpdateEvent *event = result.event;
+        ZMUpdateEvent *decryptedEvent = result.decryptedEvent;
+        if (decryptedEvent == event) {
+            [decryptedEvents addObject:event];
+            continue;
+        }
+        
+        // failure?
+        if (result.failedToDecrypt) {
+            [self appendFailedToDecryptMessageForEvent:event error:result.error managedObjectContext:moc];
+        }
+        if (decryptedEvent != nil) {
+            [decryptedEvent appendDebugInformation:event.debugInformation];
+            [decryptedEvents addObject:decryptedEvent];
+        }
     }
-    [decryptedEvent appendDebugInformation:event.debugInformation];
-    return decryptedEvent;
+    return decryptedEvents;
 }
 
 /// Appends a system message for a failed decryption
@@ -109,112 +280,85 @@ NSString * CBErrorCodeToString(CBErrorCode errorCode);
     [[NSNotificationCenter defaultCenter] postNotificationName:ZMConversationFailedToDecryptMessageNotificationName object:self userInfo:userInfoDictionary];
 }
 
-- (ZMUpdateEvent *)decryptOTRClientMessageUpdateEvent:(ZMUpdateEvent *)event newSessionId:(NSString *__autoreleasing *)newSessionId error:(NSError **)error
-{
-    NSData *decryptedData = [self decryptOTRMessageUpdateEvent:event valueForKey:@"text" newSessionId:newSessionId error:error];
-    VerifyReturnNil(decryptedData != nil);
-
-    NSMutableDictionary *payload = [event.payload.asDictionary mutableCopy];
-    
-    NSDictionary *eventData = [event.payload.asDictionary optionalDictionaryForKey:@"data"];
-    if ([eventData.allKeys containsObject:@"data"]) {
-        NSString *inlineData = [eventData optionalStringForKey:@"data"];
-        VerifyReturnNil(nil != inlineData);
-        payload[@"external"] = inlineData;
-    }
-
-    payload[@"data"] = decryptedData.base64String;
-
-    return [ZMUpdateEvent decryptedUpdateEventFromEventStreamPayload:payload uuid:event.uuid source:event.source];
-}
-
-- (ZMUpdateEvent *)decryptOTRAssetUpdateEvent:(ZMUpdateEvent *)event newSessionId:(NSString *__autoreleasing *)newSessionId error:(NSError **)error
-{
-    NSData *decryptedData = [self decryptOTRMessageUpdateEvent:event valueForKey:@"key" newSessionId:newSessionId error:error];
-    VerifyReturnNil(decryptedData != nil);
-
-    NSMutableDictionary *payload = [event.payload.asDictionary mutableCopy];
-    NSMutableDictionary *eventData = [[event.payload.asDictionary optionalDictionaryForKey:@"data"] mutableCopy];
-    eventData[@"info"] = [decryptedData base64EncodedStringWithOptions:0];
-    payload[@"data"] = eventData;
-
-    return [ZMUpdateEvent decryptedUpdateEventFromEventStreamPayload:payload uuid:event.uuid source:event.source];
-}
-
-- (NSData *)decryptOTRMessageUpdateEvent:(ZMUpdateEvent *)event valueForKey:(NSString *)dataKey newSessionId:(NSString *__autoreleasing *)newSessionId error:(NSError **)error
+- (NSData *)encryptedDataForEvent:(ZMUpdateEvent *)event
 {
-    NSDictionary *eventData = [event.payload.asDictionary optionalDictionaryForKey:@"data"];
-    NSString *senderClientId = [eventData optionalStringForKey:@"sender"];
-    NSString *dataString = [eventData optionalStringForKey:dataKey];
+    NSString *dataKey = event.type == ZMUpdateEventConversationOtrAssetAdd ? @"key" : @"text";
+    NSString *dataString = [[event.payload.asDictionary optionalDictionaryForKey:@"data"] optionalStringForKey:dataKey];
     VerifyReturnNil(dataString != nil);
-
+    
     if([dataString isEqualToString:[ZMFailedToCreateEncryptedMessagePayloadString dataUsingEncoding:NSUTF8StringEncoding].base64String]) {
         ZMLogError(@"Received a message with a \"failed to encrypt for your client\" special payload. Current device might have invalid prekeys on the BE.");
         return nil;
     }
     NSData *data = [[NSData alloc] initWithBase64EncodedString:dataString options:0];
-    
-    
-    VerifyReturnNil(senderClientId != nil);
     VerifyReturnNil(data != nil);
-    
-    NSData *decryptedData;
-    BOOL createdNewSession = [self decryptedMessageDataFromData:data sessionId:senderClientId decryptedData:&decryptedData error:error];
-    
-    if (createdNewSession) {
-        *newSessionId = senderClientId;
-    }
-    
-    if (nil == decryptedData) {
-        ZMLogError(@"Failed to decrypt message <%@>: %@, update Event: %@", CBErrorCodeToString((*error).code), *error, event.debugInformation);
-    }
-    
-    return decryptedData;
+    return data;
 }
 
-- (BOOL)decryptedMessageDataFromData:(NSData *)data sessionId:(NSString *)sessionId decryptedData:(NSData **)decryptedData error:(NSError **)error
+- (ZMUpdateEvent *)decryptedUpdateEventFromEvent:(ZMUpdateEvent *)event decryptedData:(NSData *)decryptedData
 {
-    BOOL createdNewSession;
+    NSMutableDictionary *payload = [event.payload.asDictionary mutableCopy];
+    NSDictionary *eventData = [event.payload.asDictionary optionalDictionaryForKey:@"data"];
     
-    //If we already have session with sender then we use it to decrypt message
-    CBSession *session = [self sessionById:sessionId error:error];
-    if (session != nil) {
-        *decryptedData = [session decrypt:data error:error];
-        createdNewSession = NO;
+    if (event.type == ZMUpdateEventConversationOtrAssetAdd) {
+        NSMutableDictionary *assetData = [eventData mutableCopy];
+        assetData[@"info"] = [decryptedData base64EncodedStringWithOptions:0];
+        payload[@"data"] = assetData;
     }
     else {
-        //if we don't have session with sender yet we create it
-        CBSessionMessage *sessionMessage = [self sessionMessageWithId:sessionId fromMessage:data error:error];
-        
-        VerifyReturnValue(sessionMessage != nil, NO);
-        VerifyReturnValue(sessionMessage.session != nil, NO);
-        
-        *decryptedData = sessionMessage.data;
-        createdNewSession = YES;
-        session = sessionMessage.session;
+        if ([eventData.allKeys containsObject:@"data"]) {
+            NSString *inlineData = [eventData optionalStringForKey:@"data"];
+            VerifyReturnNil(nil != inlineData);
+            payload[@"external"] = inlineData;
+        }
+        payload[@"data"] = decryptedData.base64String;
     }
-    [self setSessionToRequireSave:session];
     
-    return createdNewSession;
+    ZMUpdateEvent *decryptedEvent = [ZMUpdateEvent decryptedUpdateEventFromEventStreamPayload:payload uuid:event.uuid source:event.source];
+    [decryptedEvent zm_setDecryptedData:decryptedData];
+    return decryptedEvent;
 }
 
-- (UserClient *)didDiscoverNewClientWithSessionId:(NSString *)sessionId senderId:(NSUUID *)senderUserId moc:(NSManagedObjectContext *)moc {
+/// Creates the users and clients for sessions that were created while decrypting, fetching all senders at once
+- (NSSet<UserClient *> *)didDiscoverNewClientsWithIdentifiersByUserID:(NSDictionary<NSUUID *, NSSet<NSString *> *> *)clientIdentifiersByUserID moc:(NSManagedObjectContext *)moc
+{
+    if (clientIdentifiersByUserID.count == 0) {
+        return [NSSet set];
+    }
     
-    if (sessionId != nil && senderUserId != nil) {
-        ZMUser *selfUser = [ZMUser selfUserInContext:moc];
-        [selfUser.selfClient decrementNumberOfRemainingKeys];
-        
+    ZMUser *selfUser = [ZMUser selfUserInContext:moc];
+    
+    NSArray *userIDData = [clientIdentifiersByUserID.allKeys mapWithBlock:^id(NSUUID *userID) {
+        return userID.data;
+    }];
+    NSFetchRequest *request = [ZMUser sortedFetchRequestWithPredicateFormat:@"remoteIdentifier_data IN %@", userIDData];
+    request.relationshipKeyPathsForPrefetching = @[@"clients"];
+    NSMutableDictionary<NSUUID *, ZMUser *> *usersByID = [NSMutableDictionary dictionary];
+    for (ZMUser *user in [moc executeFetchRequestOrAssert:request]) {
+        if (user.remoteIdentifier != nil) {
+            usersByID[user.remoteIdentifier] = user;
+        }
+    }
+    
+    NSMutableSet<UserClient *> *newClients = [NSMutableSet set];
+    [clientIdentifiersByUserID enumerateKeysAndObjectsUsingBlock:^(NSUUID *userID, NSSet<NSString *> *clientIdentifiers, BOOL * __unused stop) {
         //create user+client and do not trust it
         //user probably will be already created due to preceding member-join event
         //but client will be created only when message from this client is received
-        ZMUser *user = [ZMUser userWithRemoteID:senderUserId createIfNeeded:YES inContext:moc];
-        if (user != nil) {
-            UserClient *newClient = [UserClient fetchUserClientWithRemoteId:sessionId forUser:user createIfNeeded:YES];
-            [selfUser.selfClient addNewClientsToIgnored:[NSSet setWithObject:newClient] causedBy:nil];
-            return newClient;
+        ZMUser *user = usersByID[userID] ?: [ZMUser userWithRemoteID:userID createIfNeeded:YES inContext:moc];
+        for (NSString *clientIdentifier in clientIdentifiers) {
+            [selfUser.selfClient decrementNumberOfRemainingKeys];
+            UserClient *newClient = [UserClient fetchUserClientWithRemoteId:clientIdentifier forUser:user createIfNeeded:YES];
+            if (newClient != nil) {
+                [newClients addObject:newClient];
+            }
         }
+    }];
+    
+    if (newClients.count > 0) {
+        [selfUser.selfClient addNewClientsToIgnored:newClients causedBy:nil];
     }
-    return nil;
+    return newClients;
 }
 
 @end
@@ -0,0 +1,48 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMCDataModel;
+
+@class ZMGenericMessage;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Gives access to the plaintext of events that were decrypted by CBCryptoBox (UpdateEvents).
+///
+/// The decrypted event still carries the plaintext base64 encoded in its payload for ZMCDataModel,
+/// but consumers in this framework should use these accessors, which avoid decoding it again.
+@interface ZMUpdateEvent (DecryptedData)
+
+/// The plaintext as it came out of the cryptobox, i.e. the serialized generic message.
+/// nil for events that were not decrypted on this device.
+@property (nonatomic, readonly, nullable) NSData *zm_decryptedData;
+
+/// The external blob of an OTR message that is too large to be sent inline, if any.
+@property (nonatomic, readonly, nullable) NSData *zm_externalData;
+
+/// Returns the generic message of an OTR event. The message is parsed from @c zm_decryptedData if available and cached.
+/// Falls back to +[ZMGenericMessage genericMessageFromUpdateEvent:] for external messages and events without decrypted data.
+- (nullable ZMGenericMessage *)zm_genericMessage;
+
+/// Called by CBCryptoBox (UpdateEvents) after decrypting an event
+- (void)zm_setDecryptedData:(NSData *)decryptedData;
+
+@end
+
+NS_ASSUME_NONNULL_END
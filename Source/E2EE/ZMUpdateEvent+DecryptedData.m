@@ -0,0 +1,90 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMCSystem;
+@import ZMProtos;
+@import ZMUtilities;
+@import ZMCDataModel;
+#import <objc/runtime.h>
+
+#import "ZMUpdateEvent+DecryptedData.h"
+
+
+static char const DecryptedDataKey;
+static char const ExternalDataKey;
+static char const GenericMessageKey;
+
+
+
+@implementation ZMUpdateEvent (DecryptedData)
+
+- (NSData *)zm_decryptedData
+{
+    return objc_getAssociatedObject(self, &DecryptedDataKey);
+}
+
+- (void)zm_setDecryptedData:(NSData *)decryptedData
+{
+    objc_setAssociatedObject(self, &DecryptedDataKey, decryptedData, OBJC_ASSOCIATION_RETAIN);
+}
+
+- (NSData *)zm_externalData
+{
+    NSData *externalData = objc_getAssociatedObject(self, &ExternalDataKey);
+    if (externalData == nil) {
+        NSString *externalString = [self.payload.asDictionary optionalStringForKey:@"external"];
+        if (externalString == nil) {
+            return nil;
+        }
+        externalData = [[NSData alloc] initWithBase64EncodedString:externalString options:0];
+        objc_setAssociatedObject(self, &ExternalDataKey, externalData, OBJC_ASSOCIATION_RETAIN);
+    }
+    return externalData;
+}
+
+- (ZMGenericMessage *)zm_genericMessage
+{
+    ZMGenericMessage *message = objc_getAssociatedObject(self, &GenericMessageKey);
+    if (message != nil) {
+        return message;
+    }
+    
+    NSData *decryptedData = self.zm_decryptedData;
+    if (decryptedData != nil) {
+        @try {
+            message = [ZMGenericMessage parseFromData:decryptedData];
+        }
+        @catch (NSException *exception) {
+            ZMLogError(@"Cannot parse generic message from decrypted event %@: %@", self.uuid, exception);
+            return nil;
+        }
+    }
+    
+    // External messages only carry the key of the actual message, ZMCDataModel knows how to decrypt the blob
+    if (message == nil || message.hasExternal) {
+        message = [ZMGenericMessage genericMessageFromUpdateEvent:self];
+    }
+    
+    if (message != nil) {
+        objc_setAssociatedObject(self, &GenericMessageKey, message, OBJC_ASSOCIATION_RETAIN);
+    }
+    return message;
+}
+
+@end
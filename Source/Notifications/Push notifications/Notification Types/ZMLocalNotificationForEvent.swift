@@ -241,6 +241,8 @@ public class ZMLocalNotificationForEvent : ZMLocalNotification {
     var ignoresSilencedState : Bool { return false }
     /// if true, it will create a ZMLocalNotification but no UILocalNotification for this event, this will be true in most cases
     var shouldCreateNoficiationForLastEvent : Bool { return true }
+    /// if true, the dispatcher never cancels this notification to make room for newer notifications of the same conversation
+    public var isExemptFromConversationLimit : Bool { return false }
 
     /// if empty, it does not copy events
     var copiedEventTypes : [ZMUpdateEventType] { return [] }
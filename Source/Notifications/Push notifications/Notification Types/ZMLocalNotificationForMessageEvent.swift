@@ -37,21 +37,6 @@ public class ZMLocalNotificationForPostInConversationEvent : ZMLocalNotification
     override var requiresConversation : Bool {
         return true
     }
-    
-    var encryptedEventData : String? {
-        guard let payload = lastEvent.payload as? [String : AnyObject]
-        else { return nil }
-        
-        if let data = payload["data"] {
-            if let data = data as? String {
-                return data
-            }
-            if let data = data["info"] as? String {
-                return data
-            }
-        }
-        return nil
-    }
 }
 
 
@@ -76,11 +61,9 @@ public class ZMLocalNotificationForMessage: ZMLocalNotificationForPostInConversa
         
         switch lastEvent.type {
         case .ConversationOtrAssetAdd, .ConversationOtrMessageAdd:
-            guard let encryptedEventData = encryptedEventData else { return false }
-            
             var genericMessage : ZMGenericMessage?
             let exception = zm_tryBlock {
-                genericMessage = ZMGenericMessage(base64String: encryptedEventData)
+                genericMessage = self.lastEvent.zm_genericMessage()
             }
   
             guard exception == nil, let message = genericMessage
@@ -195,11 +178,9 @@ public class ZMLocalNotificationForKnockMessage : ZMLocalNotificationForPostInCo
         
         switch lastEvent.type {
         case .ConversationOtrMessageAdd:
-            guard let encryptedEventData = encryptedEventData else { return false }
-            
             var genericMessage : ZMGenericMessage?
             let exception = zm_tryBlock{
-                genericMessage = ZMGenericMessage(base64String: encryptedEventData)
+                genericMessage = self.lastEvent.zm_genericMessage()
             }
             
             guard exception == nil,
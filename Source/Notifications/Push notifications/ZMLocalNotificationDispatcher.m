@@ -31,12 +31,48 @@
 NSString * ZMLocalNotificationDispatcherUIApplicationClass = @"UIApplication";
 NSString * const ZMConversationCancelNotificationForIncomingCallNotificationName = @"ZMConversationCancelNotificationForIncomingCallNotification";
 
+/// When a conversation has more notifications than this, the oldest ones are cancelled.
+/// Message notifications are already bundled into a single "N new messages" notification by ZMLocalNotificationForMessage.
+/// Notifications that are exempt from the limit (calls and connection requests) are never cancelled for it, and don't count towards it.
+static NSUInteger const MaximumNumberOfEventNotificationsPerConversation = 5;
+
+
+
+/// The event notifications of one conversation, in the order they were created, and the nonces of the events they were created for
+@interface ZMConversationEventNotifications : NSObject
+
+@property (nonatomic, readonly) NSMutableArray<ZMLocalNotificationForEvent *> *notifications;
+@property (nonatomic, readonly) NSMutableSet<NSUUID *> *messageNonces;
+
+@end
+
+
+
+@implementation ZMConversationEventNotifications
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _notifications = [NSMutableArray array];
+        _messageNonces = [NSMutableSet set];
+    }
+    return self;
+}
+
+@end
+
+
 
 @interface ZMLocalNotificationDispatcher ()
 
 @property (nonatomic) NSManagedObjectContext *syncMOC;
-@property (nonatomic) NSArray *eventsNotifications;
+@property (nonatomic) NSMutableOrderedSet<ZMLocalNotificationForEvent *> *scheduledEventNotifications;
+@property (nonatomic) NSMutableDictionary<NSUUID *, ZMConversationEventNotifications *> *eventNotificationsByConversationID;
+/// Notifications for events without a conversation ID, e.g. contacts joining. They don't belong to a conversation and are not limited in number.
+@property (nonatomic) ZMConversationEventNotifications *eventNotificationsWithoutConversationID;
 @property (nonatomic) NSMutableSet *failedMessageNotifications;
+@property (nonatomic) NSMapTable *failedMessageNotificationsByConversation;
 @property (nonatomic) BOOL isTornDown;
 @property (nonatomic) ZMApplication *sharedApplication;
 
@@ -54,8 +90,11 @@ ZM_EMPTY_ASSERTING_INIT();
     self = [super init];
     if (self) {
         self.syncMOC = moc;
-        self.eventsNotifications = [NSArray array];
+        self.scheduledEventNotifications = [NSMutableOrderedSet orderedSet];
+        self.eventNotificationsByConversationID = [NSMutableDictionary dictionary];
+        self.eventNotificationsWithoutConversationID = [[ZMConversationEventNotifications alloc] init];
         self.failedMessageNotifications = [NSMutableSet set];
+        self.failedMessageNotificationsByConversation = [NSMapTable strongToStrongObjectsMapTable];
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(cancelNotificationsForNote:) name:ZMConversationDidChangeVisibleWindowNotification object:nil];
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(cancelNotificationForIncomingCallInConversation:) name:ZMConversationCancelNotificationForIncomingCallNotificationName object:nil];
 
@@ -96,39 +135,48 @@ ZM_EMPTY_ASSERTING_INIT();
     }];
 }
 
+- (NSArray *)eventsNotifications
+{
+    return self.scheduledEventNotifications.array;
+}
+
 - (void)cancelAllNotifications
 {
-    for (ZMLocalNotificationForEvent *note in self.eventsNotifications) {
-        for (UILocalNotification *notification in note.notifications) {
-            [self.sharedApplication cancelLocalNotification:notification];
-        }
+    for (ZMLocalNotificationForEvent *note in self.scheduledEventNotifications) {
+        [self cancelUINotificationsOfNotification:note];
     }
     for(ZMLocalNotificationForExpiredMessage *note in self.failedMessageNotifications) {
         [self.sharedApplication cancelLocalNotification:note.uiNotification];
     }
     [self.failedMessageNotifications removeAllObjects];
+    [self.failedMessageNotificationsByConversation removeAllObjects];
     
-    self.eventsNotifications = [NSArray array];
+    [self.scheduledEventNotifications removeAllObjects];
+    [self.eventNotificationsByConversationID removeAllObjects];
+    self.eventNotificationsWithoutConversationID = [[ZMConversationEventNotifications alloc] init];
 }
 
 - (void)cancelNotificationForConversation:(ZMConversation *)conversation
 {
-    NSMutableArray *notifications = [NSMutableArray array];
+    NSUUID *conversationID = conversation.remoteIdentifier;
+    ZMConversationEventNotifications *conversationNotifications = (conversationID != nil) ? self.eventNotificationsByConversationID[conversationID] : nil;
     
-    for (ZMLocalNotificationForEvent *note in self.eventsNotifications) {
-        if (note.conversation == conversation) {
-            for (UILocalNotification *notification in note.notifications) {
-                [self.sharedApplication cancelLocalNotification:notification];
-            }
-        }
-        else {
-            [notifications addObject:note];
-        }
+    for (ZMLocalNotificationForEvent *note in conversationNotifications.notifications) {
+        [self cancelUINotificationsOfNotification:note];
+        [self.scheduledEventNotifications removeObject:note];
+    }
+    if (conversationID != nil) {
+        [self.eventNotificationsByConversationID removeObjectForKey:conversationID];
     }
     
     [self cancelAllMessageFailedNotificationsForConversations:conversation];
-    
-    self.eventsNotifications = notifications;
+}
+
+- (void)cancelUINotificationsOfNotification:(ZMLocalNotificationForEvent *)note
+{
+    for (UILocalNotification *notification in note.notifications) {
+        [self.sharedApplication cancelLocalNotification:notification];
+    }
 }
 
 - (void)didReceiveUpdateEvents:(NSArray <ZMUpdateEvent *>*)events
@@ -153,28 +201,42 @@ ZM_EMPTY_ASSERTING_INIT();
     }
     ZMLocalNotificationForExpiredMessage *note = [[ZMLocalNotificationForExpiredMessage alloc] initWithExpiredMessage:message];
     [self.sharedApplication scheduleLocalNotification:note.uiNotification];
-    [self.failedMessageNotifications addObject:note];
+    [self addFailedMessageNotification:note];
 }
 
 - (void)didFailToSendMessageInConversation:(ZMConversation *)conversation;
 {
     ZMLocalNotificationForExpiredMessage *note = [[ZMLocalNotificationForExpiredMessage alloc] initWithConversation:conversation];
     [self.sharedApplication scheduleLocalNotification:note.uiNotification];
-    [self.failedMessageNotifications addObject:note];
+    [self addFailedMessageNotification:note];
 }
 
+- (void)addFailedMessageNotification:(ZMLocalNotificationForExpiredMessage *)note
+{
+    [self.failedMessageNotifications addObject:note];
+    if (note.conversation == nil) {
+        return;
+    }
+    NSMutableSet *notesForConversation = [self.failedMessageNotificationsByConversation objectForKey:note.conversation];
+    if (notesForConversation == nil) {
+        notesForConversation = [NSMutableSet set];
+        [self.failedMessageNotificationsByConversation setObject:notesForConversation forKey:note.conversation];
+    }
+    [notesForConversation addObject:note];
+}
 
 - (void)cancelAllMessageFailedNotificationsForConversations:(ZMConversation *)conversation;
 {
-    NSMutableSet *toRemove = [NSMutableSet set];
-    for(ZMLocalNotificationForExpiredMessage *note in self.failedMessageNotifications) {
-        if(note.conversation == conversation) {
-            [toRemove addObject:note];
-            [self.sharedApplication cancelLocalNotification:note.uiNotification];
-        }
+    if (conversation == nil) {
+        return;
+    }
+    NSSet *toRemove = [self.failedMessageNotificationsByConversation objectForKey:conversation];
+    for(ZMLocalNotificationForExpiredMessage *note in toRemove) {
+        [self.sharedApplication cancelLocalNotification:note.uiNotification];
     }
     
     [self.failedMessageNotifications minusSet:toRemove];
+    [self.failedMessageNotificationsByConversation removeObjectForKey:conversation];
 }
 
 - (ZMLocalNotificationForEvent *)notificationForEvent:(ZMUpdateEvent *)event
@@ -218,43 +280,95 @@ ZM_EMPTY_ASSERTING_INIT();
 }
 
 
+/// Returns the notifications kept for events with the given conversation ID, creating them if needed.
+/// Events without a conversation ID share one list.
+- (ZMConversationEventNotifications *)eventNotificationsForConversationID:(NSUUID *)conversationID
+{
+    if (conversationID == nil) {
+        return self.eventNotificationsWithoutConversationID;
+    }
+    ZMConversationEventNotifications *conversationNotifications = self.eventNotificationsByConversationID[conversationID];
+    if (conversationNotifications == nil) {
+        conversationNotifications = [[ZMConversationEventNotifications alloc] init];
+        self.eventNotificationsByConversationID[conversationID] = conversationNotifications;
+    }
+    return conversationNotifications;
+}
+
+/// Only the notifications of the event's conversation can contain an identical event or take the event,
+/// so they are the only ones that are looked at.
 - (ZMLocalNotificationForEvent *)localNotificationForEvent:(ZMUpdateEvent *)event
 {
-    __block ZMLocalNotificationForEvent *newNote;
-    __block NSUInteger convIndex;
-    __block BOOL foundIdenticalNotification = NO;
+    NSUUID *conversationID = event.conversationUUID;
+    NSUUID *nonce = event.messageNonce;
+    ZMConversationEventNotifications *conversationNotifications = [self eventNotificationsForConversationID:conversationID];
+    BOOL mightContainIdenticalEvent = (nonce == nil) || [conversationNotifications.messageNonces containsObject:nonce];
+    
+    ZMLocalNotificationForEvent *newNote;
+    NSUInteger replacedIndex = NSNotFound;
     
-    [self.eventsNotifications enumerateObjectsUsingBlock:^(ZMLocalNotificationForEvent *note, NSUInteger idx, BOOL *stop) {
-        if ([note containsIdenticalEvent:event]) {
-            foundIdenticalNotification = YES;
-            *stop = YES;
-            return;
+    for (NSUInteger idx = 0; idx < conversationNotifications.notifications.count; ++idx) {
+        ZMLocalNotificationForEvent *note = conversationNotifications.notifications[idx];
+        if (mightContainIdenticalEvent && [note containsIdenticalEvent:event]) {
+            return nil;
         }
         newNote = [note copyByAddingEvent:event];
         if (newNote != nil) {
-            convIndex = idx;
-            *stop = YES;
+            replacedIndex = idx;
+            break;
         }
-    }];
-    
-    if (foundIdenticalNotification) {
-        return nil;
     }
- 
-    NSMutableArray *notifications = [NSMutableArray arrayWithArray:self.eventsNotifications];
+    if (nonce != nil) {
+        [conversationNotifications.messageNonces addObject:nonce];
+    }
+    
     if (newNote == nil) {
         newNote = [ZMLocalNotificationForEvent notificationForEvent:event managedObjectContext:self.syncMOC application:self.sharedApplication];
         if(newNote == nil) {
             return nil;
         }
-        [notifications addObject:newNote];
+        [self addEventNotification:newNote toConversationNotifications:conversationNotifications limitNumberOfNotifications:(conversationID != nil)];
     }
     else {
-        notifications[convIndex] = newNote;
+        ZMLocalNotificationForEvent *previousNote = conversationNotifications.notifications[replacedIndex];
+        conversationNotifications.notifications[replacedIndex] = newNote;
+        [self.scheduledEventNotifications replaceObjectAtIndex:[self.scheduledEventNotifications indexOfObject:previousNote] withObject:newNote];
     }
-    self.eventsNotifications = [NSArray arrayWithArray:notifications];
 
     return newNote;
 }
 
+- (void)addEventNotification:(ZMLocalNotificationForEvent *)note toConversationNotifications:(ZMConversationEventNotifications *)conversationNotifications limitNumberOfNotifications:(BOOL)limitNumberOfNotifications
+{
+    [self.scheduledEventNotifications addObject:note];
+    [conversationNotifications.notifications addObject:note];
+    if (limitNumberOfNotifications) {
+        [self cancelNotificationsOverLimitInConversationNotifications:conversationNotifications];
+    }
+}
+
+/// Cancels the oldest notifications that are not exempt from the limit, until there are at most MaximumNumberOfEventNotificationsPerConversation of them
+- (void)cancelNotificationsOverLimitInConversationNotifications:(ZMConversationEventNotifications *)conversationNotifications
+{
+    NSIndexSet *limitedIndexes = [conversationNotifications.notifications indexesOfObjectsPassingTest:^BOOL(ZMLocalNotificationForEvent *note, NSUInteger __unused idx, BOOL __unused *stop) {
+        return ! note.isExemptFromConversationLimit;
+    }];
+    if (limitedIndexes.count <= MaximumNumberOfEventNotificationsPerConversation) {
+        return;
+    }
+    
+    NSUInteger numberOfNotificationsToCancel = limitedIndexes.count - MaximumNumberOfEventNotificationsPerConversation;
+    NSMutableIndexSet *indexesToCancel = [NSMutableIndexSet indexSet];
+    [limitedIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+        [indexesToCancel addIndex:idx];
+        *stop = (indexesToCancel.count == numberOfNotificationsToCancel);
+    }];
+    
+    for (ZMLocalNotificationForEvent *note in [conversationNotifications.notifications objectsAtIndexes:indexesToCancel]) {
+        [self cancelUINotificationsOfNotification:note];
+        [self.scheduledEventNotifications removeObject:note];
+    }
+    [conversationNotifications.notifications removeObjectsAtIndexes:indexesToCancel];
+}
+
 @end
@@ -25,6 +25,7 @@ public class ZMLocalNotificationForCallEvent : ZMLocalNotificationForEvent {
     
     override var ignoresSilencedState : Bool { return true }
     override var requiresConversation : Bool { return true }
+    public override var isExemptFromConversationLimit : Bool { return true }
     override var copiedEventTypes : [ZMUpdateEventType] { return [.CallState] }
     let accedptedCallTypes : [ZMCallEventType] = [.IncomingCall, .IncomingVideoCall, .CallEnded, .SelfUserJoined]
     let callStartedTypes : [ZMCallEventType] = [.IncomingCall, .IncomingVideoCall]
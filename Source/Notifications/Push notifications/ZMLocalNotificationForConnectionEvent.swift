@@ -21,6 +21,8 @@ import Foundation
 
 class ZMLocalNotificationForConnectionEvent : ZMLocalNotificationForEvent {
     
+    override var isExemptFromConversationLimit : Bool { return true }
+    
     override func configureAlertBody() -> String {
         let name = eventData["name"] as? String
         return ZMPushStringConnectionRequest.localizedStringWithUserName(name)
@@ -35,6 +37,8 @@ class ZMLocalNotificationForUserConnectionEvent : ZMLocalNotificationForEvent {
     
     var connectionType : ZMLocalNotificationForEventType!
     
+    override var isExemptFromConversationLimit : Bool { return true }
+    
     override func canCreateNotification() -> Bool {
         if !super.canCreateNotification() { return false }
         
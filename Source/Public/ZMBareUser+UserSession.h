@@ -46,6 +46,7 @@
 @interface ZMUser (UserSession) <ZMSearchableUser>
 
 /// Returns the corresponding address book contact if it exists otherwise nil.
+/// The address book is indexed in the background after it is loaded; until then this returns nil.
 - (ZMAddressBookContact *)contactInUserSession:(ZMUserSession *)userSession;
 
 @end
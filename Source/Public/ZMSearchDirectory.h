@@ -51,6 +51,9 @@ typedef id<ZMSearchToken> ZMSearchToken;
 /// The time during which a cached result is returned when searching the same query again. After this time a query triggers a normal search.
 @property (nonatomic) NSTimeInterval updateDelay;
 
+/// How long to hold back the request to the backend when a query replaces one that is still waiting for the backend, e.g. while the user is typing.
+@property (nonatomic) NSTimeInterval remoteSearchDelay;
+
 @property (readonly, nonatomic) NSInteger maxTopConversationsCount;
 
 /// List of current top conversations. If this list updates the ZMSearchTopConversationsObserver will be notified.
@@ -56,6 +56,7 @@
 #import <zmessaging/ZMUserSessionAuthenticationNotification.h>
 #import <zmessaging/ZMSingleRequestSync.h>
 #import <zmessaging/CBCryptoBox+UpdateEvents.h>
+#import <zmessaging/ZMUpdateEvent+DecryptedData.h>
 #import <zmessaging/ZMAPSMessageDecoder.h>
 #import <zmessaging/ZMUpstreamTranscoder.h>
 #import <zmessaging/ZMUpstreamRequest.h>
@@ -26,10 +26,18 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+extern NSUInteger const ZMAddressBookEncoderDefaultMaximumPayloadSize;
+
 @interface ZMAddressBookEncoder : NSObject
 
 - (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc addressBook:(ZMAddressBook * __nullable)addressBook NS_DESIGNATED_INITIALIZER;
 
+/// The approximate maximum size of the encoded contacts in bytes. Contacts beyond it are not encoded.
+/// Defaults to ZMAddressBookEncoderDefaultMaximumPayloadSize.
+@property (nonatomic) NSUInteger maximumPayloadSize;
+
+/// Reads the contacts of the address book in chunks and hashes the contacts of several chunks concurrently.
+/// The cards and the digest are in the order of the address book, so the digest only changes when the address book does.
 - (void)createPayloadWithCompletionHandler:(void(^)(ZMEncodedAddressBook *encoded))completionHandler;
 
 @end
@@ -40,6 +48,9 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, readonly, copy, nullable) id<ZMTransportData> localData;
 @property (nonatomic, readonly, copy, nullable) id<ZMTransportData> otherData;
 @property (nonatomic, readonly, copy, nullable) NSData *digest; ///< A digest of the entire address book
+/// A digest of each card in otherData, in the same order. It is the hash of the card's contact hashes joined together,
+/// so it only depends on the card itself and stays the same when other contacts are added or removed.
+@property (nonatomic, readonly, copy, nullable) NSArray<NSString *> *cardDigests;
 
 @end
 
@@ -26,6 +26,15 @@
 
 static dispatch_queue_t ZMAddressBookIsolationQueue;
 
+NSUInteger const ZMAddressBookEncoderDefaultMaximumPayloadSize = 4 * 1024 * 1024;
+/// Number of contacts hashed together
+static NSUInteger const ContactsPerChunk = 200;
+/// Number of chunks read from the address book before they are hashed concurrently
+static NSUInteger const ChunksPerBatch = 8;
+/// Upper bounds for the size of a card and of a hash in the payload, used to stay within maximumPayloadSize
+static NSUInteger const EstimatedCardSize = 40;
+static NSUInteger const EstimatedHashSize = 48;
+
 @interface NSString (ZMAddressBook)
 
 - (NSString *)addressBookEncoderHash;
@@ -34,10 +43,27 @@ static dispatch_queue_t ZMAddressBookIsolationQueue;
 
 
 
+/// The hashes of a range of contacts, and what they add to the digest
+@interface ZMEncodedAddressBookChunk : NSObject
+
+- (instancetype)initWithContacts:(NSArray<ZMAddressBookContact *> *)contacts;
+
+/// Set to nil once the chunk is encoded
+@property (nonatomic) NSArray<ZMAddressBookContact *> *contacts;
+/// The hashes of each contact that has any
+@property (nonatomic, readonly) NSMutableArray<NSArray<NSString *> *> *cards;
+@property (nonatomic, readonly) NSMutableArray<NSString *> *cardDigests;
+@property (nonatomic, readonly) NSMutableData *digestInput;
+
+@end
+
+
+
 @interface ZMAddressBookEncoder ()
 
 @property (nonatomic) NSManagedObjectContext *managedObjectContext;
 @property (nonatomic) ZMAddressBook *addressBook;
+@property (nonatomic) dispatch_queue_t chunkQueue;
 
 @end
 
@@ -48,16 +74,16 @@ static dispatch_queue_t ZMAddressBookIsolationQueue;
 @property (nonatomic, copy) id<ZMTransportData> localData;
 @property (nonatomic, copy) id<ZMTransportData> otherData;
 @property (nonatomic, copy) NSData *digest;
+@property (nonatomic, copy) NSArray<NSString *> *cardDigests;
 
 @end
 
 
 
-static void updateDigest(CC_SHA512_CTX *ctx, NSString *string)
+static void appendToDigestInput(NSMutableData *digestInput, NSString *string)
 {
     VerifyReturn(string != nil);
-    NSData *input = [string dataUsingEncoding:NSUTF8StringEncoding];
-    CC_SHA512_Update(ctx, input.bytes, (CC_LONG) input.length);
+    [digestInput appendData:[string dataUsingEncoding:NSUTF8StringEncoding]];
 }
 
 
@@ -72,6 +98,8 @@ ZM_EMPTY_ASSERTING_INIT()
     if (self) {
         self.managedObjectContext = moc;
         self.addressBook = addressBook;
+        self.maximumPayloadSize = ZMAddressBookEncoderDefaultMaximumPayloadSize;
+        self.chunkQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
         
         static dispatch_once_t onceToken;
         dispatch_once(&onceToken, ^{
@@ -112,10 +140,9 @@ ZM_EMPTY_ASSERTING_INIT()
         NSString *selfEmail = [selfUser.emailAddress copy];
         NSString *selfPhone = [selfUser.phoneNumber copy];
         ZMAddressBook *addressBook = self.addressBook;
+        NSUInteger maximumPayloadSize = self.maximumPayloadSize;
         [self.managedObjectContext.dispatchGroup asyncOnQueue:ZMAddressBookIsolationQueue block:^{
             ZMEncodedAddressBook *result = [[ZMEncodedAddressBook alloc] init];
-            CC_SHA512_CTX digestContext = {};
-            CC_SHA512_Init(&digestContext);
             {
                 NSMutableSet *selfHashes = [NSMutableSet set];
                 NSString *validatedEmail = [self validatedEmailFromEmail:selfEmail];
@@ -129,46 +156,27 @@ ZM_EMPTY_ASSERTING_INIT()
                 result.localData = selfHashes.allObjects;
             }
             {
+                NSArray<ZMEncodedAddressBookChunk *> *chunks = [self encodedChunksOfAddressBook:addressBook maximumPayloadSize:maximumPayloadSize];
+                
+                // Merging in the order of the chunks keeps the card IDs and the digest the same as when encoding one contact after another
+                CC_SHA512_CTX digestContext = {};
+                CC_SHA512_Init(&digestContext);
                 NSMutableArray *otherHashesCards = [NSMutableArray array];
-                NSUInteger index = 0;
-                for (ZMAddressBookContact *contact in addressBook.contacts) {
-                    if (index > 1000) { // FIXME: right now we upload only top 1000 contacts due to memory / perfor-
-                                        // mance limits
-                        break;
-                    }
-                    
-                    NSMutableOrderedSet *otherHashes = [NSMutableOrderedSet orderedSet];
-                    for (NSString *email in contact.emailAddresses) {
-                        NSString *validatedEmail = [self validatedEmailFromEmail:email];
-                        if (validatedEmail != nil) {
-                            [otherHashes addObject:validatedEmail.addressBookEncoderHash];
-                            updateDigest(&digestContext, validatedEmail);
-                        }
-                    }
-                    for (NSString *phone in contact.phoneNumbers) {
-                        if ((7 < phone.length) && [phone hasPrefix:@"+"]) {
-                            [otherHashes addObject:phone.addressBookEncoderHash];
-                            updateDigest(&digestContext, phone);
-                        }
-                    }
-                    if(otherHashes.count > 0) {
-                        
+                NSMutableArray *cardDigests = [NSMutableArray array];
+                for (ZMEncodedAddressBookChunk *chunk in chunks) {
+                    for (NSArray *hashes in chunk.cards) {
                         NSDictionary *payload = @{
                                                   @"card_id" : [NSString stringWithFormat:@"%lu", (unsigned long) otherHashesCards.count],
-                                                  @"contact" : otherHashes.array
+                                                  @"contact" : hashes
                                                   };
-                        
                         [otherHashesCards addObject:payload];
-                        int32_t numberOfHashes = (int32_t) otherHashes.count;
-                        // add number of digests in contact to hash
-                        CC_SHA512_Update(&digestContext, &numberOfHashes, sizeof(numberOfHashes));
                     }
-                    
-                    index++;
+                    [cardDigests addObjectsFromArray:chunk.cardDigests];
+                    CC_SHA512_Update(&digestContext, chunk.digestInput.bytes, (CC_LONG) chunk.digestInput.length);
                 }
                 result.otherData = (otherHashesCards.count < 1) ? nil : otherHashesCards;
-            }
-            {
+                result.cardDigests = cardDigests;
+                
                 NSMutableData *digest = [NSMutableData dataWithLength:CC_SHA512_DIGEST_LENGTH];
                 CC_SHA512_Final((unsigned char *) digest.mutableBytes, &digestContext);
                 result.digest = digest;
@@ -179,6 +187,79 @@ ZM_EMPTY_ASSERTING_INIT()
     
 }
 
+/// Reads the contacts in chunks until the estimated payload size reaches the maximum.
+/// A batch of chunks is hashed concurrently before the next one is read, so that only a few chunks of contacts are in memory at a time.
+- (NSArray<ZMEncodedAddressBookChunk *> *)encodedChunksOfAddressBook:(ZMAddressBook *)addressBook maximumPayloadSize:(NSUInteger)maximumPayloadSize
+{
+    NSMutableArray<ZMEncodedAddressBookChunk *> *encodedChunks = [NSMutableArray array];
+    NSMutableArray<ZMEncodedAddressBookChunk *> *batch = [NSMutableArray array];
+    NSMutableArray<ZMAddressBookContact *> *contacts = [NSMutableArray array];
+    NSUInteger estimatedPayloadSize = 0;
+    
+    for (ZMAddressBookContact *contact in addressBook.contacts) {
+        estimatedPayloadSize += EstimatedCardSize + EstimatedHashSize * (contact.emailAddresses.count + contact.phoneNumbers.count);
+        if (estimatedPayloadSize > maximumPayloadSize) {
+            break;
+        }
+        
+        [contacts addObject:contact];
+        if (contacts.count == ContactsPerChunk) {
+            [batch addObject:[[ZMEncodedAddressBookChunk alloc] initWithContacts:contacts]];
+            contacts = [NSMutableArray array];
+        }
+        if (batch.count == ChunksPerBatch) {
+            [self encodeChunks:batch];
+            [encodedChunks addObjectsFromArray:batch];
+            [batch removeAllObjects];
+        }
+    }
+    
+    if (contacts.count > 0) {
+        [batch addObject:[[ZMEncodedAddressBookChunk alloc] initWithContacts:contacts]];
+    }
+    [self encodeChunks:batch];
+    [encodedChunks addObjectsFromArray:batch];
+    return encodedChunks;
+}
+
+- (void)encodeChunks:(NSArray<ZMEncodedAddressBookChunk *> *)chunks
+{
+    // Each iteration only modifies its own chunk
+    dispatch_apply(chunks.count, self.chunkQueue, ^(size_t chunkIndex) {
+        @autoreleasepool {
+            [self encodeChunk:chunks[chunkIndex]];
+        }
+    });
+}
+
+- (void)encodeChunk:(ZMEncodedAddressBookChunk *)chunk
+{
+    for (ZMAddressBookContact *contact in chunk.contacts) {
+        NSMutableOrderedSet *otherHashes = [NSMutableOrderedSet orderedSet];
+        for (NSString *email in contact.emailAddresses) {
+            NSString *validatedEmail = [self validatedEmailFromEmail:email];
+            if (validatedEmail != nil) {
+                [otherHashes addObject:validatedEmail.addressBookEncoderHash];
+                appendToDigestInput(chunk.digestInput, validatedEmail);
+            }
+        }
+        for (NSString *phone in contact.phoneNumbers) {
+            if ((7 < phone.length) && [phone hasPrefix:@"+"]) {
+                [otherHashes addObject:phone.addressBookEncoderHash];
+                appendToDigestInput(chunk.digestInput, phone);
+            }
+        }
+        if(otherHashes.count > 0) {
+            [chunk.cards addObject:otherHashes.array];
+            [chunk.cardDigests addObject:[otherHashes.array componentsJoinedByString:@""].addressBookEncoderHash];
+            int32_t numberOfHashes = (int32_t) otherHashes.count;
+            // add number of digests in contact to hash
+            [chunk.digestInput appendBytes:&numberOfHashes length:sizeof(numberOfHashes)];
+        }
+    }
+    chunk.contacts = nil;
+}
+
 @end
 
 
@@ -197,6 +278,24 @@ ZM_EMPTY_ASSERTING_INIT()
 
 
 
+@implementation ZMEncodedAddressBookChunk
+
+- (instancetype)initWithContacts:(NSArray<ZMAddressBookContact *> *)contacts
+{
+    self = [super init];
+    if (self) {
+        _contacts = [contacts copy];
+        _cards = [NSMutableArray array];
+        _cardDigests = [NSMutableArray array];
+        _digestInput = [NSMutableData data];
+    }
+    return self;
+}
+
+@end
+
+
+
 @implementation ZMEncodedAddressBook
 
 - (NSString *)description;
@@ -376,47 +376,6 @@ public class UserClientRequestStrategy: ZMObjectSyncStrategy, ZMObjectStrategy,
         return false
     }
     
-    /// Make sure that we don't block messages or continue requesting messages for a client that can not be fetched
-    private func clearMissingMessagesBecauseClientCanNotBeFeched(client: UserClient, selfClient: UserClient) {
-        client.failedToEstablishSession = true
-        cleanMessagesMissingRecipient(client)
-        selfClient.removeMissingClient(client)
-    }
-
-    /** 
-    Creates session and update missing clients and messages that depend on those clients
-    */
-    private func establishSessionAndUpdateMissingClients(clientId: String,
-        prekeyString: String,
-        selfClient: UserClient,
-        missingClient: UserClient?) {
-            guard let missingClient = missingClient else { return }
-            
-            let sessionCreated = selfClient.establishSessionWithClient(missingClient, usingPreKey: prekeyString)
-            // If the session creation failed, the client probably has corrupted prekeys,
-            // we mark the client in order to send him a bogus message and not block all requests
-            missingClient.failedToEstablishSession = !sessionCreated
-            
-            cleanMessagesMissingRecipient(missingClient)
-            selfClient.removeMissingClient(missingClient)
-    }
-    
-    /// Process a client entry in a response to a missed clients (prekeys) request
-    private func processPrekeyEntry(clientId: String, prekeyData: Any?, selfClient: UserClient, missingClient: UserClient) {
-        if let prekeyDictionary = prekeyData as? [String : AnyObject],
-            let prekeyString = prekeyDictionary["key"] as? String
-        {
-            self.establishSessionAndUpdateMissingClients(
-                clientId,
-                prekeyString: prekeyString,
-                selfClient: selfClient,
-                missingClient:missingClient)
-        }
-        else {
-            self.clearMissingMessagesBecauseClientCanNotBeFeched(missingClient, selfClient: selfClient)
-        }
-    }
-    
     /// - returns: a lookup table for missing client by remote client ID
     private func missingUserClientIdToUserClientMap(selfClient: UserClient) -> [String : UserClient] {
         var missedClientIdsToClientsMap = [String : UserClient]()
@@ -472,6 +431,10 @@ public class UserClientRequestStrategy: ZMObjectSyncStrategy, ZMObjectStrategy,
         })
         let originalRemainingClientsCount = remainingClientsIds.count
             
+        /// prekeys of the clients we can establish a session with, and clients that can not be fetched
+        var preKeysByClient = [UserClient : String]()
+        var clientsWithoutPreKey = Set<UserClient>()
+        
         /// for each user ID
         for (userIdString, clients) in dictionary {
             guard let _ = NSUUID.uuidWithTransportString(userIdString) else {
@@ -488,7 +451,14 @@ public class UserClientRequestStrategy: ZMObjectSyncStrategy, ZMObjectStrategy,
                     /// maybe a previous request solved it, or it was deleted by a push, or...
                     continue
                 }
-                self.processPrekeyEntry(clientId, prekeyData: prekeyData, selfClient: selfClient, missingClient: missedClient)
+                if let prekeyDictionary = prekeyData as? [String : AnyObject],
+                    let prekeyString = prekeyDictionary["key"] as? String
+                {
+                    preKeysByClient[missedClient] = prekeyString
+                }
+                else {
+                    clientsWithoutPreKey.insert(missedClient)
+                }
             }
         }
         
@@ -499,10 +469,23 @@ public class UserClientRequestStrategy: ZMObjectSyncStrategy, ZMObjectStrategy,
         if remainingClientsCountDidNotChange {
             for clientId in remainingClientsIds {
                 if let client = missedClientLookupByRemoteIdentifier[clientId] {
-                    self.clearMissingMessagesBecauseClientCanNotBeFeched(client, selfClient: selfClient)
+                    clientsWithoutPreKey.insert(client)
                 }
             }
         }
+        
+        // If the session creation failed, the client probably has corrupted prekeys,
+        // we mark the client in order to send him a bogus message and not block all requests.
+        // Same for clients that can not be fetched, so that we don't block messages or continue requesting them.
+        let failedClients = selfClient.establishSessionsWithClients(preKeysByClient)
+        for client in preKeysByClient.keys {
+            client.failedToEstablishSession = failedClients.contains(client)
+        }
+        for client in clientsWithoutPreKey {
+            client.failedToEstablishSession = true
+        }
+        selfClient.removeMissingClients(clientsWithoutPreKey.union(preKeysByClient.keys))
+        
         return selfClient.missingClients?.count > 0 // we are done
     }
     
@@ -514,19 +497,6 @@ public class UserClientRequestStrategy: ZMObjectSyncStrategy, ZMObjectStrategy,
         }
     }
     
-    private func cleanMessagesMissingRecipient(client: UserClient) {
-        if let messagesMissingRecipient = client.messagesMissingRecipient {
-            for message in messagesMissingRecipient {
-                if let message = message as? ZMOTRMessage {
-                    message.doesNotMissRecipient(client)
-                }
-                else {
-                    client.mutableSetValueForKey("messagesMissingRecipient").removeObject(message)
-                }
-            }
-        }
-    }
-    
     func processResponseForDeletingClients(managedObject: ZMManagedObject!, requestUserInfo: [NSObject : AnyObject]!, responsePayload payload: ZMTransportData!) -> Bool {
         //is it safe for ui??
         if let client = managedObject as? UserClient {
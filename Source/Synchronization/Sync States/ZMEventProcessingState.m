@@ -31,10 +31,12 @@
 #import "ZMStateMachineDelegate.h"
 #import "ZMUserProfileUpdateTranscoder.h"
 #import "ZMHotFix.h"
+#import "ZMRequestScheduler.h"
 
 @interface ZMEventProcessingState ()
 
-@property (nonatomic) NSArray *syncObjects;
+/// The transcoders of each priority class, they are added to the request scheduler of the directory while this is the current state
+@property (nonatomic) NSArray<NSArray<id<ZMObjectStrategy>> *> *syncObjectsByPriorityClass;
 @property (nonatomic) BOOL isSyncing; // Only used to send a notification to UI that syncing finished
 @property (nonatomic) ZMHotFix *hotFix;
 
@@ -60,38 +62,49 @@
                        objectStrategyDirectory:objectStrategyDirectory
                           stateMachineDelegate:stateMachineDelegate];
     if (self) {
-        self.syncObjects = @[
-                             objectStrategyDirectory.flowTranscoder,
-                             objectStrategyDirectory.callStateTranscoder,
-                             objectStrategyDirectory.userProfileUpdateTranscoder,
-                             objectStrategyDirectory.addressBookTranscoder,
-                             objectStrategyDirectory.connectionTranscoder,
-                             objectStrategyDirectory.userTranscoder,
-                             objectStrategyDirectory.selfTranscoder,
-                             objectStrategyDirectory.conversationTranscoder,
-                             objectStrategyDirectory.pushTokenTranscoder,
-                             objectStrategyDirectory.systemMessageTranscoder,
-                             objectStrategyDirectory.textMessageTranscoder,
-                             objectStrategyDirectory.clientMessageTranscoder,
-                             objectStrategyDirectory.knockTranscoder,
-                             objectStrategyDirectory.userImageTranscoder,
-                             objectStrategyDirectory.searchUserImageTranscoder,
-                             objectStrategyDirectory.assetTranscoder,
-                             objectStrategyDirectory.typingTranscoder,
-                             objectStrategyDirectory.removedSuggestedPeopleTranscoder,
-                             ];
+        self.syncObjectsByPriorityClass = @[
+            // ZMRequestPriorityClassRealtime
+            @[objectStrategyDirectory.flowTranscoder,
+              objectStrategyDirectory.callStateTranscoder,
+              objectStrategyDirectory.typingTranscoder],
+            // ZMRequestPriorityClassUserVisible
+            @[objectStrategyDirectory.systemMessageTranscoder,
+              objectStrategyDirectory.textMessageTranscoder,
+              objectStrategyDirectory.clientMessageTranscoder,
+              objectStrategyDirectory.knockTranscoder],
+            // ZMRequestPriorityClassMetadata
+            @[objectStrategyDirectory.userProfileUpdateTranscoder,
+              objectStrategyDirectory.connectionTranscoder,
+              objectStrategyDirectory.userTranscoder,
+              objectStrategyDirectory.selfTranscoder,
+              objectStrategyDirectory.conversationTranscoder,
+              objectStrategyDirectory.pushTokenTranscoder,
+              objectStrategyDirectory.removedSuggestedPeopleTranscoder],
+            // ZMRequestPriorityClassBulk
+            @[objectStrategyDirectory.addressBookTranscoder,
+              objectStrategyDirectory.userImageTranscoder,
+              objectStrategyDirectory.searchUserImageTranscoder,
+              objectStrategyDirectory.assetTranscoder],
+            ];
         
-        for (id<ZMObjectStrategy> syncObject in self.syncObjects) {
-            Require([syncObject conformsToProtocol:@protocol(ZMObjectStrategy)]);
+        for (NSArray *syncObjectsInClass in self.syncObjectsByPriorityClass) {
+            for (id<ZMObjectStrategy> syncObject in syncObjectsInClass) {
+                Require([syncObject conformsToProtocol:@protocol(ZMObjectStrategy)]);
+            }
         }
         self.hotFix = [[ZMHotFix alloc] initWithSyncMOC:objectStrategyDirectory.moc];
     }
     return self;
 }
 
+- (BOOL)includesRequestSchedulerRequests
+{
+    return YES;
+}
+
 - (ZMTransportRequest *)nextRequest
 {
-    ZMTransportRequest *request = [self nextRequestFromTranscoders:self.syncObjects];
+    ZMTransportRequest *request = [self.objectStrategyDirectory.requestScheduler nextRequest];
     
     if (self.isSyncing && request == nil) {
         self.isSyncing = NO;
@@ -105,6 +118,14 @@
 
 - (void)didEnterState
 {
+    [self removeSyncObjectsFromRequestScheduler];
+    ZMRequestScheduler *requestScheduler = self.objectStrategyDirectory.requestScheduler;
+    [self.syncObjectsByPriorityClass enumerateObjectsUsingBlock:^(NSArray *syncObjectsInClass, NSUInteger priorityClass, BOOL * __unused stop) {
+        for (id<ZMObjectStrategy> syncObject in syncObjectsInClass) {
+            [requestScheduler addRequestGeneratorSource:syncObject priorityClass:priorityClass];
+        }
+    }];
+    
     [self.objectStrategyDirectory processAllEventsInBuffer];
     [self.hotFix applyPatches];
 
@@ -114,9 +135,26 @@
     [ZMUserSession notifyInitialSyncCompleted];
 }
 
+- (void)didLeaveState
+{
+    [self removeSyncObjectsFromRequestScheduler];
+    [super didLeaveState];
+}
+
+- (void)removeSyncObjectsFromRequestScheduler
+{
+    ZMRequestScheduler *requestScheduler = self.objectStrategyDirectory.requestScheduler;
+    for (NSArray *syncObjectsInClass in self.syncObjectsByPriorityClass) {
+        for (id<ZMObjectStrategy> syncObject in syncObjectsInClass) {
+            [requestScheduler removeRequestGeneratorSource:syncObject];
+        }
+    }
+}
+
 - (void)tearDown
 {
-    self.syncObjects = nil;
+    [self removeSyncObjectsFromRequestScheduler];
+    self.syncObjectsByPriorityClass = nil;
     [super tearDown];
 }
 
@@ -38,6 +38,8 @@
 @property (nonatomic, readonly, weak) ZMClientRegistrationStatus *clientRegistrationStatus;
 @property (nonatomic, readonly) id<ZMUpdateEventsFlushableCollection> eventBuffer;
 @property (nonatomic, readonly) BOOL supportsBackgroundFetch;
+/// YES if -nextRequest hands out the requests of the request scheduler, which then must not be asked again
+@property (nonatomic, readonly) BOOL includesRequestSchedulerRequests;
 
 - (instancetype)initWithAuthenticationCenter:(ZMAuthenticationStatus *)authenticationStatus
                     clientRegistrationStatus:(ZMClientRegistrationStatus *)clientRegistrationStatus
@@ -65,6 +65,11 @@
     return NO;
 }
 
+- (BOOL)includesRequestSchedulerRequests
+{
+    return NO;
+}
+
 - (void)didRequestSynchronization
 {
     [self.stateMachineDelegate startQuickSync];
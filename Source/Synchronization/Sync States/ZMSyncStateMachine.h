@@ -36,6 +36,8 @@
 @interface ZMSyncStateMachine : NSObject <ZMStateMachineDelegate, ZMBackgroundable>
 
 @property (nonatomic, readonly) ZMUpdateEventsPolicy updateEventsPolicy;
+/// YES if the current state already asks the request scheduler for requests
+@property (nonatomic, readonly) BOOL includesRequestSchedulerRequests;
 
 - (instancetype)initWithAuthenticationStatus:(ZMAuthenticationStatus *)authenticationStatus
                     clientRegistrationStatus:(ZMClientRegistrationStatus *)clientRegistrationStatus
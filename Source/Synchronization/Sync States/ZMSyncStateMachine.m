@@ -237,6 +237,11 @@ static void traceLeaveState(ZMSyncState * const state);
     return self.currentState.updateEventsPolicy;
 }
 
+- (BOOL)includesRequestSchedulerRequests
+{
+    return self.currentState.includesRequestSchedulerRequests;
+}
+
 - (void)didFailAuthentication
 {
     [self.currentState didFailAuthentication];
@@ -50,6 +50,14 @@ public class ConversationStatusStrategy : ZMObjectSyncStrategy, ZMContextChangeT
         }
     }
     
+    public func trackedEntityNames() -> Set<String> {
+        return Set(arrayLiteral: ZMConversation.entityName())
+    }
+    
+    public func trackedLocallyModifiedKeys() -> Set<String> {
+        return Set(arrayLiteral: lastReadKey, clearedKey)
+    }
+    
     public func fetchRequestForTrackedObjects() -> NSFetchRequest? {
         let request = NSFetchRequest(entityName: ZMConversation.entityName())
         return request
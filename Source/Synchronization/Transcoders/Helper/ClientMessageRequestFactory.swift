@@ -38,13 +38,42 @@ public class ClientMessageRequestFactory: NSObject {
     
     private func upstreamRequestForEncriptedClientMessage(message: ZMClientMessage, forConversationWithId conversationId: NSUUID) -> ZMTransportRequest? {
         let path = "/" + ["conversations", conversationId.transportString(), "otr", "messages"].joinWithSeparator("/")
-        let metaData = message.encryptedMessagePayloadData()
+        let metaData = encryptedMessagePayloadData(message)
         let request = ZMTransportRequest(path: path, method: .MethodPOST, binaryData: metaData, type: protobufContentType, contentDisposition: nil)
         var debugInfo = "\(message.genericMessage)"
         if message.genericMessage.hasExternal() { debugInfo = "External message: " + debugInfo }
         request.appendDebugInformation(debugInfo)
         return request
     }
+    
+    /// Messages to large group conversations are encrypted for all recipient clients in parallel by the `RecipientsEncryptor`.
+    /// All other messages, and messages that need to be sent as external messages, are encrypted by the message itself.
+    private func encryptedMessagePayloadData(message: ZMClientMessage) -> NSData? {
+        guard let conversation = message.conversation where conversation.conversationType == .Group,
+            let genericMessage = message.genericMessage where !genericMessage.hasExternal(),
+            let selfClient = ZMUser.selfUserInContext(message.managedObjectContext!).selfClient()
+        else {
+            return message.encryptedMessagePayloadData()
+        }
+        
+        let encryptor = RecipientsEncryptor(box: selfClient.keysStore.box)
+        let plainText = genericMessage.data()
+        let activeParticipants = conversation.activeParticipants.array as! [ZMUser]
+        let recipients = activeParticipants.flatMap { Array($0.clients) }.filter { $0 != selfClient }
+        
+        // every recipient gets at least the size of the plain text, above the threshold the message is sent as an external message
+        guard recipients.count >= encryptor.minimumNumberOfRecipientsForParallelEncryption
+            && plainText.length * recipients.count <= Int(ZMClientMessageByteSizeExternalThreshold)
+        else {
+            return message.encryptedMessagePayloadData()
+        }
+        
+        let payload = encryptor.otrMessageWithData(plainText, sender: selfClient, recipients: recipients).data()
+        if payload.length > Int(ZMClientMessageByteSizeExternalThreshold) {
+            return message.encryptedMessagePayloadData()
+        }
+        return payload
+    }
 
     private func upstreamRequestForEncryptedImageMessage(format: ZMImageFormat, message: ZMAssetClientMessage, forConversationWithId conversationId: NSUUID) -> ZMTransportRequest? {
 
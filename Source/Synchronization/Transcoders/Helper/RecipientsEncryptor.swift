@@ -0,0 +1,161 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+import Foundation
+import ZMCSystem
+import ZMUtilities
+import Cryptobox
+import ZMProtos
+import ZMCDataModel
+
+private let zmLog = ZMSLog(tag: "Crypto")
+
+/// Encrypts the payload of an outgoing OTR message for all recipient clients and merges the results into one `NewOtrMessage`.
+///
+/// Sessions are independent from each other, so the encryption for different recipients is spread over a bounded number of workers.
+/// The box is locked for the whole operation. Encryptions (and decryptions) of the same session are therefore never interleaved,
+/// and each session is used exactly once per message.
+/// Recipients are sorted by user and client identifier, so the resulting message does not depend on the order the workers finish in.
+public final class RecipientsEncryptor: NSObject {
+    
+    private let box: CBCryptoBox
+    private let queue = dispatch_queue_create("RecipientsEncryptor", DISPATCH_QUEUE_CONCURRENT)
+    
+    /// Maximum number of sessions encrypted at the same time
+    public let maximumNumberOfWorkers: Int
+    
+    /// Below this number of recipients, encrypting serially on the calling queue is cheaper than dispatching to the workers
+    public let minimumNumberOfRecipientsForParallelEncryption: Int
+    
+    public init(box: CBCryptoBox,
+                maximumNumberOfWorkers: Int = min(NSProcessInfo.processInfo().activeProcessorCount, 4),
+                minimumNumberOfRecipientsForParallelEncryption: Int = 8) {
+        self.box = box
+        self.maximumNumberOfWorkers = max(maximumNumberOfWorkers, 1)
+        self.minimumNumberOfRecipientsForParallelEncryption = minimumNumberOfRecipientsForParallelEncryption
+        super.init()
+    }
+    
+    /// Returns the `NewOtrMessage` containing `plainText` encrypted for each of the recipients.
+    /// Recipients we don't have a session with, or for which the encryption failed, are left out.
+    public func otrMessageWithData(plainText: NSData, sender: UserClient, recipients: [UserClient], nativePush: Bool = true) -> ZMNewOtrMessage {
+        let sortedRecipients = self.dynamicType.uniqueSortedRecipients(recipients)
+        
+        objc_sync_enter(box)
+        defer { objc_sync_exit(box) }
+        
+        var sessions = [CBSession?]()
+        sessions.reserveCapacity(sortedRecipients.count)
+        for recipient in sortedRecipients {
+            sessions.append(try? box.sessionById(recipient.remoteIdentifier))
+        }
+        
+        let encryptedData = encrypt(plainText, sessions: sessions)
+        
+        for case let session? in sessions {
+            box.setSessionToRequireSave(session)
+        }
+        box.saveSessionsRequiringSave()
+        
+        return self.dynamicType.otrMessage(sender, recipients: sortedRecipients, encryptedData: encryptedData, nativePush: nativePush)
+    }
+    
+    /// Encrypts `plainText` with every session. The result at index `i` belongs to the session at index `i`.
+    /// Needs to be called while holding the lock of the box.
+    private func encrypt(plainText: NSData, sessions: [CBSession?]) -> [NSData?] {
+        let count = sessions.count
+        let numberOfWorkers = min(maximumNumberOfWorkers, count)
+        
+        guard count >= minimumNumberOfRecipientsForParallelEncryption && numberOfWorkers > 1 else {
+            return sessions.map { session in
+                return self.dynamicType.encrypt(plainText, session: session)
+            }
+        }
+        
+        // each index is written by exactly one worker
+        let results = UnsafeMutablePointer<NSData?>.alloc(count)
+        results.initializeFrom(Repeat(count: count, repeatedValue: nil))
+        defer {
+            results.destroy(count)
+            results.dealloc(count)
+        }
+        
+        dispatch_apply(numberOfWorkers, queue) { worker in
+            for index in worker.stride(to: count, by: numberOfWorkers) {
+                results[index] = self.dynamicType.encrypt(plainText, session: sessions[index])
+            }
+        }
+        return Array(UnsafeBufferPointer(start: results, count: count))
+    }
+    
+    private static func encrypt(plainText: NSData, session: CBSession?) -> NSData? {
+        guard let session = session else { return nil }
+        do {
+            return try session.encrypt(plainText)
+        } catch let error {
+            zmLog.error("Failed to encrypt message: \(error)")
+            return nil
+        }
+    }
+    
+    private static func uniqueSortedRecipients(recipients: [UserClient]) -> [UserClient] {
+        var seenIdentifiers = Set<String>()
+        let uniqueRecipients = recipients.filter { recipient in
+            guard let identifier = recipient.remoteIdentifier
+                where recipient.user?.remoteIdentifier != nil && !seenIdentifiers.contains(identifier) else { return false }
+            seenIdentifiers.insert(identifier)
+            return true
+        }
+        return uniqueRecipients.sort { (lhs, rhs) in
+            let lhsUser = lhs.user!.remoteIdentifier!.transportString()
+            let rhsUser = rhs.user!.remoteIdentifier!.transportString()
+            return lhsUser == rhsUser ? lhs.remoteIdentifier! < rhs.remoteIdentifier! : lhsUser < rhsUser
+        }
+    }
+    
+    /// Groups the encrypted data by user. `recipients` need to be sorted by user.
+    private static func otrMessage(sender: UserClient, recipients: [UserClient], encryptedData: [NSData?], nativePush: Bool) -> ZMNewOtrMessage {
+        var userEntries = [ZMUserEntry]()
+        var currentUser : ZMUser?
+        var currentClientEntries = [ZMClientEntry]()
+        
+        func appendCurrentUserEntry() {
+            guard let user = currentUser where !currentClientEntries.isEmpty else { return }
+            let userId = ZMUserId.builder().setUuid(user.remoteIdentifier!.data()).build()
+            userEntries.append(ZMUserEntry.builder().setUser(userId).setClientsArray(currentClientEntries).build())
+        }
+        
+        for (recipient, data) in zip(recipients, encryptedData) {
+            if recipient.user != currentUser {
+                appendCurrentUserEntry()
+                currentUser = recipient.user
+                currentClientEntries = []
+            }
+            guard let data = data else { continue }
+            currentClientEntries.append(ZMClientEntry.builder().setClient(recipient.clientId).setText(data).build())
+        }
+        appendCurrentUserEntry()
+        
+        return ZMNewOtrMessage.builder()
+            .setSender(sender.clientId)
+            .setRecipientsArray(userEntries)
+            .setNativePush(nativePush)
+            .build()
+    }
+}
@@ -0,0 +1,47 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// A source of the current time that can wake up its client at a given date.
+///
+/// Objects that expire things at a date (e.g. ZMMessageExpirationTimer) ask the clock for the current date
+/// and keep a single wake up armed for the earliest date they care about, instead of one timer per thing.
+/// Tests can use a clock that is advanced manually instead of waiting for real time to pass.
+@protocol ZMExpirationClock <NSObject>
+
+@property (nonatomic, readonly) NSDate *currentDate;
+
+/// Calls @c handler once, when @c date has been reached. Replaces any previously armed wake up.
+- (void)wakeUpAtDate:(NSDate *)date handler:(dispatch_block_t)handler;
+
+/// Cancels the armed wake up, if any.
+- (void)cancelWakeUp;
+
+@end
+
+
+
+/// Uses the system time and a ZMTimer
+@interface ZMSystemExpirationClock : NSObject <ZMExpirationClock>
+@end
+
+NS_ASSUME_NONNULL_END
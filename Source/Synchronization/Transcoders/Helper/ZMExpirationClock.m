@@ -0,0 +1,82 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMUtilities;
+
+#import "ZMExpirationClock.h"
+
+
+@interface ZMSystemExpirationClock () <ZMTimerClient>
+
+@property (nonatomic) ZMTimer *timer;
+@property (nonatomic, copy) dispatch_block_t handler;
+
+@end
+
+
+
+@implementation ZMSystemExpirationClock
+
+- (void)dealloc
+{
+    [_timer cancel];
+}
+
+- (NSDate *)currentDate
+{
+    return [NSDate date];
+}
+
+/// The timer fires on its own queue, so the timer and handler are only accessed while synchronized on self
+- (void)wakeUpAtDate:(NSDate *)date handler:(dispatch_block_t)handler
+{
+    @synchronized(self) {
+        [self.timer cancel];
+        self.handler = handler;
+        self.timer = [ZMTimer timerWithTarget:self];
+        [self.timer fireAtDate:date];
+    }
+}
+
+- (void)cancelWakeUp
+{
+    @synchronized(self) {
+        [self.timer cancel];
+        self.timer = nil;
+        self.handler = nil;
+    }
+}
+
+- (void)timerDidFire:(ZMTimer *)timer
+{
+    dispatch_block_t handler;
+    @synchronized(self) {
+        if (timer != self.timer) {
+            return;
+        }
+        handler = self.handler;
+        self.timer = nil;
+        self.handler = nil;
+    }
+    if (handler != nil) {
+        handler();
+    }
+}
+
+@end
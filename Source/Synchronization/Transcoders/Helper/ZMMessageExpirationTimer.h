@@ -19,11 +19,15 @@
 
 #import <Foundation/Foundation.h>
 #import "ZMContextChangeTracker.h"
+#import "ZMExpirationClock.h"
 
 @class ZMMessage;
 @class ZMLocalNotificationDispatcher;
 
 /// Keeps track of messages and sets them to expired when their time has come
+///
+/// Messages are kept sorted by expiration date and only one wake up is armed on the clock, for the earliest one.
+/// Messages that are due at the same time are expired together, with a single save.
 @interface ZMMessageExpirationTimer : NSObject <ZMContextChangeTracker>
 
 @property (nonatomic, readonly) BOOL hasMessageTimersRunning;
@@ -31,6 +35,7 @@
 
 - (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc entityName:(NSString *)entityName localNotificationDispatcher:(ZMLocalNotificationDispatcher *)notificationDispatcher;
 - (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc entityName:(NSString *)entityName localNotificationDispatcher:(ZMLocalNotificationDispatcher *)notificationDispatcher filter:(NSPredicate *)filter;
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc entityName:(NSString *)entityName localNotificationDispatcher:(ZMLocalNotificationDispatcher *)notificationDispatcher filter:(NSPredicate *)filter clock:(id<ZMExpirationClock>)clock;
 
 - (void)stopTimerForMessage:(ZMMessage *)message;
 
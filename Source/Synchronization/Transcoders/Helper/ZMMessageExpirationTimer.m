@@ -26,9 +26,41 @@
 
 #import "ZMLocalNotificationDispatcher.h"
 
-@interface ZMMessageExpirationTimer () <ZMTimerClient>
 
-@property (nonatomic) NSMapTable *objectToTimerMap;
+
+/// A message waiting to expire, and the date it was scheduled for
+@interface ZMMessageExpirationEntry : NSObject
+
+@property (nonatomic, readonly) ZMMessage *message;
+@property (nonatomic, readonly) NSDate *expirationDate;
+
+@end
+
+
+
+@implementation ZMMessageExpirationEntry
+
+- (instancetype)initWithMessage:(ZMMessage *)message expirationDate:(NSDate *)expirationDate
+{
+    self = [super init];
+    if (self) {
+        _message = message;
+        _expirationDate = expirationDate;
+    }
+    return self;
+}
+
+@end
+
+
+
+@interface ZMMessageExpirationTimer ()
+
+/// Entries sorted by expiration date, the earliest first
+@property (nonatomic) NSMutableArray<ZMMessageExpirationEntry *> *sortedEntries;
+@property (nonatomic) NSMapTable *messageToEntryMap;
+@property (nonatomic) NSDate *armedDate;
+@property (nonatomic) id<ZMExpirationClock> clock;
 @property (nonatomic) BOOL tearDownCalled;
 @property (nonatomic) NSManagedObjectContext *moc;
 @property (nonatomic) ZMLocalNotificationDispatcher *localNotificationsDispatcher;
@@ -49,11 +81,18 @@ ZM_EMPTY_ASSERTING_INIT()
 }
 
 - (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc entityName:(NSString *)entityName localNotificationDispatcher:(ZMLocalNotificationDispatcher *)notificationDispatcher filter:(NSPredicate *)filter;
+{
+    return [self initWithManagedObjectContext:moc entityName:entityName localNotificationDispatcher:notificationDispatcher filter:filter clock:[[ZMSystemExpirationClock alloc] init]];
+}
+
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc entityName:(NSString *)entityName localNotificationDispatcher:(ZMLocalNotificationDispatcher *)notificationDispatcher filter:(NSPredicate *)filter clock:(id<ZMExpirationClock>)clock;
 {
     self = [super init];
     if (self) {
         self.localNotificationsDispatcher = notificationDispatcher;
-        self.objectToTimerMap = [NSMapTable strongToStrongObjectsMapTable];
+        self.sortedEntries = [NSMutableArray array];
+        self.messageToEntryMap = [NSMapTable strongToStrongObjectsMapTable];
+        self.clock = clock;
         self.moc = moc;
         self.entityName = entityName;
         self.filter = filter;
@@ -68,12 +107,12 @@ ZM_EMPTY_ASSERTING_INIT()
 
 - (BOOL)hasMessageTimersRunning
 {
-    return self.objectToTimerMap.count > 0;
+    return self.messageToEntryMap.count > 0;
 }
 
 - (NSUInteger)runningTimersCount
 {
-    return [self.objectToTimerMap count];
+    return [self.messageToEntryMap count];
 }
 
 - (NSFetchRequest *)fetchRequestForTrackedObjects
@@ -92,6 +131,11 @@ ZM_EMPTY_ASSERTING_INIT()
     [self startTimerForObjects:objects];
 }
 
+- (NSSet *)trackedEntityNames
+{
+    return [NSSet setWithObject:self.entityName];
+}
+
 - (void)startTimerForStoredMessages
 {
     NSPredicate *predicate = [ZMMessage predicateForMessagesThatWillExpire];
@@ -103,7 +147,7 @@ ZM_EMPTY_ASSERTING_INIT()
 
 - (void)startTimerForObjects:(NSSet *)managedObjects
 {
-    NSDate *now = [NSDate date];
+    NSDate *now = self.clock.currentDate;
     for (ZMManagedObject *object in managedObjects) {
         if (![[[object class] entityName] isEqual: self.entityName]) {
             continue;
@@ -115,10 +159,6 @@ ZM_EMPTY_ASSERTING_INIT()
             continue;
         }
         
-        if (! [[[object class] entityName] isEqualToString:self.entityName]) {
-            continue;
-        }
-        
         ZMMessage *message = (ZMMessage *)object;
         
         if (message.expirationDate == nil) {
@@ -130,63 +170,119 @@ ZM_EMPTY_ASSERTING_INIT()
             [message.managedObjectContext enqueueDelayedSave];
         }
         else if ( ![self isTimerRunningForMessage:message] ) {
-            ZMTimer *timer = [ZMTimer timerWithTarget:self];
-            timer.userInfo = @{ @"message": message };
-            [self.objectToTimerMap setObject:timer forKey:message];
-            
-            [timer fireAtDate:message.expirationDate];
+            [self insertEntry:[[ZMMessageExpirationEntry alloc] initWithMessage:message expirationDate:message.expirationDate]];
         }
     }
+    [self armClockForEarliestEntry];
 }
 
 - (BOOL)isTimerRunningForMessage:(ZMMessage *)message {
-    return [self.objectToTimerMap objectForKey:message] != nil;
+    return [self.messageToEntryMap objectForKey:message] != nil;
 }
 
-- (void)timerDidFire:(ZMTimer *)timer
+- (NSUInteger)indexForExpirationDate:(NSDate *)date options:(NSBinarySearchingOptions)options
 {
-    ZMMessage *message = timer.userInfo[@"message"];
+    ZMMessageExpirationEntry *probe = [[ZMMessageExpirationEntry alloc] initWithMessage:nil expirationDate:date];
+    return [self.sortedEntries indexOfObject:probe
+                               inSortedRange:NSMakeRange(0, self.sortedEntries.count)
+                                     options:NSBinarySearchingInsertionIndex | options
+                             usingComparator:^NSComparisonResult(ZMMessageExpirationEntry *entry1, ZMMessageExpirationEntry *entry2) {
+                                 return [entry1.expirationDate compare:entry2.expirationDate];
+                             }];
+}
+
+- (void)insertEntry:(ZMMessageExpirationEntry *)entry
+{
+    // After the entries with the same date, so that messages expire in the order they were added
+    NSUInteger index = [self indexForExpirationDate:entry.expirationDate options:NSBinarySearchingLastEqual];
+    [self.sortedEntries insertObject:entry atIndex:index];
+    [self.messageToEntryMap setObject:entry forKey:entry.message];
+}
+
+- (void)removeEntry:(ZMMessageExpirationEntry *)entry
+{
+    NSUInteger index = [self indexForExpirationDate:entry.expirationDate options:NSBinarySearchingFirstEqual];
+    for (; index < self.sortedEntries.count; ++index) {
+        if (self.sortedEntries[index] == entry) {
+            [self.sortedEntries removeObjectAtIndex:index];
+            break;
+        }
+    }
+    [self.messageToEntryMap removeObjectForKey:entry.message];
+}
+
+/// Keeps a single wake up armed, for the earliest expiration date
+- (void)armClockForEarliestEntry
+{
+    NSDate *earliestDate = self.sortedEntries.firstObject.expirationDate;
+    if (earliestDate == nil) {
+        if (self.armedDate != nil) {
+            [self.clock cancelWakeUp];
+            self.armedDate = nil;
+        }
+        return;
+    }
+    if ([earliestDate isEqualToDate:self.armedDate] || self.tearDownCalled) {
+        return;
+    }
     
+    self.armedDate = earliestDate;
     RequireString(self.moc != nil, "MOC is nil");
-    [self.moc performGroupedBlock:^{
-        [self removeTimerForMessage:message];
+    ZM_WEAK(self);
+    [self.clock wakeUpAtDate:earliestDate handler:^{
+        ZM_STRONG(self);
+        [self.moc performGroupedBlock:^{
+            self.armedDate = nil;
+            [self expireMessagesDueAtDate:self.clock.currentDate];
+        }];
+    }];
+}
+
+/// Expires all messages whose time has come as one batch, with a single save
+- (void)expireMessagesDueAtDate:(NSDate *)date
+{
+    BOOL didExpireMessages = NO;
+    while (self.sortedEntries.count > 0 && [self.sortedEntries.firstObject.expirationDate compare:date] != NSOrderedDescending) {
+        ZMMessageExpirationEntry *entry = self.sortedEntries.firstObject;
+        [self.sortedEntries removeObjectAtIndex:0];
+        [self.messageToEntryMap removeObjectForKey:entry.message];
         
+        ZMMessage *message = entry.message;
         if (message == nil || message.isZombieObject) {
-            return;
+            continue;
         }
         
         if (message.deliveryState != ZMDeliveryStateDelivered) {
             [message expire];
-            [message.managedObjectContext enqueueDelayedSave];
             [self.localNotificationsDispatcher didFailToSentMessage:message];
-            [ZMOperationLoop notifyNewRequestsAvailable:self];
+            didExpireMessages = YES;
         }
-    }];
+    }
+    
+    if (didExpireMessages) {
+        [self.moc enqueueDelayedSave];
+        [ZMOperationLoop notifyNewRequestsAvailable:self];
+    }
+    [self armClockForEarliestEntry];
 }
 
 
 - (void)stopTimerForMessage:(ZMMessage *)message;
 {
-    ZMTimer *timer = [self.objectToTimerMap objectForKey:message];
-    if(timer == nil) {
+    ZMMessageExpirationEntry *entry = [self.messageToEntryMap objectForKey:message];
+    if(entry == nil) {
         return;
     }
     
-    [timer cancel];
-    [self removeTimerForMessage:message];
-}
-
-
-- (void)removeTimerForMessage:(ZMMessage *)message {
-    [self.objectToTimerMap removeObjectForKey:message];
+    [self removeEntry:entry];
+    [self armClockForEarliestEntry];
 }
 
 
 - (void)tearDown;
 {
-    for (ZMTimer *timer in self.objectToTimerMap.objectEnumerator) {
-        [timer cancel];
-    }
+    [self.clock cancelWakeUp];
+    self.armedDate = nil;
     
     self.tearDownCalled = YES;
 }
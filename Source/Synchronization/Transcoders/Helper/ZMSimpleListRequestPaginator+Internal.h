@@ -24,4 +24,9 @@
 
 @property (nonatomic) ZMSingleRequestSync *singleRequestSync;
 
+/// Updates the adaptive page size with the measurements of a page
+- (void)didMeasurePageWithLatency:(NSTimeInterval)latency processingDuration:(NSTimeInterval)processingDuration payloadByteCount:(NSUInteger)payloadByteCount;
+/// Shrinks the adaptive page size after a failed request
+- (void)didFailToFetchPage;
+
 @end
@@ -24,6 +24,22 @@
 
 
 
+/// Measurements of a single page, for diagnostics and adaptive page sizing
+@interface ZMSimpleListRequestPaginatorPageStatistics : NSObject
+
+/// The page size that was requested
+@property (nonatomic, readonly) NSUInteger pageSize;
+/// Time between creating the request and handling the response, including the time the response waited for the context
+@property (nonatomic, readonly) NSTimeInterval latency;
+/// Time the transcoder spent applying the response
+@property (nonatomic, readonly) NSTimeInterval processingDuration;
+/// Size of the response body, 0 if unknown
+@property (nonatomic, readonly) NSUInteger payloadByteCount;
+
+@end
+
+
+
 @interface ZMSimpleListRequestPaginator : NSObject
 
 /// YES if more requests should be made before to fetch the full list
@@ -41,6 +57,24 @@
 /// this will cause the fetch to restart at the nextPaginatedRequest
 - (void)resetFetching;
 
+/// The page size used for the next request
+@property (nonatomic, readonly) NSUInteger pageSize;
+
+/// Limits for the adaptive page size. By default both are the page size passed to the initializer.
+@property (nonatomic, readonly) NSUInteger minimumPageSize;
+@property (nonatomic, readonly) NSUInteger maximumPageSize;
+- (void)setMinimumPageSize:(NSUInteger)minimumPageSize maximumPageSize:(NSUInteger)maximumPageSize;
+
+/// If YES, the page size is tuned after every page from the measured payload size and processing time,
+/// such that applying a page takes about @c targetPageDuration. Defaults to NO, i.e. the fixed page size passed to the initializer.
+/// Failed requests halve the page size, so that a timeout doesn't throw away a lot of work.
+@property (nonatomic) BOOL usesAdaptivePageSize;
+@property (nonatomic) NSTimeInterval targetPageDuration;
+@property (nonatomic) NSUInteger targetPageByteCount;
+
+/// Measurements of the most recent pages, oldest first
+@property (nonatomic, readonly) NSArray<ZMSimpleListRequestPaginatorPageStatistics *> *recentPageStatistics;
+
 @end
 
 
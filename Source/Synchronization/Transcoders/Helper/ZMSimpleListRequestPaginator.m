@@ -25,6 +25,37 @@
 #import "ZMSingleRequestSync.h"
 #import <zmessaging/zmessaging-Swift.h>
 
+static NSUInteger const RecentPageStatisticsCount = 10;
+static NSTimeInterval const DefaultTargetPageDuration = 2;
+static NSUInteger const DefaultTargetPageByteCount = 1024 * 1024;
+/// Maximum factor by which the page size changes from one page to the next
+static double const MaximumPageSizeChangeFactor = 2;
+
+
+
+@interface ZMSimpleListRequestPaginatorPageStatistics ()
+
+@property (nonatomic) NSUInteger pageSize;
+@property (nonatomic) NSTimeInterval latency;
+@property (nonatomic) NSTimeInterval processingDuration;
+@property (nonatomic) NSUInteger payloadByteCount;
+
+@end
+
+
+
+@implementation ZMSimpleListRequestPaginatorPageStatistics
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> size %lu, latency %.3fs, processing %.3fs, %lu bytes",
+            self.class, self, (unsigned long)self.pageSize, self.latency, self.processingDuration, (unsigned long)self.payloadByteCount];
+}
+
+@end
+
+
+
 @interface ZMSimpleListRequestPaginator () <ZMSingleRequestTranscoder>
 
 @property (nonatomic, copy) NSString *basePath;
@@ -37,6 +68,12 @@
 
 @property (nonatomic) BOOL includeClientID;
 
+@property (nonatomic) NSUInteger minimumPageSize;
+@property (nonatomic) NSUInteger maximumPageSize;
+@property (nonatomic) NSUInteger requestedPageSize;
+@property (nonatomic) NSDate *requestCreationDate;
+@property (nonatomic) NSMutableArray<ZMSimpleListRequestPaginatorPageStatistics *> *pageStatistics;
+
 @property (nonatomic, weak) id<ZMSimpleListRequestPaginatorSync> transcoder;
 
 @end
@@ -61,6 +98,11 @@ ZM_EMPTY_ASSERTING_INIT()
         self.basePath = basePath;
         self.startKey = startKey;
         self.pageSize = pageSize;
+        self.minimumPageSize = pageSize;
+        self.maximumPageSize = pageSize;
+        self.targetPageDuration = DefaultTargetPageDuration;
+        self.targetPageByteCount = DefaultTargetPageByteCount;
+        self.pageStatistics = [NSMutableArray array];
         self.moc = moc;
         self.includeClientID = includeClientID;
         self.transcoder = transcoder;
@@ -98,13 +140,26 @@ ZM_EMPTY_ASSERTING_INIT()
     components.queryItems = queryItems;
     
     ZMTransportRequest *request = [ZMTransportRequest requestGetFromPath:components.string];
+    self.requestedPageSize = self.pageSize;
+    self.requestCreationDate = [NSDate date];
     return request;
 }
 
 - (void)didReceiveResponse:(ZMTransportResponse *)response forSingleRequest:(ZMSingleRequestSync * __unused)sync
 {
+    NSTimeInterval const latency = self.requestCreationDate != nil ? -[self.requestCreationDate timeIntervalSinceNow] : 0;
+    self.requestCreationDate = nil;
+    
     if(response.result == ZMTransportResponseStatusSuccess) {
+        // The transcoder applies the page synchronously in here, so this is the time it takes to apply it
+        NSDate *processingStart = [NSDate date];
         [self updateStateWithResponse:response];
+        [self didMeasurePageWithLatency:latency
+                     processingDuration:-[processingStart timeIntervalSinceNow]
+                       payloadByteCount:[self payloadByteCountOfResponse:response]];
+    }
+    else if(response.result == ZMTransportResponseStatusTemporaryError || response.result == ZMTransportResponseStatusExpired) {
+        [self didFailToFetchPage];
     }
     else if(response.result == ZMTransportResponseStatusPermanentError) {
         id strongTranscoder = self.transcoder;
@@ -136,6 +191,83 @@ ZM_EMPTY_ASSERTING_INIT()
     }
 }
 
+- (NSUInteger)payloadByteCountOfResponse:(ZMTransportResponse *)response
+{
+    NSString *contentLength = [response.headers optionalStringForKey:@"Content-Length"];
+    if (contentLength != nil) {
+        return (NSUInteger) MAX(contentLength.longLongValue, 0);
+    }
+    return response.rawData.length;
+}
+
+- (void)setMinimumPageSize:(NSUInteger)minimumPageSize maximumPageSize:(NSUInteger)maximumPageSize
+{
+    Require(0 < minimumPageSize && minimumPageSize <= maximumPageSize);
+    self.minimumPageSize = minimumPageSize;
+    self.maximumPageSize = maximumPageSize;
+    if (self.usesAdaptivePageSize) {
+        self.pageSize = [self clampedPageSize:(double) self.pageSize];
+    }
+}
+
+- (void)setUsesAdaptivePageSize:(BOOL)usesAdaptivePageSize
+{
+    _usesAdaptivePageSize = usesAdaptivePageSize;
+    if (usesAdaptivePageSize) {
+        self.pageSize = [self clampedPageSize:(double) self.pageSize];
+    }
+}
+
+- (NSArray<ZMSimpleListRequestPaginatorPageStatistics *> *)recentPageStatistics
+{
+    return [self.pageStatistics copy];
+}
+
+- (NSUInteger)clampedPageSize:(double)pageSize
+{
+    return (NSUInteger) MAX((double) self.minimumPageSize, MIN((double) self.maximumPageSize, round(pageSize)));
+}
+
+- (void)didMeasurePageWithLatency:(NSTimeInterval)latency processingDuration:(NSTimeInterval)processingDuration payloadByteCount:(NSUInteger)payloadByteCount
+{
+    NSUInteger const requestedPageSize = self.requestedPageSize ?: self.pageSize;
+    
+    ZMSimpleListRequestPaginatorPageStatistics *statistics = [[ZMSimpleListRequestPaginatorPageStatistics alloc] init];
+    statistics.pageSize = requestedPageSize;
+    statistics.latency = latency;
+    statistics.processingDuration = processingDuration;
+    statistics.payloadByteCount = payloadByteCount;
+    [self.pageStatistics addObject:statistics];
+    if (self.pageStatistics.count > RecentPageStatisticsCount) {
+        [self.pageStatistics removeObjectAtIndex:0];
+    }
+    
+    // Only full pages tell us how long a page of the requested size takes
+    if (!self.usesAdaptivePageSize || !self.hasMoreToFetch) {
+        return;
+    }
+    
+    // Scale the page such that applying it takes about the target duration and it stays below the target payload size.
+    // The latency includes the time the response waited for the context, so it says little about the page size.
+    double factor = MaximumPageSizeChangeFactor;
+    if (processingDuration > 0) {
+        factor = MIN(factor, self.targetPageDuration / processingDuration);
+    }
+    if (payloadByteCount > 0 && self.targetPageByteCount > 0) {
+        factor = MIN(factor, (double) self.targetPageByteCount / (double) payloadByteCount);
+    }
+    factor = MAX(factor, 1 / MaximumPageSizeChangeFactor);
+    self.pageSize = [self clampedPageSize:requestedPageSize * factor];
+}
+
+- (void)didFailToFetchPage
+{
+    if (!self.usesAdaptivePageSize) {
+        return;
+    }
+    self.pageSize = [self clampedPageSize:(self.requestedPageSize ?: self.pageSize) / MaximumPageSizeChangeFactor];
+}
+
 - (void)resetFetching
 {
     self.hasMoreToFetch = YES;
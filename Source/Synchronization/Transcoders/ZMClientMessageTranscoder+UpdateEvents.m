@@ -24,6 +24,8 @@
 
 #import "ZMClientMessageTranscoder+UpdateEvents.h"
 #import "ZMClientMessageTranscoder+Internal.h"
+#import "CBCryptoBox+UpdateEvents.h"
+#import "ZMUpdateEvent+DecryptedData.h"
 #import <zmessaging/zmessaging-Swift.h>
 
 
@@ -79,19 +81,20 @@
 
 - (NSArray <ZMUpdateEvent *>*)decryptedUpdateEventsFromEvents:(NSArray <ZMUpdateEvent *>*)events
 {
-    NSMutableOrderedSet <ZMUpdateEvent *>*orderedEvents = [NSMutableOrderedSet orderedSetWithArray:events];
-    for(ZMUpdateEvent *event in events) {
-        if (event.type == ZMUpdateEventConversationOtrMessageAdd || event.type == ZMUpdateEventConversationOtrAssetAdd) {
-            NSUInteger index = [orderedEvents indexOfObject:event];
-            ZMUpdateEvent *decryptedEvent = [self decryptedUpdateEventForUpdateEvent:event];
-            [orderedEvents removeObject:event];
-            if (nil != decryptedEvent) {
-                [orderedEvents insertObject:decryptedEvent atIndex:index];
-            }
-        }
+    NSOrderedSet <ZMUpdateEvent *>*orderedEvents = [NSOrderedSet orderedSetWithArray:events];
+    ZMUser *selfUser = [ZMUser selfUserInContext:self.managedObjectContext];
+    CBCryptoBox *box = [self.managedObjectContext zm_cryptKeyStore].box;
+    
+    if (selfUser.selfClient == nil || box == nil) {
+        // OTR events can't be decrypted without a client
+        return [orderedEvents.array filterWithBlock:^BOOL(ZMUpdateEvent *event) {
+            return event.type != ZMUpdateEventConversationOtrMessageAdd && event.type != ZMUpdateEventConversationOtrAssetAdd;
+        }];
     }
     
-    return orderedEvents.array;
+    // all events are decrypted at once, so that each session is only loaded and saved once
+    ZMUpdateEventsDecryptionBatchResult *batchResult = [box decryptUpdateEvents:orderedEvents.array selfClientIdentifier:selfUser.selfClient.remoteIdentifier];
+    return [box processDecryptionResults:batchResult.results managedObjectContext:self.managedObjectContext];
 }
 
 /// Returns an array of generic messages that are parsed from the given events
@@ -124,7 +127,7 @@
 
 - (NSUUID *)nonceForUpdateEvent:(ZMUpdateEvent *)event
 {
-    ZMGenericMessage *message = [ZMGenericMessage genericMessageFromUpdateEvent:event];
+    ZMGenericMessage *message = [event zm_genericMessage];
     return [NSUUID uuidWithTransportString:message.messageId];
 }
 
@@ -137,30 +140,4 @@
     return message;
 }
 
-- (ZMUpdateEvent *)decryptedUpdateEventForUpdateEvent:(ZMUpdateEvent *)event {
-    ZMUser *selfUser = [ZMUser selfUserInContext:self.managedObjectContext];
-    VerifyReturnNil(selfUser.selfClient != nil);
-    
-    ZMUpdateEvent *decryptedEvent;
-    if (event.isEncrypted && event.wasDecrypted) {
-        decryptedEvent = event;
-    }
-    else if (event.isEncrypted) {
-        CBCryptoBox *box = [self.managedObjectContext zm_cryptKeyStore].box;
-        VerifyReturnNil(box != nil);
-        
-        // to be sure that this message was sent to this device check 'recipient'
-        NSString *recipient = [[event.payload.asDictionary optionalDictionaryForKey:@"data"] optionalStringForKey:@"recipient"];
-        if (recipient == nil || ![recipient isEqualToString:selfUser.selfClient.remoteIdentifier]) {
-            return nil;
-        }
-        BOOL createdNewSession = NO;
-        decryptedEvent = [box decryptUpdateEventAndAddClient:event managedObjectContext:self.managedObjectContext];
-        if (createdNewSession) {
-            [selfUser.selfClient decrementNumberOfRemainingKeys];
-        }
-    }
-    return decryptedEvent;
-}
-
 @end
@@ -41,6 +41,7 @@ static NSString *const ConversationIDsPath = @"/conversations/ids";
 
 NSUInteger ZMConversationTranscoderListPageSize = 100;
 const NSUInteger ZMConversationTranscoderDefaultConversationPageSize = 32;
+static NSUInteger const ZMConversationTranscoderMaximumNumberOfConversationRequestsInFlight = 4;
 
 static NSString *const UserInfoTypeKey = @"type";
 static NSString *const UserInfoUserKey = @"user";
@@ -114,6 +115,7 @@ static NSString *const ConversationInfoArchivedValueKey = @"archived";
         self.syncStrategy = syncStrategy;
         self.conversationPageSize = ZMConversationTranscoderDefaultConversationPageSize;
         self.remoteIDSync = [[ZMRemoteIdentifierObjectSync alloc] initWithTranscoder:self managedObjectContext:self.managedObjectContext];
+        self.remoteIDSync.maximumNumberOfBatchesInFlight = ZMConversationTranscoderMaximumNumberOfConversationRequestsInFlight;
     }
     return self;
 }
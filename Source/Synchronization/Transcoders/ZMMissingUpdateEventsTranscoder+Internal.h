@@ -24,6 +24,11 @@
 #import "ZMSingleRequestSync.h"
 
 extern NSUInteger const ZMMissingUpdateEventsTranscoderListPageSize;
+extern NSUInteger const ZMMissingUpdateEventsTranscoderMinimumListPageSize;
+extern NSUInteger const ZMMissingUpdateEventsTranscoderMaximumListPageSize;
+/// Number of notifications of a page whose events are created and processed at a time.
+/// The transport hands over the page already parsed, so this bounds the live ZMUpdateEvents, not the memory of the page.
+extern NSUInteger const ZMMissingUpdateEventsTranscoderNotificationChunkSize;
 
 @class ZMSimpleListRequestPaginator;
 
@@ -32,6 +32,9 @@ static NSString * const NotificationsPath = @"/notifications";
 static NSString * const StartKey = @"since";
 
 NSUInteger const ZMMissingUpdateEventsTranscoderListPageSize = 500;
+NSUInteger const ZMMissingUpdateEventsTranscoderMinimumListPageSize = 100;
+NSUInteger const ZMMissingUpdateEventsTranscoderMaximumListPageSize = 1000;
+NSUInteger const ZMMissingUpdateEventsTranscoderNotificationChunkSize = 100;
 
 @interface ZMMissingUpdateEventsTranscoder ()
 
@@ -59,6 +62,9 @@ NSUInteger const ZMMissingUpdateEventsTranscoderListPageSize = 500;
                                                                 managedObjectContext:self.managedObjectContext
                                                                     includeClientID:YES
                                                                          transcoder:self];
+        [self.listPaginator setMinimumPageSize:ZMMissingUpdateEventsTranscoderMinimumListPageSize
+                               maximumPageSize:ZMMissingUpdateEventsTranscoderMaximumListPageSize];
+        self.listPaginator.usesAdaptivePageSize = YES;
     }
     return self;
 }
@@ -126,25 +132,32 @@ NSUInteger const ZMMissingUpdateEventsTranscoderListPageSize = 500;
     ZMSTimePoint *tp = [ZMSTimePoint timePointWithInterval:10 label:NSStringFromClass(self)];
     NSArray *eventsDictionaries = [self eventDictionariesFromPayload:payload];
     
-    NSMutableArray *parsedEvents = [NSMutableArray array];
     NSMutableDictionary *lastCallStateEvents = [NSMutableDictionary dictionary];
     NSUUID *latestEventId = nil;
     
-    for(NSDictionary *eventDict in eventsDictionaries) {
-        NSArray *events = [ZMUpdateEvent eventsArrayFromPushChannelData:eventDict];
-        for (ZMUpdateEvent *event in events) {
-            [event appendDebugInformation:@"From missing update events transcoder, processUpdateEventsAndReturnLastNotificationIDFromPayload"];
-            if (event.type == ZMUpdateEventCallState) {
-                lastCallStateEvents[event.conversationUUID] = event;
+    // Only the events of one chunk of notifications are alive at a time. The notification dictionaries of the whole page
+    // are still in memory, since the transport parses the response before we get it.
+    for(NSUInteger chunkStart = 0; chunkStart < eventsDictionaries.count; chunkStart += ZMMissingUpdateEventsTranscoderNotificationChunkSize) {
+        @autoreleasepool {
+            NSRange const chunkRange = NSMakeRange(chunkStart, MIN(ZMMissingUpdateEventsTranscoderNotificationChunkSize, eventsDictionaries.count - chunkStart));
+            NSMutableArray *parsedEvents = [NSMutableArray array];
+            for(NSDictionary *eventDict in [eventsDictionaries subarrayWithRange:chunkRange]) {
+                NSArray *events = [ZMUpdateEvent eventsArrayFromPushChannelData:eventDict];
+                for (ZMUpdateEvent *event in events) {
+                    [event appendDebugInformation:@"From missing update events transcoder, processUpdateEventsAndReturnLastNotificationIDFromPayload"];
+                    if (event.type == ZMUpdateEventCallState) {
+                        lastCallStateEvents[event.conversationUUID] = event;
+                    }
+                    else {
+                        [parsedEvents addObject:event];
+                    }
+                    latestEventId = event.uuid;
+                }
             }
-            else {
-                [parsedEvents addObject:event];
-            }
-            latestEventId = event.uuid;
+            [syncStrategy processDownloadedNotificationStreamEvents:parsedEvents];
         }
     }
     
-    [syncStrategy processUpdateEvents:parsedEvents ignoreBuffer:YES];
     [syncStrategy processUpdateEvents:lastCallStateEvents.allValues ignoreBuffer:NO];
     
     [tp warnIfLongerThanInterval];
@@ -29,6 +29,7 @@
 
 static NSString *UsersPath = @"/users";
 NSUInteger const ZMUserTranscoderNumberOfUUIDsPerRequest = 1600 / 25; // UUID as string is 24 + 1 for the comma
+static NSUInteger const ZMUserTranscoderMaximumNumberOfRequestsInFlight = 4;
 
 
 @interface ZMUserTranscoder ()
@@ -51,6 +52,7 @@ NSUInteger const ZMUserTranscoderNumberOfUUIDsPerRequest = 1600 / 25; // UUID as
     self = [super initWithManagedObjectContext:moc];
     if (self) {
         self.remoteIDObjectSync = [[ZMRemoteIdentifierObjectSync alloc] initWithTranscoder:self managedObjectContext:self.managedObjectContext];
+        self.remoteIDObjectSync.maximumNumberOfBatchesInFlight = ZMUserTranscoderMaximumNumberOfRequestsInFlight;
     }
     return self;
 }
@@ -117,6 +119,11 @@ NSUInteger const ZMUserTranscoderNumberOfUUIDsPerRequest = 1600 / 25; // UUID as
     }
 }
 
+- (NSSet *)trackedEntityNames
+{
+    return [NSSet setWithObject:ZMUser.entityName];
+}
+
 - (void)updateUsersFromPayload:(NSArray *)userPayload expectedRemoteIdentifiers:(NSSet *)expectedRemoteIdentifiers;
 {
     NSMutableSet *usersToReset = [expectedRemoteIdentifiers mutableCopy];
@@ -0,0 +1,84 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+import Foundation
+
+private let zmLog = ZMSLog(tag: "UserClient")
+
+// MARK: - Missing clients
+extension UserClient {
+    
+    /**
+    Creates sessions with all the given clients in one transaction on the box: the box is locked once,
+    and the new sessions are saved together at the end.
+    
+    - returns: the clients for which the session could not be created
+    */
+    public func establishSessionsWithClients(preKeysByClient: [UserClient : String]) -> Set<UserClient> {
+        guard !preKeysByClient.isEmpty else { return Set() }
+        guard isSelfClient() else { return Set(preKeysByClient.keys) }
+        
+        let box = self.keysStore.box
+        var failedClients = Set<UserClient>()
+        
+        objc_sync_enter(box)
+        defer { objc_sync_exit(box) }
+        
+        for (client, preKeyString) in preKeysByClient {
+            guard let remoteIdentifier = client.remoteIdentifier else {
+                failedClients.insert(client)
+                continue
+            }
+            do {
+                let session = try box.sessionWithId(remoteIdentifier, fromStringPreKey: preKeyString)
+                box.setSessionToRequireSave(session)
+            } catch let error {
+                zmLog.error("Failed to establish session with client \(remoteIdentifier): \(error)")
+                failedClients.insert(client)
+            }
+        }
+        box.saveSessionsRequiringSave()
+        return failedClients
+    }
+    
+    /// Removes the clients from the missing clients of this client and from the missing recipients of the messages that miss them.
+    /// Each message is updated once with all of its recipients that are removed.
+    public func removeMissingClients(clients: Set<UserClient>) {
+        guard !clients.isEmpty else { return }
+        
+        var recipientsByMessage = [ZMOTRMessage : Set<UserClient>]()
+        for client in clients {
+            guard let messagesMissingRecipient = client.messagesMissingRecipient else { continue }
+            for message in messagesMissingRecipient {
+                if let message = message as? ZMOTRMessage {
+                    recipientsByMessage[message] = (recipientsByMessage[message] ?? Set()).union([client])
+                }
+                else {
+                    client.mutableSetValueForKey("messagesMissingRecipient").removeObject(message)
+                }
+            }
+        }
+        for (message, recipients) in recipientsByMessage {
+            message.doesNotMissRecipients(recipients)
+        }
+        for client in clients {
+            self.removeMissingClient(client)
+        }
+    }
+}
@@ -24,6 +24,10 @@
 
 @interface ZMAddressBookSync ()
 
-- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc addressBook:(ZMAddressBook *)addressBook addressBookUpload:(ZMSingleRequestSync *)addressBookUpload NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc addressBook:(ZMAddressBook *)addressBook addressBookUpload:(ZMSingleRequestSync *)addressBookUpload;
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc addressBook:(ZMAddressBook *)addressBook addressBookUpload:(ZMSingleRequestSync *)addressBookUpload manifestURL:(NSURL *)manifestURL NS_DESIGNATED_INITIALIZER;
+
+/// The file that lists the cards the backend has
+@property (nonatomic, readonly) NSURL *manifestURL;
 
 @end
@@ -28,6 +28,11 @@
 
 - (ZMTransportRequest *)nextRequest;
 
+/// When set, only the cards that were added since the last upload are sent to the backend.
+/// Off by default, since the onboarding endpoint does not accept delta uploads yet.
+/// Can be turned on with the user default @c ZMAddressBookDeltaUploadEnabled.
+@property (nonatomic) BOOL usesDeltaUploads;
+
 @end
 
 
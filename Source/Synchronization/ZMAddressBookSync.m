@@ -31,6 +31,9 @@
 
 static NSString * const ZMAddressBookTranscoderNeedsToBeUploadedKey = @"ZMAddressBookTranscoderNeedsToBeUploaded";
 static NSString * const ZMOnboardingEndpoint = @"/onboarding/v2";
+static NSString * const ZMAddressBookDeltaUploadEnabledKey = @"ZMAddressBookDeltaUploadEnabled";
+/// Upper bound for the number of cards in a single delta upload
+static NSUInteger const MaximumCardsPerDeltaUpload = 500;
 
 
 @interface ZMAddressBookSync ()
@@ -39,6 +42,10 @@ static NSString * const ZMOnboardingEndpoint = @"/onboarding/v2";
 @property (nonatomic) BOOL isGeneratingPayload;
 @property (nonatomic) ZMEncodedAddressBook *encodedAddressBook;
 @property (nonatomic) ZMAddressBook *addressBook;
+/// The payloads of a delta upload that have not been sent yet. Nil when the whole address book is uploaded.
+@property (nonatomic) NSMutableArray<NSDictionary *> *pendingDeltaPayloads;
+/// Set when the backend rejected a delta upload, after which only whole address books are uploaded
+@property (nonatomic) BOOL deltaUploadWasRejected;
 
 @end
 
@@ -57,6 +64,16 @@ static NSString * const ZMOnboardingEndpoint = @"/onboarding/v2";
 
 
 
+@interface ZMAddressBookSync (Manifest)
+
+/// The digests of the cards the backend has, i.e. the manifest the next delta upload is computed against.
+/// Nil if it is not known, in which case the whole address book is uploaded.
+@property (nonatomic, copy) NSArray<NSString *> *uploadedCardDigests;
+
+@end
+
+
+
 @interface ZMAddressBookSync (RequestTranscoder) <ZMSingleRequestTranscoder>
 @end
 
@@ -75,15 +92,31 @@ static NSString * const ZMOnboardingEndpoint = @"/onboarding/v2";
 }
 
 - (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc addressBook:(ZMAddressBook *)addressBook addressBookUpload:(ZMSingleRequestSync *)addressBookUpload;
+{
+    return [self initWithManagedObjectContext:moc addressBook:addressBook addressBookUpload:addressBookUpload manifestURL:[self.class manifestURLForContext:moc]];
+}
+
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc addressBook:(ZMAddressBook *)addressBook addressBookUpload:(ZMSingleRequestSync *)addressBookUpload manifestURL:(NSURL *)manifestURL;
 {
     self = [super initWithManagedObjectContext:moc];
     if (self != nil) {
         self.addressBook = addressBook;
         self.addressBookUpload = addressBookUpload ?: [[ZMSingleRequestSync alloc] initWithSingleRequestTranscoder:self managedObjectContext:self.managedObjectContext];
+        _manifestURL = manifestURL;
+        self.usesDeltaUploads = [[NSUserDefaults standardUserDefaults] boolForKey:ZMAddressBookDeltaUploadEnabledKey];
     }
     return self;
 }
 
+/// The manifest is kept next to the database of the user, like the update events journal.
+/// It is shared by all address book syncs, since each of them replaces the cards the backend has.
++ (NSURL *)manifestURLForContext:(NSManagedObjectContext *)moc;
+{
+    NSURL *storeURL = moc.persistentStoreCoordinator.persistentStores.firstObject.URL;
+    NSURL *directory = storeURL.isFileURL ? storeURL.URLByDeletingLastPathComponent : [[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask].firstObject;
+    return [directory URLByAppendingPathComponent:@"ZMAddressBookSync.manifest"];
+}
+
 @synthesize addressBook = _addressBook;
 
 - (ZMAddressBook *)addressBook;
@@ -116,6 +149,7 @@ static NSString * const ZMOnboardingEndpoint = @"/onboarding/v2";
     [encoder createPayloadWithCompletionHandler:^(ZMEncodedAddressBook *encoded) {
         if (! [self.uploadedAddressBookDigest isEqual:encoded.digest]) {
             self.encodedAddressBook = encoded;
+            self.pendingDeltaPayloads = [self deltaPayloadsForEncodedAddressBook:encoded];
             [self.addressBookUpload readyForNextRequest];
             [ZMOperationLoop notifyNewRequestsAvailable:self];
         };
@@ -125,6 +159,52 @@ static NSString * const ZMOnboardingEndpoint = @"/onboarding/v2";
     return nil;
 }
 
+/// Splits the cards that were added since the last upload into payloads of at most MaximumCardsPerDeltaUpload cards.
+/// Added cards are identified by their digest, so that the manifest can refer to them.
+/// Returns nil if the whole address book has to be uploaded: when delta uploads are off, when there is no manifest,
+/// or when cards were removed. The backend does not tell which card a match belongs to, so only a whole upload
+/// can drop the suggested users of removed cards.
+- (NSMutableArray<NSDictionary *> *)deltaPayloadsForEncodedAddressBook:(ZMEncodedAddressBook *)encoded;
+{
+    if (! self.usesDeltaUploads || self.deltaUploadWasRejected) {
+        return nil;
+    }
+    NSArray *uploadedCardDigests = self.uploadedCardDigests;
+    if (uploadedCardDigests == nil) {
+        return nil;
+    }
+    
+    NSSet *currentDigests = [NSSet setWithArray:encoded.cardDigests ?: @[]];
+    for (NSString *cardDigest in uploadedCardDigests) {
+        if (! [currentDigests containsObject:cardDigest]) {
+            return nil;
+        }
+    }
+    
+    NSSet *uploadedDigests = [NSSet setWithArray:uploadedCardDigests];
+    NSMutableSet *addedDigests = [NSMutableSet set];
+    NSMutableArray *addedCards = [NSMutableArray array];
+    NSArray *cards = (NSArray *) encoded.otherData;
+    [encoded.cardDigests enumerateObjectsUsingBlock:^(NSString *cardDigest, NSUInteger idx, BOOL * __unused stop) {
+        if ([uploadedDigests containsObject:cardDigest] || [addedDigests containsObject:cardDigest]) {
+            return;
+        }
+        [addedDigests addObject:cardDigest];
+        [addedCards addObject:@{@"card_id": cardDigest, @"contact": cards[idx][@"contact"]}];
+    }];
+    
+    // There is always at least one payload, since the self hashes might have changed
+    NSMutableArray *payloads = [NSMutableArray array];
+    NSUInteger index = 0;
+    do {
+        NSRange range = NSMakeRange(index, MIN(addedCards.count - index, MaximumCardsPerDeltaUpload));
+        [payloads addObject:@{@"self": encoded.localData ?: @[],
+                              @"cards_added": [addedCards subarrayWithRange:range],}];
+        index = NSMaxRange(range);
+    } while (index < addedCards.count);
+    return payloads;
+}
+
 @end
 
 
@@ -134,6 +214,10 @@ static NSString * const ZMOnboardingEndpoint = @"/onboarding/v2";
 - (ZMTransportRequest *)requestForSingleRequestSync:(ZMSingleRequestSync *)sync;
 {
     VerifyReturnNil(sync == self.addressBookUpload);
+    NSDictionary *deltaPayload = self.pendingDeltaPayloads.firstObject;
+    if (deltaPayload != nil) {
+        return [ZMTransportRequest requestWithPath:ZMOnboardingEndpoint method:ZMMethodPOST payload:deltaPayload shouldCompress:YES];
+    }
     NSDictionary *payload = @{@"self": self.encodedAddressBook.localData ?: @[],
                               @"cards": self.encodedAddressBook.otherData ?: @[],};
     return [ZMTransportRequest requestWithPath:ZMOnboardingEndpoint method:ZMMethodPOST payload:payload shouldCompress:YES];
@@ -141,20 +225,77 @@ static NSString * const ZMOnboardingEndpoint = @"/onboarding/v2";
 
 - (void)didReceiveResponse:(ZMTransportResponse *)response forSingleRequest:(ZMSingleRequestSync * __unused)sync
 {
+    NSDictionary *deltaPayload = self.pendingDeltaPayloads.firstObject;
+    if (deltaPayload != nil) {
+        [self didReceiveResponse:response forDeltaPayload:deltaPayload];
+        return;
+    }
+    
     if (response.result == ZMTransportResponseStatusSuccess) {
-        NSArray *remoteIdentifiersAsStrings = [[response.payload asDictionary] arrayForKey:@"results"];
-        NSArray *remoteIdentifiers = [remoteIdentifiersAsStrings mapWithBlock:^id(NSString *s) {
-            return s.UUID;
-        }];
-        
-        self.managedObjectContext.suggestedUsersForUser = [NSOrderedSet orderedSetWithArray:remoteIdentifiers];
+        self.managedObjectContext.suggestedUsersForUser = [NSOrderedSet orderedSetWithArray:[self remoteIdentifiersInResponse:response]];
         self.managedObjectContext.commonConnectionsForUsers = @{};
+        // The backend now has exactly these cards. Without delta uploads there is nothing the manifest would be used for.
+        self.uploadedCardDigests = self.usesDeltaUploads ? [NSOrderedSet orderedSetWithArray:self.encodedAddressBook.cardDigests ?: @[]].array : nil;
     }
     self.uploadedAddressBookDigest = self.encodedAddressBook.digest;
     self.encodedAddressBook = nil;
     [self clearAddressBookAsNeedingToBeUploaded];
 }
 
+- (void)didReceiveResponse:(ZMTransportResponse *)response forDeltaPayload:(NSDictionary *)deltaPayload;
+{
+    switch (response.result) {
+        case ZMTransportResponseStatusSuccess:
+        {
+            // The results of a delta upload only contain the matches of the cards it added
+            NSMutableOrderedSet *suggestedUsers = [self.managedObjectContext.suggestedUsersForUser mutableCopy] ?: [NSMutableOrderedSet orderedSet];
+            [suggestedUsers addObjectsFromArray:[self remoteIdentifiersInResponse:response]];
+            self.managedObjectContext.suggestedUsersForUser = suggestedUsers;
+            
+            [self.pendingDeltaPayloads removeObjectAtIndex:0];
+            NSArray *addedCardDigests = [deltaPayload[@"cards_added"] mapWithBlock:^id(NSDictionary *card) {
+                return card[@"card_id"];
+            }];
+            self.uploadedCardDigests = [(self.uploadedCardDigests ?: @[]) arrayByAddingObjectsFromArray:addedCardDigests];
+            if (self.pendingDeltaPayloads.count > 0) {
+                [self.addressBookUpload readyForNextRequest];
+                [ZMOperationLoop notifyNewRequestsAvailable:self];
+                return;
+            }
+            self.uploadedAddressBookDigest = self.encodedAddressBook.digest;
+            break;
+        }
+        case ZMTransportResponseStatusPermanentError:
+        {
+            // The backend does not accept deltas, so we upload the whole address book right away and stop sending deltas
+            ZMLogWarn(@"Delta upload of the address book was rejected, uploading all of it");
+            self.deltaUploadWasRejected = YES;
+            self.pendingDeltaPayloads = nil;
+            self.uploadedCardDigests = nil;
+            [self.addressBookUpload readyForNextRequest];
+            [ZMOperationLoop notifyNewRequestsAvailable:self];
+            return;
+        }
+        default:
+        {
+            // The manifest still lists the cards of the payloads that were accepted, so the next upload continues from there.
+            // The address book digest is not updated, so that the next upload is not skipped.
+            break;
+        }
+    }
+    self.pendingDeltaPayloads = nil;
+    self.encodedAddressBook = nil;
+    [self clearAddressBookAsNeedingToBeUploaded];
+}
+
+- (NSArray<NSUUID *> *)remoteIdentifiersInResponse:(ZMTransportResponse *)response;
+{
+    NSArray *remoteIdentifiersAsStrings = [[response.payload asDictionary] arrayForKey:@"results"];
+    return [remoteIdentifiersAsStrings mapWithBlock:^id(NSString *s) {
+        return s.UUID;
+    }];
+}
+
 @end
 
 
@@ -219,3 +360,40 @@ static NSString * const ZMOnboardingEndpoint = @"/onboarding/v2";
 }
 
 @end
+
+
+
+@implementation ZMAddressBookSync (Manifest)
+
+- (NSArray<NSString *> *)uploadedCardDigests;
+{
+    if (self.manifestURL == nil) {
+        return nil;
+    }
+    NSData *data = [NSData dataWithContentsOfURL:self.manifestURL];
+    if (data == nil) {
+        return nil;
+    }
+    NSArray *cardDigests = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:NULL error:NULL];
+    return [cardDigests isKindOfClass:NSArray.class] ? cardDigests : nil;
+}
+
+- (void)setUploadedCardDigests:(NSArray<NSString *> *)cardDigests;
+{
+    if (self.manifestURL == nil) {
+        return;
+    }
+    if (cardDigests == nil) {
+        [[NSFileManager defaultManager] removeItemAtURL:self.manifestURL error:NULL];
+        return;
+    }
+    NSError *error;
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:cardDigests format:NSPropertyListBinaryFormat_v1_0 options:0 error:&error];
+    if (data == nil || ! [data writeToURL:self.manifestURL options:NSDataWritingAtomic | NSDataWritingFileProtectionCompleteUntilFirstUserAuthentication error:&error]) {
+        ZMLogWarn(@"Failed to write address book manifest: %@", error);
+        // A stale manifest would make the next delta wrong
+        [[NSFileManager defaultManager] removeItemAtURL:self.manifestURL error:NULL];
+    }
+}
+
+@end
@@ -194,6 +194,11 @@ _Pragma("clang diagnostic pop")
     }
 }
 
+- (NSSet *)trackedEntityNames
+{
+    return [NSSet setWithObject:ZMConversation.entityName];
+}
+
 -(void)addTrackedObjects:(NSSet *)objects
 {
     NOT_USED(objects);
@@ -0,0 +1,37 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import Foundation;
+
+@protocol ZMContextChangeTracker;
+
+
+/// This class partitions the objects of a save by entity and only passes each change tracker the objects it is interested in.
+/// Change trackers declare their entities (and optionally keys) with -trackedEntityNames and -trackedLocallyModifiedKeys.
+/// Change trackers that don't declare any entities get all changed objects.
+@interface ZMChangeTrackerRegistry : NSObject
+
+- (instancetype)initWithChangeTrackers:(NSArray *)changeTrackers;
+
+@property (nonatomic, readonly, copy) NSArray *changeTrackers;
+
+/// Calls -objectsDidChange: on all change trackers, in the order they were passed in, with the objects they are tracking.
+- (void)objectsDidChange:(NSSet *)objects;
+
+@end
@@ -0,0 +1,155 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMUtilities;
+@import ZMCDataModel;
+
+#import "ZMChangeTrackerRegistry+Testing.h"
+#import "ZMContextChangeTracker.h"
+
+
+@interface ZMChangeTrackerRegistration : NSObject
+
+@property (nonatomic, readonly) id<ZMContextChangeTracker> tracker;
+@property (nonatomic, readonly, copy) NSSet *entityNames; ///< nil for trackers that want all objects
+@property (nonatomic, readonly, copy) NSSet *keys;
+
+@end
+
+
+
+@implementation ZMChangeTrackerRegistration
+
+- (instancetype)initWithTracker:(id<ZMContextChangeTracker>)tracker
+{
+    self = [super init];
+    if (self) {
+        _tracker = tracker;
+        if ([tracker respondsToSelector:@selector(trackedEntityNames)]) {
+            _entityNames = [[tracker trackedEntityNames] copy];
+            RequireString(_entityNames.count > 0, "Change tracker %s declares no entities", NSStringFromClass([(NSObject *)tracker class]).UTF8String);
+            if ([tracker respondsToSelector:@selector(trackedLocallyModifiedKeys)]) {
+                _keys = [[tracker trackedLocallyModifiedKeys] copy];
+            }
+        }
+    }
+    return self;
+}
+
+- (NSSet *)objectsForTrackerFromObjectsByEntityName:(NSDictionary *)objectsByEntityName
+{
+    NSMutableSet *objects;
+    for (NSString *entityName in self.entityNames) {
+        NSSet *objectsForEntity = objectsByEntityName[entityName];
+        if (objectsForEntity.count == 0) {
+            continue;
+        }
+        if (objects == nil) {
+            objects = [NSMutableSet setWithCapacity:objectsForEntity.count];
+        }
+        [objects unionSet:objectsForEntity];
+    }
+    
+    if (objects.count == 0 || self.keys == nil) {
+        return objects;
+    }
+    
+    return [objects objectsPassingTest:^BOOL(ZMManagedObject *mo, BOOL * __unused stop) {
+        return [mo.keysThatHaveLocalModifications intersectsSet:self.keys];
+    }];
+}
+
+@end
+
+
+
+@interface ZMChangeTrackerRegistry ()
+
+@property (nonatomic, copy) NSArray *registrations;
+@property (nonatomic) BOOL hasEntityTrackers;
+
+@end
+
+
+
+@implementation ZMChangeTrackerRegistry
+
+- (instancetype)initWithChangeTrackers:(NSArray *)changeTrackers
+{
+    self = [super init];
+    if (self) {
+        _changeTrackers = [changeTrackers copy];
+        self.registrations = [changeTrackers mapWithBlock:^id(id<ZMContextChangeTracker> tracker) {
+            return [[ZMChangeTrackerRegistration alloc] initWithTracker:tracker];
+        }];
+        self.hasEntityTrackers = [self.registrations firstObjectMatchingWithBlock:^BOOL(ZMChangeTrackerRegistration *registration) {
+            return registration.entityNames != nil;
+        }] != nil;
+    }
+    return self;
+}
+
+- (void)objectsDidChange:(NSSet *)objects
+{
+    if (objects.count == 0) {
+        return;
+    }
+    
+    NSDictionary *objectsByEntityName = self.hasEntityTrackers ? [self.class objectsByEntityName:objects] : nil;
+    
+    for (ZMChangeTrackerRegistration *registration in self.registrations) {
+        if (registration.entityNames == nil) {
+            [registration.tracker objectsDidChange:objects];
+            continue;
+        }
+        NSSet *trackedObjects = [registration objectsForTrackerFromObjectsByEntityName:objectsByEntityName];
+        if (trackedObjects.count > 0) {
+            [registration.tracker objectsDidChange:trackedObjects];
+        }
+    }
+}
+
+@end
+
+
+
+@implementation ZMChangeTrackerRegistry (Testing)
+
++ (NSDictionary *)objectsByEntityName:(NSSet *)objects
+{
+    NSMutableDictionary *objectsByEntityName = [NSMutableDictionary dictionary];
+    for (NSObject *object in objects) {
+        if (![object isKindOfClass:[NSManagedObject class]]) {
+            continue;
+        }
+        NSString *entityName = ((NSManagedObject *)object).entity.name;
+        if (entityName == nil) {
+            continue;
+        }
+        NSMutableSet *objectsForEntity = objectsByEntityName[entityName];
+        if (objectsForEntity == nil) {
+            objectsForEntity = [NSMutableSet set];
+            objectsByEntityName[entityName] = objectsForEntity;
+        }
+        [objectsForEntity addObject:object];
+    }
+    return objectsByEntityName;
+}
+
+@end
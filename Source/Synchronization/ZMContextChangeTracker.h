@@ -32,6 +32,19 @@ NS_ASSUME_NONNULL_BEGIN
 /// Adds tracked objects -- which have been retrieved by using the fetch request returned by -fetchRequestForTrackedObjects
 - (void)addTrackedObjects:(NSSet *)objects;
 
+@optional
+
+/// Names of the entities this tracker is interested in.
+///
+/// If implemented, -objectsDidChange: will only be called with objects of these entities (see ZMChangeTrackerRegistry).
+/// Trackers that do not implement this receive all changed objects.
+- (NSSet<NSString *> *)trackedEntityNames;
+
+/// Keys this tracker is interested in. Only used in combination with -trackedEntityNames.
+///
+/// If implemented, -objectsDidChange: will only be called with objects that have local modifications for at least one of these keys.
+- (NSSet<NSString *> *)trackedLocallyModifiedKeys;
+
 @end
 
 
@@ -24,6 +24,8 @@
 @interface ZMDependentObjects ()
 
 @property (nonatomic) NSMapTable *dependenciesToDependants;
+/// Reverse index of @c dependenciesToDependants. Every dependant maps to the dependencies it is registered with, in the order they were added.
+@property (nonatomic) NSMapTable *dependantsToDependencies;
 
 @end
 
@@ -36,6 +38,7 @@
     self = [super init];
     if (self) {
         self.dependenciesToDependants = [NSMapTable strongToStrongObjectsMapTable];
+        self.dependantsToDependencies = [NSMapTable strongToStrongObjectsMapTable];
     }
     return self;
 }
@@ -46,25 +49,27 @@
     VerifyReturn(dependency != nil);
     
     NSMutableOrderedSet *trackedDependants = [self.dependenciesToDependants objectForKey:dependency];
-    
     if (trackedDependants == nil) {
         [self.dependenciesToDependants setObject:[NSMutableOrderedSet orderedSetWithObject:dependantObject] forKey:dependency];
     } else {
         [trackedDependants addObject:dependantObject];
     }
+    
+    NSMutableOrderedSet *trackedDependencies = [self.dependantsToDependencies objectForKey:dependantObject];
+    if (trackedDependencies == nil) {
+        [self.dependantsToDependencies setObject:[NSMutableOrderedSet orderedSetWithObject:dependency] forKey:dependantObject];
+    } else {
+        [trackedDependencies addObject:dependency];
+    }
 }
 
 - (ZMManagedObject *)anyDependencyForObject:(ZMManagedObject *)dependant
 {
-    NSEnumerator *keyEnumbertor = [self.dependenciesToDependants keyEnumerator];
-    ZMManagedObject *dependency;
-    while ((dependency = keyEnumbertor.nextObject)) {
-        NSOrderedSet *dependencies = [self.dependenciesToDependants objectForKey:dependency];
-        if ([dependencies containsObject:dependant]) {
-            return dependency;
-        }
+    if (dependant == nil) {
+        return nil;
     }
-    return nil;
+    NSOrderedSet *dependencies = [self.dependantsToDependencies objectForKey:dependant];
+    return dependencies.firstObject;
 }
 
 - (void)enumerateManagedObjectsForDependency:(ZMManagedObject *)dependency withBlock:(BOOL(^)(ZMManagedObject *managedObject))block;
@@ -77,7 +82,9 @@
     NSMutableOrderedSet *remainingDependants = [NSMutableOrderedSet orderedSet];
     
     for (ZMManagedObject *mo in trackedDependants) {
-        if (! block(mo)) {
+        if (block(mo)) {
+            [self removeDependency:dependency fromDependant:mo];
+        } else {
             [remainingDependants addObject:mo];
         }
     }
@@ -88,4 +95,13 @@
     }
 }
 
+- (void)removeDependency:(ZMManagedObject *)dependency fromDependant:(ZMManagedObject *)dependant
+{
+    NSMutableOrderedSet *dependencies = [self.dependantsToDependencies objectForKey:dependant];
+    [dependencies removeObject:dependency];
+    if (dependencies.count == 0) {
+        [self.dependantsToDependencies removeObjectForKey:dependant];
+    }
+}
+
 @end
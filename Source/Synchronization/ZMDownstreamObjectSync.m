@@ -127,6 +127,11 @@
     }
 }
 
+- (NSSet *)trackedEntityNames
+{
+    return [NSSet setWithObject:self.entity.name];
+}
+
 - (ZMTransportRequest *)nextRequest;
 {
     id<ZMDownstreamTranscoder> transcoder = self.transcoder;
@@ -59,6 +59,11 @@
     [self.innerDownstreamSync objectsDidChange:whitelistedObjectsThatChanges];
 }
 
+- (NSSet *)trackedEntityNames
+{
+    return self.innerDownstreamSync.trackedEntityNames;
+}
+
 - (NSFetchRequest *)fetchRequestForTrackedObjects
 {
     // I don't want to fetch. Only objects that are whitelisted should go through
@@ -175,6 +175,11 @@ static const NSUInteger ConversationPriorityCount = 5;
     }
 }
 
+- (NSSet *)trackedEntityNames
+{
+    return [NSSet setWithObject:self.conversationEntity.name];
+}
+
 - (void)windowSizeChanged:(NSNotification *)note
 {
     ZMEventIDRange *window = [self windowFromVisibleWindowNotification:note];
@@ -92,40 +92,114 @@ extension ZMMessage {
         // but this is quite an edge case.
         let MaxDelayToConsiderForBlockingObject = Double(3 * 60); // 3 minutes
 
-        var blockingMessage : ZMMessage?
+        let index = PendingMessagesIndex.indexForConversation(conversation)
+        index.updateWithMessagesInConversation(conversation, notOlderThan: serverTimestamp?.dateByAddingTimeInterval(-MaxDelayToConsiderForBlockingObject) ?? NSDate.distantPast())
+        if shouldBlockFurtherMessages {
+            index.addMessage(self)
+        }
         
         // we don't want following messages to block this one, only previous ones.
-        // so we iterate backwards and we ignore everything until we find this one
-        var selfMessageFound = false
+        return index.previousBlockingMessage(self, inConversation: conversation, maximumDelay: MaxDelayToConsiderForBlockingObject)
+    }
+    
+}
+
+private var PendingMessagesIndexKey : UInt8 = 0
 
-        conversation.messages
-            .enumerateObjectsWithOptions(NSEnumerationOptions.Reverse) { (obj, _, stop) in
-                guard let previousMessage = obj as? ZMMessage else { return }
-                
-                if let currentTimestamp = self.serverTimestamp,
-                    let previousTimestamp = previousMessage.serverTimestamp {
-                    
-                    // to old?
-                    let tooOld = currentTimestamp.timeIntervalSinceDate(previousTimestamp) > MaxDelayToConsiderForBlockingObject
-                    if tooOld {
-                        stop.memory = true
-                        return
-                    }
-                }
-                
-                let sameMessage = previousMessage === self || previousMessage.nonce == self.nonce
-                if sameMessage {
-                    selfMessageFound = true
-                }
-                
-                if selfMessageFound && !sameMessage && previousMessage.shouldBlockFurtherMessages {
-                    blockingMessage = previousMessage
-                    stop.memory = true
-                }
+/// Per-conversation record of the outgoing messages that could block following messages.
+///
+/// The record is attached to the conversation. It remembers down to which timestamp it has scanned the conversation,
+/// independent of the message that was looked up. As long as messages are only appended, a lookup only walks the new messages,
+/// instead of enumerating `conversation.messages` back to the 3 minutes window every time. A lookup that needs older messages
+/// than were scanned, or a conversation whose messages were inserted or removed before the last scanned one (e.g. when they got
+/// re-sorted by server timestamp), is scanned again from the end.
+/// Messages that got delivered, expired or deleted in the meantime are dropped when the record is consulted.
+private final class PendingMessagesIndex : NSObject {
+    
+    private let pendingMessages = NSMutableSet()
+    private weak var lastScannedMessage : ZMMessage?
+    /// Number of messages in the conversation when it was last scanned
+    private var scannedMessageCount = 0
+    /// All messages that are not older than this were scanned
+    private var scannedSince = NSDate.distantFuture()
+    
+    static func indexForConversation(conversation: ZMConversation) -> PendingMessagesIndex {
+        if let index = objc_getAssociatedObject(conversation, &PendingMessagesIndexKey) as? PendingMessagesIndex {
+            return index
         }
-        return blockingMessage
+        let index = PendingMessagesIndex()
+        objc_setAssociatedObject(conversation, &PendingMessagesIndexKey, index, .OBJC_ASSOCIATION_RETAIN_NONATOMIC)
+        return index
+    }
+    
+    func addMessage(message: ZMMessage) {
+        pendingMessages.addObject(message)
+    }
+    
+    /// Makes sure that all messages in the conversation that are not older than `oldestTimestamp` were scanned
+    /// and records the ones that block further messages.
+    func updateWithMessagesInConversation(conversation: ZMConversation, notOlderThan oldestTimestamp: NSDate) {
+        let messages = conversation.messages
+        let onlyAppended = lastScannedMessage.map { messages.indexOfObject($0) == scannedMessageCount - 1 } ?? false
+        
+        if onlyAppended && oldestTimestamp.compare(scannedSince) != .OrderedAscending {
+            // everything from the last scanned message on was appended since, regardless of its timestamp
+            scanMessages(messages, from: messages.count - 1, downTo: scannedMessageCount, notOlderThan: NSDate.distantPast())
+        }
+        else {
+            pendingMessages.removeAllObjects()
+            scanMessages(messages, from: messages.count - 1, downTo: 0, notOlderThan: oldestTimestamp)
+            scannedSince = oldestTimestamp
+        }
+        lastScannedMessage = messages.lastObject as? ZMMessage
+        scannedMessageCount = messages.count
     }
     
+    private func scanMessages(messages: NSOrderedSet, from start: Int, downTo end: Int, notOlderThan oldestTimestamp: NSDate) {
+        guard start >= end else { return }
+        messages.enumerateObjectsAtIndexes(NSIndexSet(indexesInRange: NSMakeRange(end, start - end + 1)), options: .Reverse) { (obj, _, stop) in
+            guard let message = obj as? ZMMessage else { return }
+            
+            if let timestamp = message.serverTimestamp where timestamp.compare(oldestTimestamp) == .OrderedAscending {
+                stop.memory = true
+                return
+            }
+            if message.shouldBlockFurtherMessages {
+                self.pendingMessages.addObject(message)
+            }
+        }
+    }
+    
+    /// Returns the closest message before `message` in the conversation that is still blocking
+    func previousBlockingMessage(message: ZMMessage, inConversation conversation: ZMConversation, maximumDelay: NSTimeInterval) -> ZMMessage? {
+        let messages = conversation.messages
+        let position = messages.indexOfObject(message)
+        guard position != NSNotFound else { return nil }
+        
+        var blockingMessage : ZMMessage?
+        var blockingPosition = NSNotFound
+        
+        for case let pendingMessage as ZMMessage in pendingMessages.allObjects {
+            guard !pendingMessage.deleted && pendingMessage.conversation === conversation && pendingMessage.shouldBlockFurtherMessages else {
+                pendingMessages.removeObject(pendingMessage)
+                continue
+            }
+            if pendingMessage === message || pendingMessage.nonce == message.nonce {
+                continue
+            }
+            if let currentTimestamp = message.serverTimestamp, let pendingTimestamp = pendingMessage.serverTimestamp
+                where currentTimestamp.timeIntervalSinceDate(pendingTimestamp) > maximumDelay {
+                continue
+            }
+            let pendingPosition = messages.indexOfObject(pendingMessage)
+            if pendingPosition != NSNotFound && pendingPosition < position
+                && (blockingPosition == NSNotFound || pendingPosition > blockingPosition) {
+                blockingMessage = pendingMessage
+                blockingPosition = pendingPosition
+            }
+        }
+        return blockingMessage
+    }
 }
 
 extension ZMMessage : BlockingMessage {
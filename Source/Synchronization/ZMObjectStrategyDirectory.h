@@ -42,6 +42,7 @@
 @class ZMPhoneNumberVerificationTranscoder;
 @class ZMLoginCodeRequestTranscoder;
 @class ZMUserProfileUpdateTranscoder;
+@class ZMRequestScheduler;
 
 @protocol ZMUpdateEventsFlushableCollection;
 
@@ -76,6 +77,9 @@
 
 @property (nonatomic, readonly) NSManagedObjectContext *moc;
 
+/// Picks the next request among all transcoders and request strategies that are currently active
+@property (nonatomic, readonly) ZMRequestScheduler *requestScheduler;
+
 - (NSArray *)allTranscoders;
 
 - (NSArray *)conversationIdsThatHaveBufferedUpdatesForCallState;
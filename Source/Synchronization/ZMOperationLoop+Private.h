@@ -30,6 +30,12 @@
 @property (nonatomic) ZMSyncStrategy *syncStrategy;
 @property (nonatomic) NSManagedObjectContext *syncMOC;
 @property (nonatomic) BackgroundAPNSPingBackStatus *backgroundAPNSPingBackStatus;
+
+/// Number of times +notifyNewRequestsAvailable: reached this loop
+@property (nonatomic, readonly) uint64_t numberOfRequestedWakeUps;
+/// Number of times the loop actually asked the sync strategy for requests. Several wake ups are coalesced into one drain.
+@property (nonatomic, readonly) uint64_t numberOfDrains;
+
 @end
 
 
@@ -41,4 +47,8 @@
                                  syncMOC:(NSManagedObjectContext *)syncMOC
             backgroundAPNSPingBackStatus:(BackgroundAPNSPingBackStatus *)backgroundAPNSPingBackStatus;
 
++ (NSSet *)objectSetFromObjectIDs:(NSSet<NSManagedObjectID *> *)objectIDs
+                        inContext:(NSManagedObjectContext *)moc
+relationshipKeyPathsForPrefetching:(NSDictionary<NSString *, NSSet<NSString *> *> *)relationshipKeyPathsByEntityName;
+
 @end
@@ -46,10 +46,12 @@ static char* const ZMLogTag ZM_UNUSED = "OperationLoop";
 
 @interface ZMOperationLoop ()
 {
-    int32_t _pendingEnqueueNextCount;
+    /// 1 while a drain is scheduled on the sync context and has not started yet
+    volatile int32_t _isDrainScheduled;
+    volatile int64_t _numberOfRequestedWakeUps;
+    volatile int64_t _numberOfDrains;
 }
 
-@property (nonatomic) NSNotificationQueue *enqueueNotificationQueue;
 @property (nonatomic) ZMTransportSession *transportSession;
 @property (atomic) BOOL shouldStopEnqueueing;
 @property (nonatomic) BOOL ownsSyncStrategy;
@@ -212,30 +214,89 @@ static char* const ZMLogTag ZM_UNUSED = "OperationLoop";
     return objectIds;
 }
 
-+ (NSSet *)objectSetFromObjectIDs:(NSSet *)objectIDs inContext:(NSManagedObjectContext *)moc
+/// Returns the objects for the given object IDs. Instead of faulting the objects in one by one, the object IDs are grouped by
+/// entity and each entity is fetched with a single request, optionally prefetching relationships.
+/// Objects that do not exist (anymore) in @c moc are not returned.
++ (NSSet *)objectSetFromObjectIDs:(NSSet<NSManagedObjectID *> *)objectIDs
+                        inContext:(NSManagedObjectContext *)moc
+relationshipKeyPathsForPrefetching:(NSDictionary<NSString *, NSSet<NSString *> *> *)relationshipKeyPathsByEntityName
 {
-    NSMutableSet *objects = [NSMutableSet set];
-    for(NSManagedObjectID *objId in objectIDs) {
-        NSManagedObject *obj = [moc objectWithID:objId];
-        if(obj) {
-            [objects addObject:obj];
+    NSMutableDictionary<NSString *, NSMutableArray<NSManagedObjectID *> *> *objectIDsByEntityName = [NSMutableDictionary dictionary];
+    for (NSManagedObjectID *objectID in objectIDs) {
+        NSString *entityName = objectID.entity.name;
+        NSMutableArray *objectIDsOfEntity = objectIDsByEntityName[entityName];
+        if (objectIDsOfEntity == nil) {
+            objectIDsOfEntity = [NSMutableArray array];
+            objectIDsByEntityName[entityName] = objectIDsOfEntity;
         }
+        [objectIDsOfEntity addObject:objectID];
     }
+    
+    NSMutableSet *objects = [NSMutableSet setWithCapacity:objectIDs.count];
+    [objectIDsByEntityName enumerateKeysAndObjectsUsingBlock:^(NSString *entityName, NSArray<NSManagedObjectID *> *objectIDsOfEntity, BOOL * __unused stop) {
+        NSFetchRequest *request = [NSFetchRequest fetchRequestWithEntityName:entityName];
+        request.predicate = [NSPredicate predicateWithFormat:@"self IN %@", objectIDsOfEntity];
+        request.returnsObjectsAsFaults = NO;
+        request.relationshipKeyPathsForPrefetching = relationshipKeyPathsByEntityName[entityName].allObjects;
+        [objects addObjectsFromArray:[moc executeFetchRequestOrAssert:request]];
+    }];
     return objects;
 }
 
+/// The relationships that have local modifications, by entity. Those are the relationships the change trackers are going to look at.
++ (NSDictionary<NSString *, NSSet<NSString *> *> *)locallyModifiedRelationshipsByEntityNameForObjects:(NSSet *)objects
+{
+    NSMutableDictionary<NSString *, NSMutableSet<NSString *> *> *relationshipsByEntityName = [NSMutableDictionary dictionary];
+    for (NSManagedObject *object in objects) {
+        if (![object isKindOfClass:ZMManagedObject.class]) {
+            continue;
+        }
+        NSSet *modifiedKeys = [(ZMManagedObject *)object keysThatHaveLocalModifications];
+        if (modifiedKeys.count == 0) {
+            continue;
+        }
+        NSDictionary *relationshipsByName = object.entity.relationshipsByName;
+        for (NSString *key in modifiedKeys) {
+            if (relationshipsByName[key] == nil) {
+                continue;
+            }
+            NSMutableSet *relationships = relationshipsByEntityName[object.entity.name];
+            if (relationships == nil) {
+                relationships = [NSMutableSet set];
+                relationshipsByEntityName[object.entity.name] = relationships;
+            }
+            [relationships addObject:key];
+        }
+    }
+    return relationshipsByEntityName;
+}
+
 - (void)userInterfaceContextDidSave:(NSNotification *)note
 {
-    NSSet *insertedObjectsIDs = [ZMOperationLoop objectIDsetFromObject:note.userInfo[NSInsertedObjectsKey]];
-    NSSet *updatedObjectsIDs = [ZMOperationLoop objectIDsetFromObject:note.userInfo[NSUpdatedObjectsKey]];
+    NSSet *insertedObjects = note.userInfo[NSInsertedObjectsKey];
+    NSSet *updatedObjects = note.userInfo[NSUpdatedObjectsKey];
+    NSSet *insertedObjectsIDs = [ZMOperationLoop objectIDsetFromObject:insertedObjects];
+    NSSet *updatedObjectsIDs = [ZMOperationLoop objectIDsetFromObject:updatedObjects];
+    NSMutableSet *savedObjects = [NSMutableSet setWithSet:insertedObjects ?: [NSSet set]];
+    [savedObjects unionSet:updatedObjects ?: [NSSet set]];
+    NSDictionary *relationshipsToPrefetch = [ZMOperationLoop locallyModifiedRelationshipsByEntityNameForObjects:savedObjects];
     
     // We need to proceed even if those to sets are empty because the metadata might have been updated.
     
     ZM_WEAK(self);
     [self.syncMOC performGroupedBlock:^{
         ZM_STRONG(self);
-        NSSet *syncInsertedObjects = [ZMOperationLoop objectSetFromObjectIDs:insertedObjectsIDs inContext:self.syncStrategy.syncMOC];
-        NSSet *syncUpdatedObjects = [ZMOperationLoop objectSetFromObjectIDs:updatedObjectsIDs inContext:self.syncStrategy.syncMOC];
+        NSSet *allObjectIDs = [insertedObjectsIDs setByAddingObjectsFromSet:updatedObjectsIDs];
+        NSSet *allSyncObjects = [ZMOperationLoop objectSetFromObjectIDs:allObjectIDs inContext:self.syncStrategy.syncMOC relationshipKeyPathsForPrefetching:relationshipsToPrefetch];
+        NSMutableSet *syncInsertedObjects = [NSMutableSet set];
+        NSMutableSet *syncUpdatedObjects = [NSMutableSet set];
+        for (NSManagedObject *object in allSyncObjects) {
+            if ([insertedObjectsIDs containsObject:object.objectID]) {
+                [syncInsertedObjects addObject:object];
+            } else {
+                [syncUpdatedObjects addObject:object];
+            }
+        }
         
         [self.syncStrategy processSaveWithInsertedObjects:syncInsertedObjects updateObjects:syncUpdatedObjects];
         [self.class notifyNewRequestsAvailable:self];
@@ -262,7 +323,40 @@ static char* const ZMLogTag ZM_UNUSED = "OperationLoop";
 - (void)handleNewRequestAvailable:(NSNotification *)note
 {
     NOT_USED(note);
-    [self executeNextOperation];
+    [self scheduleDrain];
+}
+
+/// Notifications about new requests arrive from every completion handler and every save, often many per run loop turn.
+/// They only mark the loop as dirty: a single drain is scheduled on the sync context and all notifications that arrive
+/// before it starts are handled by that drain.
+- (void)scheduleDrain
+{
+    OSAtomicIncrement64Barrier(&_numberOfRequestedWakeUps);
+    if (! OSAtomicCompareAndSwap32Barrier(0, 1, &_isDrainScheduled)) {
+        return;
+    }
+    
+    ZM_WEAK(self);
+    [self.syncMOC performGroupedBlock:^{
+        ZM_STRONG(self);
+        if (self == nil) {
+            return;
+        }
+        // Clear the flag before draining, so that a notification that arrives while draining schedules another drain
+        OSAtomicCompareAndSwap32Barrier(1, 0, &self->_isDrainScheduled);
+        OSAtomicIncrement64Barrier(&self->_numberOfDrains);
+        [self executeNextOperation];
+    }];
+}
+
+- (uint64_t)numberOfRequestedWakeUps
+{
+    return (uint64_t) _numberOfRequestedWakeUps;
+}
+
+- (uint64_t)numberOfDrains
+{
+    return (uint64_t) _numberOfDrains;
 }
 
 - (ZMTransportRequestGenerator)requestGenerator {
@@ -295,11 +389,10 @@ static char* const ZMLogTag ZM_UNUSED = "OperationLoop";
     
 }
 
+/// Must be called on the sync context's queue
 - (void)executeNextOperation
 {
-    [self.syncMOC performGroupedBlock:^{
-        [self.syncStrategy dataDidChange];
-    }];
+    [self.syncStrategy dataDidChange];
     
     if (self.shouldStopEnqueueing) {
         return;
@@ -309,16 +402,12 @@ static char* const ZMLogTag ZM_UNUSED = "OperationLoop";
     ZMTransportRequestGenerator generator = [self requestGenerator];
     
     ZMBackgroundActivity * const enqueueActivity = [ZMBackgroundActivity beginBackgroundActivityWithName:@"executeNextOperation"];
-    ZM_WEAK(self);
-    [self.syncMOC performGroupedBlock:^{
-        ZM_STRONG(self);
-        BOOL enqueueMore = YES;
-        while (self && enqueueMore && !self.shouldStopEnqueueing) {
-            ZMTransportEnqueueResult *result = [self.transportSession attemptToEnqueueSyncRequestWithGenerator:generator];
-            enqueueMore = result.didGenerateNonNullRequest && result.didHaveLessRequestThanMax;
-        }
-        [enqueueActivity endActivity];
-    }];
+    BOOL enqueueMore = YES;
+    while (enqueueMore && !self.shouldStopEnqueueing) {
+        ZMTransportEnqueueResult *result = [self.transportSession attemptToEnqueueSyncRequestWithGenerator:generator];
+        enqueueMore = result.didGenerateNonNullRequest && result.didHaveLessRequestThanMax;
+    }
+    [enqueueActivity endActivity];
 }
 
 - (void)accessTokenDidChangeWithToken:(NSString *)token ofType:(NSString *)type;
@@ -35,10 +35,25 @@
 
 
 
+extern NSUInteger const ZMRemoteIdentifierObjectSyncDefaultMaximumNumberOfBatchesInFlight;
+extern NSUInteger const ZMRemoteIdentifierObjectSyncDefaultMaximumNumberOfAttemptsPerBatch;
+
+
+
 @interface ZMRemoteIdentifierObjectSync : NSObject
 
 - (instancetype)initWithTranscoder:(id<ZMRemoteIdentifierObjectTranscoder>)transcoder managedObjectContext:(NSManagedObjectContext *)moc;
 
+/// The number of batches (requests) that can be in flight at the same time. -nextRequest returns nil while this window is full.
+/// Not limited by default.
+@property (nonatomic) NSUInteger maximumNumberOfBatchesInFlight;
+
+/// The number of times a batch is sent before it is given up on when it keeps failing with a temporary error or expiring.
+/// Batches that fail with "try again later" are retried until they succeed.
+@property (nonatomic) NSUInteger maximumNumberOfAttemptsPerBatch;
+
+@property (nonatomic, readonly) NSUInteger numberOfBatchesInFlight;
+
 - (ZMTransportRequest *)nextRequest;
 
 - (void)setRemoteIdentifiersAsNeedingDownload:(NSSet<NSUUID *> *)remoteIdentifiers;
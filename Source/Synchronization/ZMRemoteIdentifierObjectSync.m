@@ -17,18 +17,57 @@
 // 
 
 
+@import ZMUtilities;
 @import ZMTransport;
 @import ZMCDataModel;
 
 #import "ZMRemoteIdentifierObjectSync.h"
+#import "ZMOperationLoop.h"
+#import "ZMSortedUUIDSet.h"
+
+static char* const ZMLogTag ZM_UNUSED = "RemoteIdentifierObjectSync";
+
+NSUInteger const ZMRemoteIdentifierObjectSyncDefaultMaximumNumberOfBatchesInFlight = NSUIntegerMax;
+NSUInteger const ZMRemoteIdentifierObjectSyncDefaultMaximumNumberOfAttemptsPerBatch = 3;
+
+
+
+/// A set of remote identifiers that is requested together. A batch keeps its identifiers when it gets retried.
+@interface ZMRemoteIdentifierObjectSyncBatch : NSObject
+
+- (instancetype)initWithRemoteIdentifiers:(NSSet<NSUUID *> *)remoteIdentifiers;
+
+@property (nonatomic, readonly) NSSet<NSUUID *> *remoteIdentifiers;
+@property (nonatomic) NSUInteger numberOfAttempts;
+
+@end
+
+
+
+@implementation ZMRemoteIdentifierObjectSyncBatch
+
+- (instancetype)initWithRemoteIdentifiers:(NSSet<NSUUID *> *)remoteIdentifiers;
+{
+    self = [super init];
+    if (self) {
+        _remoteIdentifiers = [remoteIdentifiers copy];
+    }
+    return self;
+}
+
+@end
+
+
 
 @interface ZMRemoteIdentifierObjectSync ()
 
 @property (nonatomic, weak) id <ZMRemoteIdentifierObjectTranscoder> transcoder;
 @property (nonatomic) NSManagedObjectContext *managedObjectContext;
-@property (nonatomic) NSMutableOrderedSet *remoteIdentifiersThatNeedToBeDownloaded;
+@property (nonatomic) ZMSortedUUIDSet *remoteIdentifiersThatNeedToBeDownloaded;
 @property (nonatomic) NSMutableSet *remoteIdentifiersInProgress;
-
+/// Batches that failed and are sent again before any new batch is created, oldest first.
+@property (nonatomic) NSMutableArray<ZMRemoteIdentifierObjectSyncBatch *> *batchesNeedingRetry;
+@property (nonatomic) NSUInteger numberOfBatchesInFlight;
 
 @end
 
@@ -44,92 +83,117 @@
         self.transcoder = transcoder;
         self.managedObjectContext = moc;
         self.remoteIdentifiersInProgress = [NSMutableSet set];
-        self.remoteIdentifiersThatNeedToBeDownloaded = [NSMutableOrderedSet orderedSet];
+        self.remoteIdentifiersThatNeedToBeDownloaded = [[ZMSortedUUIDSet alloc] init];
+        self.batchesNeedingRetry = [NSMutableArray array];
+        self.maximumNumberOfBatchesInFlight = ZMRemoteIdentifierObjectSyncDefaultMaximumNumberOfBatchesInFlight;
+        self.maximumNumberOfAttemptsPerBatch = ZMRemoteIdentifierObjectSyncDefaultMaximumNumberOfAttemptsPerBatch;
     }
     return self;
 }
 
 - (ZMTransportRequest *)nextRequest;
 {
-    if (self.remoteIdentifiersThatNeedToBeDownloaded.count == 0) {
+    if (self.numberOfBatchesInFlight >= MAX(self.maximumNumberOfBatchesInFlight, 1u)) {
         return nil;
     }
     
-    id <ZMRemoteIdentifierObjectTranscoder> transcoder = self.transcoder;
-    
-    NSUInteger count = [transcoder maximumRemoteIdentifiersPerRequestForObjectSync:self];
-    count = MIN(count, self.remoteIdentifiersThatNeedToBeDownloaded.count);
-    
-    NSSet *IDs = [[NSOrderedSet orderedSetWithOrderedSet:self.remoteIdentifiersThatNeedToBeDownloaded range:NSMakeRange(0, count) copyItems:NO] set];
-                         
-    [self.remoteIdentifiersInProgress unionSet:IDs];
-    [self.remoteIdentifiersThatNeedToBeDownloaded minusSet:IDs];
+    ZMRemoteIdentifierObjectSyncBatch *batch = self.batchesNeedingRetry.firstObject;
+    if (batch != nil) {
+        [self.batchesNeedingRetry removeObjectAtIndex:0];
+    }
+    else {
+        batch = [self createNextBatch];
+    }
+    if (batch == nil) {
+        return nil;
+    }
     
-    ZMTransportRequest *request = [transcoder requestForObjectSync:self remoteIdentifiers:IDs];
+    id <ZMRemoteIdentifierObjectTranscoder> transcoder = self.transcoder;
+    ZMTransportRequest *request = [transcoder requestForObjectSync:self remoteIdentifiers:batch.remoteIdentifiers];
     [request setDebugInformationTranscoder:transcoder];
 
     Require(request != nil);
+    ++self.numberOfBatchesInFlight;
+    ++batch.numberOfAttempts;
+    
     ZM_WEAK(self);
     [request addCompletionHandler:[ZMCompletionHandler handlerOnGroupQueue:self.managedObjectContext block:^(ZMTransportResponse *response) {
         ZM_STRONG(self);
-        switch (response.result) {
-            case ZMTransportResponseStatusPermanentError:
-            case ZMTransportResponseStatusSuccess: {
-                [transcoder didReceiveResponse:response remoteIdentifierObjectSync:self forRemoteIdentifiers:IDs];
-                [self.remoteIdentifiersInProgress minusSet:IDs];
-                break;
-            }
-            case ZMTransportResponseStatusExpired:
-                break;
-            case ZMTransportResponseStatusTemporaryError:
-            case ZMTransportResponseStatusTryAgainLater: {
-                [self.remoteIdentifiersThatNeedToBeDownloaded unionSet:IDs];
-                [self.remoteIdentifiersInProgress minusSet:IDs];
-                [self sortIdentifiers];
-                break;
-            }
-        }
+        [self batch:batch didReceiveResponse:response];
         [self.managedObjectContext enqueueDelayedSave];
     }]];
     return request;
 }
 
-- (void)setRemoteIdentifiersAsNeedingDownload:(NSSet<NSUUID *> *)remoteIdentifiers;
+- (ZMRemoteIdentifierObjectSyncBatch *)createNextBatch
 {
-    [self.remoteIdentifiersThatNeedToBeDownloaded removeAllObjects];
-    [self.remoteIdentifiersThatNeedToBeDownloaded addObjectsFromArray:remoteIdentifiers.allObjects];
-    [self sortIdentifiers];
+    if (self.remoteIdentifiersThatNeedToBeDownloaded.count == 0) {
+        return nil;
+    }
+    
+    NSUInteger const count = [self.transcoder maximumRemoteIdentifiersPerRequestForObjectSync:self];
+    NSSet *IDs = [self.remoteIdentifiersThatNeedToBeDownloaded removeFirstUUIDs:count];
+    [self.remoteIdentifiersInProgress unionSet:IDs];
+    return [[ZMRemoteIdentifierObjectSyncBatch alloc] initWithRemoteIdentifiers:IDs];
 }
 
-- (void)addRemoteIdentifiersThatNeedDownload:(NSSet<NSUUID *> *)remoteIdentifiers;
+/// Responses are handed to the transcoder as they arrive, so a slow or failing batch does not hold back the ones after it.
+- (void)batch:(ZMRemoteIdentifierObjectSyncBatch *)batch didReceiveResponse:(ZMTransportResponse *)response
 {
-    if ( ![remoteIdentifiers isSubsetOfSet:self.remoteIdentifiersInProgress]) {
-        [self.remoteIdentifiersThatNeedToBeDownloaded unionSet:remoteIdentifiers];
-        [self sortIdentifiers];
+    --self.numberOfBatchesInFlight;
+    
+    switch (response.result) {
+        case ZMTransportResponseStatusPermanentError:
+        case ZMTransportResponseStatusSuccess: {
+            [self.transcoder didReceiveResponse:response remoteIdentifierObjectSync:self forRemoteIdentifiers:batch.remoteIdentifiers];
+            [self.remoteIdentifiersInProgress minusSet:batch.remoteIdentifiers];
+            break;
+        }
+        case ZMTransportResponseStatusExpired:
+        case ZMTransportResponseStatusTemporaryError: {
+            if (batch.numberOfAttempts >= self.maximumNumberOfAttemptsPerBatch) {
+                ZMLogWarn(@"Giving up on %lu remote identifiers after %lu attempts", (unsigned long) batch.remoteIdentifiers.count, (unsigned long) batch.numberOfAttempts);
+                [self.remoteIdentifiersInProgress minusSet:batch.remoteIdentifiers];
+            }
+            else {
+                [self.batchesNeedingRetry addObject:batch];
+            }
+            break;
+        }
+        case ZMTransportResponseStatusTryAgainLater: {
+            // the request was never sent, so this does not count as an attempt
+            --batch.numberOfAttempts;
+            [self.batchesNeedingRetry addObject:batch];
+            break;
+        }
     }
+    
+    [ZMOperationLoop notifyNewRequestsAvailable:self];
 }
 
-- (void)sortIdentifiers;
+- (void)setRemoteIdentifiersAsNeedingDownload:(NSSet<NSUUID *> *)remoteIdentifiers;
 {
-    [self.remoteIdentifiersThatNeedToBeDownloaded sortUsingComparator:^NSComparisonResult(NSUUID *uuid1, NSUUID *uuid2) {
-        uuid_t u1;
-        uuid_t u2;
-        [uuid1 getUUIDBytes:u1];
-        [uuid2 getUUIDBytes:u2];
-        return memcmp(u1, u2, sizeof(u1));
-    }];
+    [self.remoteIdentifiersThatNeedToBeDownloaded removeAllUUIDs];
+    [self.remoteIdentifiersThatNeedToBeDownloaded addUUIDs:remoteIdentifiers];
+}
+
+- (void)addRemoteIdentifiersThatNeedDownload:(NSSet<NSUUID *> *)remoteIdentifiers;
+{
+    if ( ![remoteIdentifiers isSubsetOfSet:self.remoteIdentifiersInProgress]) {
+        [self.remoteIdentifiersThatNeedToBeDownloaded addUUIDs:remoteIdentifiers];
+    }
 }
 
 - (BOOL)isDone
 {
-    return (self.remoteIdentifiersThatNeedToBeDownloaded.count == 0 && self.remoteIdentifiersInProgress.count == 0);
+    return (self.remoteIdentifiersThatNeedToBeDownloaded.count == 0 && self.numberOfBatchesInFlight == 0 && self.batchesNeedingRetry.count == 0);
 }
 
 - (NSSet *)remoteIdentifiersThatWillBeDownloaded
 {
-    NSMutableOrderedSet *remoteIDsThatWillBeDownloaded =  [self.remoteIdentifiersThatNeedToBeDownloaded mutableCopy];
+    NSMutableSet *remoteIDsThatWillBeDownloaded = [NSMutableSet setWithArray:self.remoteIdentifiersThatNeedToBeDownloaded.allUUIDs];
     [remoteIDsThatWillBeDownloaded unionSet:self.remoteIdentifiersInProgress];
-    return [remoteIDsThatWillBeDownloaded set];
+    return remoteIDsThatWillBeDownloaded;
 }
 
 @end
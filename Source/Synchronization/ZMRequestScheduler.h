@@ -0,0 +1,73 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import Foundation;
+
+@class ZMTransportRequest;
+@class NSManagedObjectContext;
+@protocol ZMRequestGenerator;
+@protocol ZMRequestGeneratorSource;
+
+
+
+typedef NS_ENUM(NSUInteger, ZMRequestPriorityClass) {
+    /// Calling (flow, call state) and typing. These must go out as soon as possible.
+    ZMRequestPriorityClassRealtime = 0,
+    /// Messages the user has sent or is waiting for.
+    ZMRequestPriorityClassUserVisible,
+    /// Users, conversations, connections and other metadata.
+    ZMRequestPriorityClassMetadata,
+    /// Large downloads and uploads, e.g. images, assets and files.
+    ZMRequestPriorityClassBulk,
+};
+
+extern NSUInteger const ZMRequestPriorityClassCount;
+
+
+
+/// Picks the next request among a set of request sources, each of which belongs to a priority class.
+///
+/// When several classes have requests, they are served by weighted fairness: a class with weight w gets w turns for
+/// every turn of a class with weight 1. A class that was idle does not get to catch up on the turns it missed,
+/// and a class that keeps having requests is never starved by higher priority classes. Within a class, sources are
+/// asked in the order they were added.
+///
+/// Each class can also be limited in the number of requests it has in flight, so that e.g. bulk uploads can not take
+/// all transport slots. No class is limited by default.
+@interface ZMRequestScheduler : NSObject
+
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc;
+
+/// Adds a transcoder, whose request generators are asked for requests
+- (void)addRequestGeneratorSource:(id<ZMRequestGeneratorSource>)source priorityClass:(ZMRequestPriorityClass)priorityClass;
+/// Adds an object that is asked for requests with -nextRequest
+- (void)addRequestGenerator:(id<ZMRequestGenerator>)generator priorityClass:(ZMRequestPriorityClass)priorityClass;
+/// Removes a transcoder that was added with -addRequestGeneratorSource:priorityClass:
+- (void)removeRequestGeneratorSource:(id<ZMRequestGeneratorSource>)source;
+
+- (ZMTransportRequest *)nextRequest;
+
+- (void)setWeight:(NSUInteger)weight forPriorityClass:(ZMRequestPriorityClass)priorityClass;
+- (NSUInteger)weightForPriorityClass:(ZMRequestPriorityClass)priorityClass;
+
+/// NSUIntegerMax means no limit
+- (void)setMaximumNumberOfRequestsInFlight:(NSUInteger)maximum forPriorityClass:(ZMRequestPriorityClass)priorityClass;
+- (NSUInteger)numberOfRequestsInFlightForPriorityClass:(ZMRequestPriorityClass)priorityClass;
+
+@end
@@ -0,0 +1,192 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMCSystem;
+@import ZMUtilities;
+@import ZMTransport;
+@import CoreData;
+
+#import "ZMRequestScheduler.h"
+#import "ZMRequestGenerator.h"
+
+
+NSUInteger const ZMRequestPriorityClassCount = ZMRequestPriorityClassBulk + 1;
+
+static NSUInteger const DefaultWeights[] = {8, 4, 2, 1};
+
+
+
+@interface ZMRequestSchedulerClassState : NSObject
+
+@property (nonatomic, readonly) ZMRequestPriorityClass priorityClass;
+@property (nonatomic, readonly) NSMutableArray<id<ZMRequestGeneratorSource>> *sources;
+@property (nonatomic, readonly) NSMutableArray<id<ZMRequestGenerator>> *generators;
+@property (nonatomic) NSUInteger weight;
+@property (nonatomic) NSUInteger maximumNumberOfRequestsInFlight;
+@property (nonatomic) NSUInteger numberOfRequestsInFlight;
+/// Grows by 1/weight every time the class is served. The class with the lowest value goes next.
+@property (nonatomic) double virtualTime;
+
+@end
+
+
+
+@implementation ZMRequestSchedulerClassState
+
+- (instancetype)initWithPriorityClass:(ZMRequestPriorityClass)priorityClass
+{
+    self = [super init];
+    if (self) {
+        _priorityClass = priorityClass;
+        _sources = [NSMutableArray array];
+        _generators = [NSMutableArray array];
+        _weight = DefaultWeights[priorityClass];
+        _maximumNumberOfRequestsInFlight = NSUIntegerMax;
+    }
+    return self;
+}
+
+- (BOOL)canSendRequest
+{
+    return (self.sources.count > 0 || self.generators.count > 0) && self.numberOfRequestsInFlight < self.maximumNumberOfRequestsInFlight;
+}
+
+@end
+
+
+
+@interface ZMRequestScheduler ()
+
+@property (nonatomic) NSManagedObjectContext *managedObjectContext;
+@property (nonatomic) NSArray<ZMRequestSchedulerClassState *> *classStates;
+/// The virtual time of the last class that was served
+@property (nonatomic) double virtualTime;
+
+@end
+
+
+
+@implementation ZMRequestScheduler
+
+ZM_EMPTY_ASSERTING_INIT()
+
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc;
+{
+    self = [super init];
+    if (self) {
+        self.managedObjectContext = moc;
+        NSMutableArray *classStates = [NSMutableArray array];
+        for (NSUInteger priorityClass = 0; priorityClass < ZMRequestPriorityClassCount; ++priorityClass) {
+            [classStates addObject:[[ZMRequestSchedulerClassState alloc] initWithPriorityClass:priorityClass]];
+        }
+        self.classStates = classStates;
+    }
+    return self;
+}
+
+- (void)addRequestGeneratorSource:(id<ZMRequestGeneratorSource>)source priorityClass:(ZMRequestPriorityClass)priorityClass;
+{
+    Require(priorityClass < ZMRequestPriorityClassCount);
+    Require(source != nil);
+    [self.classStates[priorityClass].sources addObject:source];
+}
+
+- (void)addRequestGenerator:(id<ZMRequestGenerator>)generator priorityClass:(ZMRequestPriorityClass)priorityClass;
+{
+    Require(priorityClass < ZMRequestPriorityClassCount);
+    Require(generator != nil);
+    [self.classStates[priorityClass].generators addObject:generator];
+}
+
+- (void)removeRequestGeneratorSource:(id<ZMRequestGeneratorSource>)source;
+{
+    for (ZMRequestSchedulerClassState *classState in self.classStates) {
+        [classState.sources removeObjectIdenticalTo:source];
+    }
+}
+
+- (void)setWeight:(NSUInteger)weight forPriorityClass:(ZMRequestPriorityClass)priorityClass;
+{
+    Require(weight > 0);
+    self.classStates[priorityClass].weight = weight;
+}
+
+- (NSUInteger)weightForPriorityClass:(ZMRequestPriorityClass)priorityClass;
+{
+    return self.classStates[priorityClass].weight;
+}
+
+- (void)setMaximumNumberOfRequestsInFlight:(NSUInteger)maximum forPriorityClass:(ZMRequestPriorityClass)priorityClass;
+{
+    self.classStates[priorityClass].maximumNumberOfRequestsInFlight = maximum;
+}
+
+- (NSUInteger)numberOfRequestsInFlightForPriorityClass:(ZMRequestPriorityClass)priorityClass;
+{
+    return self.classStates[priorityClass].numberOfRequestsInFlight;
+}
+
+- (ZMTransportRequest *)nextRequest;
+{
+    // Lowest virtual time first, ties are broken by priority
+    NSArray *candidates = [[self.classStates filterWithBlock:^BOOL(ZMRequestSchedulerClassState *classState) {
+        return classState.canSendRequest;
+    }] sortedArrayUsingComparator:^NSComparisonResult(ZMRequestSchedulerClassState *lhs, ZMRequestSchedulerClassState *rhs) {
+        if (lhs.virtualTime != rhs.virtualTime) {
+            return (lhs.virtualTime < rhs.virtualTime) ? NSOrderedAscending : NSOrderedDescending;
+        }
+        return (lhs.priorityClass < rhs.priorityClass) ? NSOrderedAscending : NSOrderedDescending;
+    }];
+    
+    for (ZMRequestSchedulerClassState *classState in candidates) {
+        ZMTransportRequest *request = [self nextRequestForClassState:classState];
+        if (request != nil) {
+            [self didScheduleRequest:request forClassState:classState];
+            return request;
+        }
+        // An idle class must not build up turns that it would then use all at once when it has requests again
+        classState.virtualTime = MAX(classState.virtualTime, self.virtualTime);
+    }
+    return nil;
+}
+
+- (ZMTransportRequest *)nextRequestForClassState:(ZMRequestSchedulerClassState *)classState
+{
+    for (id<ZMRequestGeneratorSource> source in classState.sources) {
+        ZMTransportRequest *request = [source.requestGenerators nextRequest];
+        if (request != nil) {
+            [request setDebugInformationTranscoder:source];
+            return request;
+        }
+    }
+    return [classState.generators firstNonNilReturnedFromSelector:@selector(nextRequest)];
+}
+
+- (void)didScheduleRequest:(ZMTransportRequest *)request forClassState:(ZMRequestSchedulerClassState *)classState
+{
+    self.virtualTime = classState.virtualTime;
+    classState.virtualTime += 1.0 / classState.weight;
+    
+    ++classState.numberOfRequestsInFlight;
+    [request addCompletionHandler:[ZMCompletionHandler handlerOnGroupQueue:self.managedObjectContext block:^(ZMTransportResponse * __unused response) {
+        --classState.numberOfRequestsInFlight;
+    }]];
+}
+
+@end
@@ -0,0 +1,43 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import Foundation;
+
+
+
+/// A set of UUIDs that is kept sorted by the UUID bytes.
+///
+/// The UUIDs are stored as raw uuid_t in a contiguous buffer that grows geometrically. Adding UUIDs merges them in place
+/// and removing UUIDs from the front of the set is constant time, which makes it cheap to use as a queue of identifiers to download.
+@interface ZMSortedUUIDSet : NSObject
+
+@property (nonatomic, readonly) NSUInteger count;
+
+/// Returns NO and leaves the set unchanged if memory could not be allocated
+- (BOOL)addUUIDs:(NSSet<NSUUID *> *)uuids;
+- (void)removeAllUUIDs;
+- (BOOL)containsUUID:(NSUUID *)uuid;
+
+/// Removes up to @c count UUIDs from the front of the set and returns them
+- (NSSet<NSUUID *> *)removeFirstUUIDs:(NSUInteger)count;
+
+/// All UUIDs in sorted order
+- (NSArray<NSUUID *> *)allUUIDs;
+
+@end
@@ -0,0 +1,171 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMUtilities;
+
+#import "ZMSortedUUIDSet.h"
+
+static char* const ZMLogTag ZM_UNUSED = "SortedUUIDSet";
+
+
+
+static int compareUUIDs(const void *a, const void *b)
+{
+    return memcmp(a, b, sizeof(uuid_t));
+}
+
+
+
+@interface ZMSortedUUIDSet ()
+{
+    uuid_t *_buffer;
+    /// Number of UUIDs that fit into @c _buffer
+    NSUInteger _capacity;
+    /// Index of the first UUID in @c _buffer. Removing from the front only advances this.
+    NSUInteger _start;
+    NSUInteger _count;
+}
+
+@end
+
+
+
+@implementation ZMSortedUUIDSet
+
+- (void)dealloc
+{
+    free(_buffer);
+}
+
+- (NSUInteger)count
+{
+    return _count;
+}
+
+- (BOOL)addUUIDs:(NSSet<NSUUID *> *)uuids;
+{
+    if (uuids.count == 0) {
+        return YES;
+    }
+    
+    uuid_t *added = malloc(uuids.count * sizeof(uuid_t));
+    if (added == NULL) {
+        ZMLogError(@"Failed to allocate memory for %lu UUIDs", (unsigned long) uuids.count);
+        return NO;
+    }
+    
+    // only the UUIDs that are not in the set yet are merged
+    NSUInteger addedCount = 0;
+    for (NSUUID *uuid in uuids) {
+        [uuid getUUIDBytes:added[addedCount]];
+        if (_count == 0 || bsearch(added[addedCount], _buffer + _start, _count, sizeof(uuid_t), compareUUIDs) == NULL) {
+            ++addedCount;
+        }
+    }
+    if (addedCount == 0) {
+        free(added);
+        return YES;
+    }
+    qsort(added, addedCount, sizeof(uuid_t), compareUUIDs);
+    
+    if (![self reserveCapacity:_count + addedCount]) {
+        free(added);
+        return NO;
+    }
+    
+    // merge from the back, so that no UUID is overwritten before it has been moved
+    NSUInteger i = _count;
+    NSUInteger j = addedCount;
+    NSUInteger k = _count + addedCount;
+    while (j > 0) {
+        if (i > 0 && compareUUIDs(_buffer[i - 1], added[j - 1]) > 0) {
+            memcpy(_buffer[--k], _buffer[--i], sizeof(uuid_t));
+        } else {
+            memcpy(_buffer[--k], added[--j], sizeof(uuid_t));
+        }
+    }
+    
+    free(added);
+    _count += addedCount;
+    return YES;
+}
+
+/// Moves the UUIDs to the front of the buffer and grows it geometrically so that it holds at least @c capacity UUIDs
+- (BOOL)reserveCapacity:(NSUInteger)capacity
+{
+    if (_start > 0) {
+        memmove(_buffer, _buffer + _start, _count * sizeof(uuid_t));
+        _start = 0;
+    }
+    if (capacity <= _capacity) {
+        return YES;
+    }
+    
+    NSUInteger const newCapacity = MAX(capacity, 2 * _capacity);
+    uuid_t *buffer = realloc(_buffer, newCapacity * sizeof(uuid_t));
+    if (buffer == NULL) {
+        ZMLogError(@"Failed to grow sorted UUID set to %lu UUIDs", (unsigned long) newCapacity);
+        return NO;
+    }
+    _buffer = buffer;
+    _capacity = newCapacity;
+    return YES;
+}
+
+- (void)removeAllUUIDs;
+{
+    _start = 0;
+    _count = 0;
+}
+
+- (BOOL)containsUUID:(NSUUID *)uuid;
+{
+    if (_count == 0) {
+        return NO;
+    }
+    uuid_t bytes;
+    [uuid getUUIDBytes:bytes];
+    return bsearch(bytes, _buffer + _start, _count, sizeof(uuid_t), compareUUIDs) != NULL;
+}
+
+- (NSSet<NSUUID *> *)removeFirstUUIDs:(NSUInteger)count;
+{
+    count = MIN(count, _count);
+    NSMutableSet *result = [NSMutableSet setWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [result addObject:[[NSUUID alloc] initWithUUIDBytes:_buffer[_start + i]]];
+    }
+    _start += count;
+    _count -= count;
+    if (_count == 0) {
+        _start = 0;
+    }
+    return result;
+}
+
+- (NSArray<NSUUID *> *)allUUIDs;
+{
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:_count];
+    for (NSUInteger i = 0; i < _count; ++i) {
+        [result addObject:[[NSUUID alloc] initWithUUIDBytes:_buffer[_start + i]]];
+    }
+    return result;
+}
+
+@end
@@ -42,6 +42,7 @@
 @class ClientUpdateStatus;
 @class BackgroundAPNSPingBackStatus;
 @class ZMAccountStatus;
+@class ZMLocalSearchIndex;
 
 @interface ZMSyncStrategy : NSObject <ZMObjectStrategyDirectory, ZMUpdateEventConsumer>
 
@@ -74,12 +75,19 @@
 /// Process events that were downloaded as part of the clinet history
 - (void)processDownloadedEvents:(NSArray <ZMUpdateEvent *>*)events;
 
+/// Process events downloaded from the notification stream. They are processed right away and discarded from the buffer,
+/// since the same events might have been received through the push channel while buffering.
+- (void)processDownloadedNotificationStreamEvents:(NSArray <ZMUpdateEvent *>*)events;
+
 - (BOOL)processSaveWithInsertedObjects:(NSSet *)insertedObjects updateObjects:(NSSet *)updatedObjects;
 - (void)tearDown;
 
 @property (nonatomic, readonly) BOOL slowSyncInProgress;
 @property (nonatomic, readonly) NSManagedObjectContext *syncMOC;
 
+/// Index of local user and conversation names, kept up to date with the changes the sync strategy sees
+@property (nonatomic, readonly) ZMLocalSearchIndex *localSearchIndex;
+
 - (void)startBackgroundFetchWithCompletionHandler:(ZMBackgroundFetchHandler)handler;
 
 /// Calls completionHandler when the change has gone through all transcoders
@@ -51,6 +51,10 @@
 #import "ZMCallStateTranscoder.h"
 #import "ZMOperationLoop.h"
 #import "ZMChangeTrackerBootstrap.h"
+#import "ZMChangeTrackerRegistry.h"
+#import "ZMRequestScheduler.h"
+#import "ZMUnreadConversationCounter.h"
+#import "ZMLocalSearchIndex.h"
 #import "ZMRemovedSuggestedPeopleTranscoder.h"
 #import "ZMPhoneNumberVerificationTranscoder.h"
 #import "ZMLoginCodeRequestTranscoder.h"
@@ -102,7 +106,10 @@
 @property (nonatomic) ZMSyncStateMachine *stateMachine;
 @property (nonatomic) ZMUpdateEventsBuffer *eventsBuffer;
 @property (nonatomic) ZMChangeTrackerBootstrap *changeTrackerBootStrap;
+@property (nonatomic) ZMChangeTrackerRegistry *changeTrackerRegistry;
 @property (nonatomic) ConversationStatusStrategy *conversationStatusSync;
+@property (nonatomic) ZMUnreadConversationCounter *unreadConversationCounter;
+@property (nonatomic) ZMLocalSearchIndex *localSearchIndex;
 @property (nonatomic) UserClientRequestStrategy *userClientRequestStrategy;
 @property (nonatomic) FileUploadRequestStrategy *fileUploadRequestStrategy;
 
@@ -110,6 +117,7 @@
 @property (nonatomic) NSArray *allChangeTrackers;
 
 @property (nonatomic) NSArray *requestStrategies;
+@property (nonatomic) ZMRequestScheduler *requestScheduler;
 
 @property (atomic) BOOL tornDown;
 @property (nonatomic) BOOL contextMergingDisabled;
@@ -160,31 +168,47 @@ ZM_EMPTY_ASSERTING_INIT()
                                         onDemandFlowManager:onDemandFlowManager
                                    taskCancellationProvider:taskCancellationProvider];
         
+        // the event processing state adds its transcoders to this scheduler while it is the current state
+        self.requestScheduler = [[ZMRequestScheduler alloc] initWithManagedObjectContext:self.syncMOC];
         self.stateMachine = [[ZMSyncStateMachine alloc] initWithAuthenticationStatus:authenticationStatus
                                                             clientRegistrationStatus:clientRegistrationStatus
                                                              objectStrategyDirectory:self
                                                                    syncStateDelegate:syncStateDelegate
                                                                backgroundableSession:backgroundableSession];
-        self.eventsBuffer = [[ZMUpdateEventsBuffer alloc] initWithUpdateEventConsumer:self];
+        self.eventsBuffer = [[ZMUpdateEventsBuffer alloc] initWithUpdateEventConsumer:self
+                                                        maximumNumberOfEventsInMemory:ZMUpdateEventsBufferDefaultMaximumNumberOfEventsInMemory
+                                                                           journalURL:[self updateEventsJournalURL]];
         self.userClientRequestStrategy = [[UserClientRequestStrategy alloc] initWithAuthenticationStatus:authenticationStatus
                                                                                 clientRegistrationStatus:clientRegistrationStatus
                                                                                       clientUpdateStatus:clientUpdateStatus
                                                                                                  context:self.syncMOC];
         
+        GiphyRequestStrategy *giphyRequestStrategy = [[GiphyRequestStrategy alloc] initWithRequestsStatus:giphyRequestsStatus
+                                                                                    managedObjectContext:self.syncMOC];
+        DeleteAccountRequestStrategy *deleteAccountRequestStrategy = [[DeleteAccountRequestStrategy alloc] initWithAuthStatus:authenticationStatus
+                                                                                                         managedObjectContext:self.syncMOC];
+        AssetDownloadRequestStrategy *assetDownloadRequestStrategy = [[AssetDownloadRequestStrategy alloc] initWithAuthStatus:authenticationStatus
+                                                                                                     taskCancellationProvider:taskCancellationProvider
+                                                                                                         managedObjectContext:self.syncMOC];
         self.requestStrategies = @[self.userClientRequestStrategy,
-                                   [[GiphyRequestStrategy alloc] initWithRequestsStatus:giphyRequestsStatus
-                                                                   managedObjectContext:self.syncMOC],
-                                   [[DeleteAccountRequestStrategy alloc] initWithAuthStatus:authenticationStatus
-                                                                       managedObjectContext:self.syncMOC],
-                                   [[AssetDownloadRequestStrategy alloc] initWithAuthStatus:authenticationStatus
-                                                                   taskCancellationProvider:taskCancellationProvider
-                                                                       managedObjectContext:self.syncMOC],
+                                   giphyRequestStrategy,
+                                   deleteAccountRequestStrategy,
+                                   assetDownloadRequestStrategy,
                                    self.pingBackRequestStrategy,
                                    self.pushNoticeFetchStrategy,
                                    self.fileUploadRequestStrategy
                                    ];
         
+        [self.requestScheduler addRequestGenerator:self.pingBackRequestStrategy priorityClass:ZMRequestPriorityClassRealtime];
+        [self.requestScheduler addRequestGenerator:self.pushNoticeFetchStrategy priorityClass:ZMRequestPriorityClassRealtime];
+        [self.requestScheduler addRequestGenerator:giphyRequestStrategy priorityClass:ZMRequestPriorityClassUserVisible];
+        [self.requestScheduler addRequestGenerator:self.userClientRequestStrategy priorityClass:ZMRequestPriorityClassMetadata];
+        [self.requestScheduler addRequestGenerator:deleteAccountRequestStrategy priorityClass:ZMRequestPriorityClassMetadata];
+        [self.requestScheduler addRequestGenerator:assetDownloadRequestStrategy priorityClass:ZMRequestPriorityClassBulk];
+        [self.requestScheduler addRequestGenerator:self.fileUploadRequestStrategy priorityClass:ZMRequestPriorityClassBulk];
+        
         self.changeTrackerBootStrap = [[ZMChangeTrackerBootstrap alloc] initWithManagedObjectContext:self.syncMOC changeTrackers:self.allChangeTrackers];
+        self.changeTrackerRegistry = [[ZMChangeTrackerRegistry alloc] initWithChangeTrackers:self.allChangeTrackers];
         
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(managedObjectContextDidSave:) name:NSManagedObjectContextDidSaveNotification object:self.syncMOC];
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(managedObjectContextDidSave:) name:NSManagedObjectContextDidSaveNotification object:uiMOC];
@@ -234,6 +258,8 @@ ZM_EMPTY_ASSERTING_INIT()
     self.phoneNumberVerificationTranscoder = [[ZMPhoneNumberVerificationTranscoder alloc] initWithManagedObjectContext:self.syncMOC authenticationStatus:authenticationStatus];
     self.userProfileUpdateTranscoder = [[ZMUserProfileUpdateTranscoder alloc] initWithManagedObjectContext:self.syncMOC userProfileUpdateStatus:userProfileStatus];
     self.conversationStatusSync = [[ConversationStatusStrategy alloc] initWithManagedObjectContext:self.syncMOC];
+    self.unreadConversationCounter = [[ZMUnreadConversationCounter alloc] initWithManagedObjectContext:self.syncMOC];
+    self.localSearchIndex = [[ZMLocalSearchIndex alloc] initWithManagedObjectContext:self.syncMOC];
     self.pingBackRequestStrategy = [[PingBackRequestStrategy alloc] initWithManagedObjectContext:self.syncMOC backgroundAPNSPingBackStatus:backgroundAPNSPingBackStatus authenticationStatus:authenticationStatus];
     self.pushNoticeFetchStrategy = [[PushNoticeRequestStrategy alloc] initWithManagedObjectContext:self.syncMOC backgroundAPNSPingBackStatus:backgroundAPNSPingBackStatus authenticationStatus:authenticationStatus];
     self.fileUploadRequestStrategy = [[FileUploadRequestStrategy alloc] initWithAuthenticationStatus:authenticationStatus clientRegistrationStatus:clientRegistrationStatus managedObjectContext:self.syncMOC taskCancellationProvider:taskCancellationProvider];
@@ -467,6 +493,8 @@ ZM_EMPTY_ASSERTING_INIT()
             return nil;
         }]];
         _allChangeTrackers = [_allChangeTrackers arrayByAddingObject:self.conversationStatusSync];
+        _allChangeTrackers = [_allChangeTrackers arrayByAddingObject:self.unreadConversationCounter];
+        _allChangeTrackers = [_allChangeTrackers arrayByAddingObject:self.localSearchIndex];
     }
     
     return _allChangeTrackers;
@@ -476,11 +504,7 @@ ZM_EMPTY_ASSERTING_INIT()
 - (BOOL)processSaveWithInsertedObjects:(NSSet *)insertedObjects updateObjects:(NSSet *)updatedObjects
 {
     NSSet *allObjects = [NSSet zmSetByCompiningSets:insertedObjects, updatedObjects, nil];
-
-    for(id<ZMContextChangeTracker> tracker in self.allChangeTrackers)
-    {
-        [tracker objectsDidChange:allObjects];
-    }
+    [self.changeTrackerRegistry objectsDidChange:allObjects];
     
     return YES;
 }
@@ -495,9 +519,11 @@ ZM_EMPTY_ASSERTING_INIT()
         return nil;
     }
 
+    // The request strategies are always registered with the request scheduler, the transcoders only in the event processing state,
+    // which asks the scheduler itself
     ZMTransportRequest* request = [self.stateMachine nextRequest];
-    if(request == nil) {
-        request = [self.requestStrategies firstNonNilReturnedFromSelector:@selector(nextRequest)];
+    if(request == nil && !self.stateMachine.includesRequestSchedulerRequests) {
+        request = [self.requestScheduler nextRequest];
     }
     return request;
 }
@@ -623,14 +649,32 @@ ZM_EMPTY_ASSERTING_INIT()
     }
 }
 
+- (void)processDownloadedNotificationStreamEvents:(NSArray <ZMUpdateEvent *>*)events
+{
+    // the same events might have been (or will be) received through the push channel while buffering
+    [self.eventsBuffer discardUpdateEventsWithIdentifiers:[NSSet setWithArray:[events mapWithBlock:^id(ZMUpdateEvent *event) {
+        return event.uuid;
+    }]]];
+    [self processUpdateEvents:events ignoreBuffer:YES];
+}
+
 - (NSArray *)conversationIdsThatHaveBufferedUpdatesForCallState;
 {
-    return [[self.eventsBuffer updateEvents] mapWithBlock:^id(ZMUpdateEvent *event) {
-        if (event.type == ZMUpdateEventCallState) {
-            return event.conversationUUID;
+    NSMutableOrderedSet *conversationIds = [NSMutableOrderedSet orderedSet];
+    [self.eventsBuffer enumerateUpdateEventsUsingBlock:^(ZMUpdateEvent *event) {
+        if (event.type == ZMUpdateEventCallState && event.conversationUUID != nil) {
+            [conversationIds addObject:event.conversationUUID];
         }
-        return nil;
     }];
+    return conversationIds.array;
+}
+
+/// The journal is kept next to the database of the user, so that a journal that was left behind is found again on the next start
+- (NSURL *)updateEventsJournalURL
+{
+    NSURL *storeURL = self.syncMOC.persistentStoreCoordinator.persistentStores.firstObject.URL;
+    NSURL *directory = storeURL.isFileURL ? storeURL.URLByDeletingLastPathComponent : [[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask].firstObject;
+    return [directory URLByAppendingPathComponent:@"ZMUpdateEventsBuffer.journal"];
 }
 
 - (void)dataDidChange;
@@ -645,7 +689,7 @@ ZM_EMPTY_ASSERTING_INIT()
 
 - (void)updateBadgeCount;
 {
-    [self.badge setBadgeCount:[ZMConversation unreadConversationCountInContext:self.syncMOC]];
+    [self.badge setBadgeCount:self.unreadConversationCounter.unreadConversationCount];
 }
 
 @end
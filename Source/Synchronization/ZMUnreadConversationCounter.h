@@ -0,0 +1,45 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import Foundation;
+
+#import "ZMContextChangeTracker.h"
+
+@class NSManagedObjectContext;
+
+
+
+/// Keeps track of the number of unread conversations, so that the badge can be updated without a count fetch over all conversations.
+///
+/// The set of unread conversations is fetched once, the first time the count is requested. From then on it is updated from the
+/// conversations and connections passed to -objectsDidChange:, i.e. the same change sets the other change trackers get.
+/// In DEBUG builds the count is compared against a fetch every @c selfCheckInterval reads, and reset to the fetched value if they differ.
+@interface ZMUnreadConversationCounter : NSObject <ZMContextChangeTracker>
+
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc NS_DESIGNATED_INITIALIZER;
+
+@property (nonatomic, readonly) NSUInteger unreadConversationCount;
+
+/// Number of reads of @c unreadConversationCount between two self-checks. Only used in DEBUG builds. Defaults to 20.
+@property (nonatomic) NSUInteger selfCheckInterval;
+
+/// Forgets the tracked conversations. They will be fetched again on the next read.
+- (void)reset;
+
+@end
@@ -0,0 +1,133 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMCSystem;
+@import ZMUtilities;
+@import ZMCDataModel;
+
+#import "ZMUnreadConversationCounter.h"
+#import "ZMConversation+UnreadCount.h"
+
+static char* const ZMLogTag ZM_UNUSED = "UnreadCount";
+static NSUInteger const DefaultSelfCheckInterval = 20;
+
+
+
+@interface ZMUnreadConversationCounter ()
+
+@property (nonatomic, weak) NSManagedObjectContext *moc;
+@property (nonatomic) NSMutableSet<ZMConversation *> *unreadConversations; ///< nil until fetched
+@property (nonatomic) NSUInteger numberOfReadsSinceSelfCheck;
+
+@end
+
+
+
+@implementation ZMUnreadConversationCounter
+
+ZM_EMPTY_ASSERTING_INIT()
+
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc
+{
+    self = [super init];
+    if (self) {
+        self.moc = moc;
+        self.selfCheckInterval = DefaultSelfCheckInterval;
+    }
+    return self;
+}
+
+- (NSUInteger)unreadConversationCount
+{
+    if (self.unreadConversations == nil) {
+        self.unreadConversations = [self fetchUnreadConversations];
+        self.numberOfReadsSinceSelfCheck = 0;
+    }
+#if DEBUG
+    else if (++self.numberOfReadsSinceSelfCheck >= self.selfCheckInterval) {
+        self.numberOfReadsSinceSelfCheck = 0;
+        [self reconcileWithFetchedCount];
+    }
+#endif
+    return self.unreadConversations.count;
+}
+
+- (void)reset
+{
+    self.unreadConversations = nil;
+}
+
+- (NSMutableSet *)fetchUnreadConversations
+{
+    NSFetchRequest *request = [ZMConversation sortedFetchRequestWithPredicate:ZMConversation.predicateForConversationsCountedAsUnread];
+    return [NSMutableSet setWithArray:[self.moc executeFetchRequestOrAssert:request]];
+}
+
+- (void)reconcileWithFetchedCount
+{
+    NSUInteger fetchedCount = [ZMConversation unreadConversationCountInContext:self.moc];
+    if (fetchedCount != self.unreadConversations.count) {
+        ZMLogError(@"Unread conversation count is %lu, but fetching gives %lu. Resetting.", (unsigned long)self.unreadConversations.count, (unsigned long)fetchedCount);
+        self.unreadConversations = [self fetchUnreadConversations];
+    }
+}
+
+#pragma mark - ZMContextChangeTracker
+
+- (NSSet<NSString *> *)trackedEntityNames
+{
+    // The predicate depends on the status of the connection, which can change without the conversation changing
+    return [NSSet setWithObjects:ZMConversation.entityName, ZMConnection.entityName, nil];
+}
+
+- (void)objectsDidChange:(NSSet *)objects
+{
+    if (self.unreadConversations == nil) {
+        return;
+    }
+    NSPredicate *predicate = ZMConversation.predicateForConversationsCountedAsUnread;
+    for (NSManagedObject *object in objects) {
+        ZMConversation *conversation;
+        if ([object isKindOfClass:ZMConversation.class]) {
+            conversation = (ZMConversation *)object;
+        } else if ([object isKindOfClass:ZMConnection.class]) {
+            conversation = ((ZMConnection *)object).conversation;
+        }
+        if (conversation == nil) {
+            continue;
+        }
+        if (! conversation.isDeleted && conversation.managedObjectContext != nil && [predicate evaluateWithObject:conversation]) {
+            [self.unreadConversations addObject:conversation];
+        } else {
+            [self.unreadConversations removeObject:conversation];
+        }
+    }
+}
+
+- (NSFetchRequest *)fetchRequestForTrackedObjects
+{
+    return nil;
+}
+
+- (void)addTrackedObjects:(NSSet *)objects;
+{
+    NOT_USED(objects);
+}
+
+@end
@@ -35,9 +35,32 @@
 @end
 
 
+extern NSUInteger const ZMUpdateEventsBufferDefaultMaximumNumberOfEventsInMemory;
+
+
+
+/// Keeps update events that arrive while they can not be processed (e.g. during slow sync) until -processAllEventsInBuffer.
+///
+/// At most @c maximumNumberOfEventsInMemory events are kept in memory. Events beyond that are appended to a journal file and
+/// read back when the buffer is processed. Events are indexed by their identifier, so that discarding an event and dropping
+/// an event that was already buffered (or already processed, see -discardUpdateEventsWithIdentifiers:) are cheap.
+///
+/// A journal left behind at @c journalURL by a previous run is removed when the buffer is created. Its events were never
+/// processed, so the last update event ID did not move past them and they are downloaded again from the notification stream.
 @interface ZMUpdateEventsBuffer : NSObject <ZMUpdateEventsFlushableCollection>
 
+/// Keeps all events in memory
 - (instancetype)initWithUpdateEventConsumer:(id<ZMUpdateEventConsumer>)eventConsumer;
+- (instancetype)initWithUpdateEventConsumer:(id<ZMUpdateEventConsumer>)eventConsumer
+              maximumNumberOfEventsInMemory:(NSUInteger)maximumNumberOfEventsInMemory
+                                 journalURL:(NSURL *)journalURL NS_DESIGNATED_INITIALIZER;
+
+@property (nonatomic, readonly) NSUInteger maximumNumberOfEventsInMemory;
+
+/// Number of buffered events that have not been discarded
+@property (nonatomic, readonly) NSUInteger count;
+/// Number of buffered events that are stored in the journal instead of in memory
+@property (nonatomic, readonly) NSUInteger numberOfSpilledEvents;
 
 /// discard all events in the buffer
 - (void)discardAllUpdateEvents;
@@ -45,8 +68,17 @@
 /// discard the event with this identifier
 - (void)discardUpdateEventWithIdentifier:(NSUUID* )eventIdentifier;
 
+/// Discards the events with these identifiers, e.g. because they were downloaded and processed from the notification stream.
+/// Events with these identifiers that are added later on are ignored until the buffer is processed or all events are discarded.
+- (void)discardUpdateEventsWithIdentifiers:(NSSet<NSUUID *> *)eventIdentifiers;
+
+/// Adds the event, unless an event with the same identifier is already in the buffer
 - (void)addUpdateEvent:(ZMUpdateEvent *)event;
 
+/// All buffered events in the order they were added. Reads back the journal if events were spilled to disk.
 - (NSArray *)updateEvents;
 
+/// Enumerates the buffered events in the order they were added, reading back the journal one event at a time
+- (void)enumerateUpdateEventsUsingBlock:(void(^)(ZMUpdateEvent *event))block;
+
 @end
@@ -16,13 +16,44 @@
 // along with this program. If not, see <http://www.gnu.org/licenses/>.
 // 
 
+
 @import ZMTransport;
+@import ZMCSystem;
+@import ZMUtilities;
+@import ZMCDataModel;
+
 #import "ZMUpdateEventsBuffer.h"
 
+static char* const ZMLogTag ZM_UNUSED = "UpdateEventsBuffer";
+
+NSUInteger const ZMUpdateEventsBufferDefaultMaximumNumberOfEventsInMemory = 1000;
+
+static NSString * const JournalPositionKey = @"position";
+static NSString * const JournalIdentifierKey = @"id";
+static NSString * const JournalPayloadKey = @"payload";
+static NSString * const JournalTransientKey = @"transient";
+static NSString * const JournalSourceKey = @"source";
+static NSString * const JournalDebugInformationKey = @"debug";
+
+/// Position of an identifier that was discarded before the event was added
+static NSInteger const DiscardedPosition = -1;
+
+
+
 @interface ZMUpdateEventsBuffer ()
 
 @property (nonatomic, readonly, weak) id<ZMUpdateEventConsumer> consumer;
-@property (nonatomic, readonly) NSMutableArray *bufferedEvents;
+@property (nonatomic, readonly) NSURL *journalURL;
+
+/// Position of the next event that is added. Positions define the order in which events are replayed.
+@property (nonatomic) NSUInteger nextPosition;
+/// Positions of the events in memory, in ascending order. May contain positions of discarded events.
+@property (nonatomic, readonly) NSMutableArray<NSNumber *> *positionsInMemory;
+@property (nonatomic, readonly) NSMutableDictionary<NSNumber *, ZMUpdateEvent *> *eventsInMemoryByPosition;
+/// Positions of events in the journal
+@property (nonatomic, readonly) NSMutableIndexSet *spilledPositions;
+@property (nonatomic, readonly) NSMutableDictionary<NSUUID *, NSNumber *> *positionsByIdentifier;
+@property (nonatomic) NSFileHandle *journal;
 
 @end
 
@@ -31,45 +62,267 @@
 
 @implementation ZMUpdateEventsBuffer
 
+- (instancetype)init
+{
+    return [self initWithUpdateEventConsumer:nil];
+}
+
+- (instancetype)initWithUpdateEventConsumer:(id<ZMUpdateEventConsumer>)eventConsumer
+{
+    return [self initWithUpdateEventConsumer:eventConsumer
+               maximumNumberOfEventsInMemory:ZMUpdateEventsBufferDefaultMaximumNumberOfEventsInMemory
+                                  journalURL:nil];
+}
+
 - (instancetype)initWithUpdateEventConsumer:(id<ZMUpdateEventConsumer>)eventConsumer
+              maximumNumberOfEventsInMemory:(NSUInteger)maximumNumberOfEventsInMemory
+                                 journalURL:(NSURL *)journalURL
 {
-    self = [super self];
+    self = [super init];
     if(self) {
-        _bufferedEvents = [NSMutableArray array];
         _consumer = eventConsumer;
+        _maximumNumberOfEventsInMemory = MAX(maximumNumberOfEventsInMemory, 1u);
+        _journalURL = journalURL;
+        _positionsInMemory = [NSMutableArray array];
+        _eventsInMemoryByPosition = [NSMutableDictionary dictionary];
+        _spilledPositions = [NSMutableIndexSet indexSet];
+        _positionsByIdentifier = [NSMutableDictionary dictionary];
+        if (journalURL != nil) {
+            [[NSFileManager defaultManager] removeItemAtURL:journalURL error:NULL];
+        }
     }
     return self;
 }
 
+- (void)dealloc
+{
+    [self removeJournal];
+}
+
+- (NSUInteger)count
+{
+    return self.eventsInMemoryByPosition.count + self.spilledPositions.count;
+}
+
+- (NSUInteger)numberOfSpilledEvents
+{
+    return self.spilledPositions.count;
+}
+
 - (void)addUpdateEvent:(ZMUpdateEvent *)event
 {
-    [self.bufferedEvents addObject:event];
+    NSUUID *identifier = event.uuid;
+    if (identifier != nil && self.positionsByIdentifier[identifier] != nil) {
+        return;
+    }
+    
+    NSUInteger const position = self.nextPosition++;
+    if (identifier != nil) {
+        self.positionsByIdentifier[identifier] = @(position);
+    }
+    
+    if (self.eventsInMemoryByPosition.count >= self.maximumNumberOfEventsInMemory && [self appendEvent:event toJournalAtPosition:position]) {
+        [self.spilledPositions addIndex:position];
+        return;
+    }
+    [self.positionsInMemory addObject:@(position)];
+    self.eventsInMemoryByPosition[@(position)] = event;
 }
 
 - (void)processAllEventsInBuffer
 {
-    [self.consumer consumeUpdateEvents:self.bufferedEvents];
-    [self.bufferedEvents removeAllObjects];
+    // Events are handed to the consumer in chunks so that a large journal is never loaded into memory at once
+    NSMutableArray *chunk = [NSMutableArray array];
+    __block BOOL didConsume = NO;
+    [self enumerateUpdateEventsUsingBlock:^(ZMUpdateEvent *event) {
+        [chunk addObject:event];
+        if (chunk.count == self.maximumNumberOfEventsInMemory) {
+            [self.consumer consumeUpdateEvents:[chunk copy]];
+            [chunk removeAllObjects];
+            didConsume = YES;
+        }
+    }];
+    if (chunk.count > 0 || !didConsume) {
+        [self.consumer consumeUpdateEvents:chunk];
+    }
+    [self discardAllUpdateEvents];
 }
 
 - (void)discardAllUpdateEvents
 {
-    [self.bufferedEvents removeAllObjects];
+    [self.positionsInMemory removeAllObjects];
+    [self.eventsInMemoryByPosition removeAllObjects];
+    [self.spilledPositions removeAllIndexes];
+    [self.positionsByIdentifier removeAllObjects];
+    [self removeJournal];
 }
 
 - (void)discardUpdateEventWithIdentifier:(NSUUID *)eventIdentifier
 {
-    NSUInteger index = [self.bufferedEvents indexOfObjectPassingTest:^BOOL(ZMUpdateEvent *obj, NSUInteger __unused idx, BOOL * __unused stop) {
-        return [obj.uuid isEqual:eventIdentifier];
-    }];
-    if(index != NSNotFound) {
-        [self.bufferedEvents removeObjectAtIndex:index];
+    NSNumber *position = self.positionsByIdentifier[eventIdentifier];
+    if (position == nil || position.integerValue == DiscardedPosition) {
+        return;
+    }
+    [self.positionsByIdentifier removeObjectForKey:eventIdentifier];
+    [self.eventsInMemoryByPosition removeObjectForKey:position];
+    [self.spilledPositions removeIndex:position.unsignedIntegerValue];
+}
+
+- (void)discardUpdateEventsWithIdentifiers:(NSSet<NSUUID *> *)eventIdentifiers
+{
+    for (NSUUID *identifier in eventIdentifiers) {
+        [self discardUpdateEventWithIdentifier:identifier];
+        self.positionsByIdentifier[identifier] = @(DiscardedPosition);
     }
 }
 
 - (NSArray *)updateEvents
 {
-    return self.bufferedEvents;
+    NSMutableArray *events = [NSMutableArray arrayWithCapacity:self.count];
+    [self enumerateUpdateEventsUsingBlock:^(ZMUpdateEvent *event) {
+        [events addObject:event];
+    }];
+    return events;
+}
+
+/// Merges the events in memory and in the journal by their position
+- (void)enumerateUpdateEventsUsingBlock:(void(^)(ZMUpdateEvent *event))block
+{
+    NSArray *positionsInMemory = [self.positionsInMemory copy];
+    __block NSUInteger memoryIndex = 0;
+    void(^enumerateEventsInMemoryBefore)(NSUInteger) = ^(NSUInteger limit) {
+        while (memoryIndex < positionsInMemory.count && [positionsInMemory[memoryIndex] unsignedIntegerValue] < limit) {
+            ZMUpdateEvent *event = self.eventsInMemoryByPosition[positionsInMemory[memoryIndex]];
+            ++memoryIndex;
+            if (event != nil) {
+                block(event);
+            }
+        }
+    };
+    
+    if (self.spilledPositions.count > 0) {
+        [self.journal synchronizeFile];
+        NSError *error;
+        NSData *journalData = [NSData dataWithContentsOfURL:self.journalURL options:NSDataReadingMappedIfSafe error:&error];
+        if (journalData == nil) {
+            ZMLogError(@"Failed to read update events journal: %@", error);
+        }
+        [self enumerateJournalData:journalData usingBlock:^(NSUInteger position, NSDictionary *record) {
+            if (![self.spilledPositions containsIndex:position]) {
+                return;
+            }
+            enumerateEventsInMemoryBefore(position);
+            ZMUpdateEvent *event = [self eventFromJournalRecord:record];
+            if (event != nil) {
+                block(event);
+            }
+        }];
+    }
+    enumerateEventsInMemoryBefore(NSUIntegerMax);
+}
+
+#pragma mark - Journal
+
+- (BOOL)appendEvent:(ZMUpdateEvent *)event toJournalAtPosition:(NSUInteger)position
+{
+    NSMutableDictionary *record = [NSMutableDictionary dictionary];
+    record[JournalPositionKey] = @(position);
+    record[JournalIdentifierKey] = event.uuid.transportString;
+    record[JournalPayloadKey] = @[event.payload ?: @{}];
+    record[JournalTransientKey] = @(event.isTransient);
+    record[JournalSourceKey] = @(event.source);
+    record[JournalDebugInformationKey] = event.debugInformation;
+    
+    if (![NSJSONSerialization isValidJSONObject:record]) {
+        // keep it in memory, replay order is defined by the position, not by where the event is stored
+        return NO;
+    }
+    NSData *recordData = [NSJSONSerialization dataWithJSONObject:record options:0 error:NULL];
+    if (recordData == nil || self.journalURL == nil || ![self openJournalIfNeeded]) {
+        return NO;
+    }
+    
+    uint32_t const length = CFSwapInt32HostToBig((uint32_t) recordData.length);
+    NSMutableData *data = [NSMutableData dataWithBytes:&length length:sizeof(length)];
+    [data appendData:recordData];
+    @try {
+        [self.journal writeData:data];
+    }
+    @catch (NSException *exception) {
+        ZMLogError(@"Failed to write to update events journal: %@", exception);
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL)openJournalIfNeeded
+{
+    if (self.journal != nil) {
+        return YES;
+    }
+    // events are spilled while the app runs in the background, when the device might be locked
+    NSDictionary *attributes = @{NSFileProtectionKey: NSFileProtectionCompleteUntilFirstUserAuthentication};
+    if (![[NSFileManager defaultManager] createFileAtPath:self.journalURL.path contents:nil attributes:attributes]) {
+        ZMLogError(@"Failed to create update events journal at %@", self.journalURL);
+        return NO;
+    }
+    NSError *error;
+    self.journal = [NSFileHandle fileHandleForWritingToURL:self.journalURL error:&error];
+    if (self.journal == nil) {
+        ZMLogError(@"Failed to open update events journal: %@", error);
+        return NO;
+    }
+    return YES;
+}
+
+- (void)removeJournal
+{
+    if (self.journal == nil) {
+        return;
+    }
+    [self.journal closeFile];
+    self.journal = nil;
+    [[NSFileManager defaultManager] removeItemAtURL:self.journalURL error:NULL];
+}
+
+- (void)enumerateJournalData:(NSData *)data usingBlock:(void(^)(NSUInteger position, NSDictionary *record))block
+{
+    uint8_t const *bytes = data.bytes;
+    NSUInteger offset = 0;
+    while (offset + sizeof(uint32_t) <= data.length) {
+        uint32_t length;
+        memcpy(&length, bytes + offset, sizeof(length));
+        length = CFSwapInt32BigToHost(length);
+        offset += sizeof(length);
+        if (offset + length > data.length) {
+            ZMLogError(@"Truncated record in update events journal");
+            return;
+        }
+        @autoreleasepool {
+            NSData *recordData = [NSData dataWithBytesNoCopy:(void *)(bytes + offset) length:length freeWhenDone:NO];
+            NSDictionary *record = [NSJSONSerialization JSONObjectWithData:recordData options:0 error:NULL];
+            NSNumber *position = [record optionalNumberForKey:JournalPositionKey];
+            if (position != nil) {
+                block(position.unsignedIntegerValue, record);
+            }
+        }
+        offset += length;
+    }
+}
+
+- (ZMUpdateEvent *)eventFromJournalRecord:(NSDictionary *)record
+{
+    NSMutableDictionary *transportData = [NSMutableDictionary dictionary];
+    transportData[@"id"] = record[JournalIdentifierKey];
+    transportData[@"payload"] = record[JournalPayloadKey];
+    transportData[@"transient"] = record[JournalTransientKey];
+    ZMUpdateEventSource const source = (ZMUpdateEventSource) [[record optionalNumberForKey:JournalSourceKey] integerValue];
+    ZMUpdateEvent *event = [ZMUpdateEvent eventsArrayFromTransportData:transportData source:source].firstObject;
+    NSString *debugInformation = [record optionalStringForKey:JournalDebugInformationKey];
+    if (debugInformation != nil) {
+        [event appendDebugInformation:debugInformation];
+    }
+    return event;
 }
 
 @end
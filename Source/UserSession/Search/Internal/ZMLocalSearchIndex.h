@@ -0,0 +1,57 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import Foundation;
+
+#import "ZMContextChangeTracker.h"
+
+@class NSManagedObjectContext;
+@class NSManagedObjectID;
+
+
+
+/// An in-memory index of user names and group conversation names, used to narrow down local search results.
+///
+/// Names are normalized the same way the data model normalizes them for its search predicates (see NSString+Normalization),
+/// and split into words. A query matches when each of its words is the prefix of a word of the name, which is what
+/// @c +[ZMUser predicateForConnectedUsersWithSearchString:] and @c +[ZMConversation predicateForSearchString:] match.
+/// Users are also found by their full email address, and conversations by the names of their participants.
+///
+/// The results are candidates: they contain everything the predicates would match, and callers still apply the
+/// predicates (e.g. the connection status) to them. They are ranked, best match first.
+///
+/// The index is built on the managed object context's queue, the first time it is queried, and then kept up to date
+/// as a change tracker of the sync strategy. Queries can be made from any queue. They return nil until the index is built,
+/// and for queries without any words (e.g. an empty query), which the index can not narrow down.
+@interface ZMLocalSearchIndex : NSObject <ZMContextChangeTracker>
+
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc NS_DESIGNATED_INITIALIZER;
+
+@property (nonatomic, readonly) BOOL isBuilt;
+
+/// Returns the object IDs of users whose name or email address match the query, or nil if the index can not answer the query yet
+- (NSArray<NSManagedObjectID *> *)userObjectIDsMatchingSearchString:(NSString *)searchString;
+
+/// Returns the object IDs of group conversations whose name or participants match the query, or nil if the index can not answer the query yet
+- (NSArray<NSManagedObjectID *> *)conversationObjectIDsMatchingSearchString:(NSString *)searchString;
+
+/// Builds the index if it has not been built yet. Needs to be called on the queue of the context.
+- (void)buildIfNeeded;
+
+@end
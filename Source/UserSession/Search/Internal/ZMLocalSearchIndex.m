@@ -0,0 +1,510 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMCSystem;
+@import ZMUtilities;
+@import ZMCDataModel;
+
+#import "ZMLocalSearchIndex.h"
+#import "NSString+Normalization.h"
+
+
+static NSArray<NSString *> *SearchWordsInNormalizedString(NSString *normalizedString)
+{
+    NSMutableArray *words = [NSMutableArray array];
+    for (NSString *word in [normalizedString componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]]) {
+        if (word.length > 0) {
+            [words addObject:word];
+        }
+    }
+    return words;
+}
+
+static NSArray<NSString *> *SearchWordsInString(NSString *string)
+{
+    return SearchWordsInNormalizedString(string.normalizedString);
+}
+
+
+
+/// Maps the words of the names of a set of objects to those objects
+@interface ZMSearchWordPostings : NSObject
+
+- (void)setName:(NSString *)name forObjectID:(NSManagedObjectID *)objectID;
+- (void)removeObjectID:(NSManagedObjectID *)objectID;
+
+- (NSMutableSet<NSManagedObjectID *> *)objectIDsWithWordPrefix:(NSString *)prefix;
+- (BOOL)objectID:(NSManagedObjectID *)objectID hasWordWithPrefix:(NSString *)prefix;
+- (NSString *)normalizedNameForObjectID:(NSManagedObjectID *)objectID;
+
+@end
+
+
+
+@interface ZMSearchWordPostings ()
+
+@property (nonatomic, readonly) NSMutableDictionary<NSManagedObjectID *, NSArray<NSString *> *> *wordsByObjectID;
+@property (nonatomic, readonly) NSMutableDictionary<NSManagedObjectID *, NSString *> *namesByObjectID;
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, NSMutableSet<NSManagedObjectID *> *> *objectIDsByWord;
+/// All keys of objectIDsByWord, sorted. nil until the first lookup, so that building the index does not insert words one by one.
+@property (nonatomic) NSMutableArray<NSString *> *sortedWords;
+
+@end
+
+
+
+@implementation ZMSearchWordPostings
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _wordsByObjectID = [NSMutableDictionary dictionary];
+        _namesByObjectID = [NSMutableDictionary dictionary];
+        _objectIDsByWord = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)setName:(NSString *)name forObjectID:(NSManagedObjectID *)objectID
+{
+    NSString *normalizedName = name.normalizedString ?: @"";
+    if ([self.namesByObjectID[objectID] isEqualToString:normalizedName]) {
+        return;
+    }
+    [self removeObjectID:objectID];
+    
+    NSArray *words = SearchWordsInNormalizedString(normalizedName);
+    self.wordsByObjectID[objectID] = words;
+    self.namesByObjectID[objectID] = normalizedName;
+    for (NSString *word in words) {
+        NSMutableSet *objectIDs = self.objectIDsByWord[word];
+        if (objectIDs == nil) {
+            objectIDs = [NSMutableSet set];
+            self.objectIDsByWord[word] = objectIDs;
+            [self insertSortedWord:word];
+        }
+        [objectIDs addObject:objectID];
+    }
+}
+
+- (void)removeObjectID:(NSManagedObjectID *)objectID
+{
+    for (NSString *word in self.wordsByObjectID[objectID]) {
+        NSMutableSet *objectIDs = self.objectIDsByWord[word];
+        [objectIDs removeObject:objectID];
+        if (objectIDs.count == 0) {
+            [self.objectIDsByWord removeObjectForKey:word];
+            [self removeSortedWord:word];
+        }
+    }
+    [self.wordsByObjectID removeObjectForKey:objectID];
+    [self.namesByObjectID removeObjectForKey:objectID];
+}
+
+- (NSString *)normalizedNameForObjectID:(NSManagedObjectID *)objectID
+{
+    return self.namesByObjectID[objectID];
+}
+
+- (BOOL)objectID:(NSManagedObjectID *)objectID hasWordWithPrefix:(NSString *)prefix
+{
+    for (NSString *word in self.wordsByObjectID[objectID]) {
+        if ([word hasPrefix:prefix]) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+#pragma mark - Sorted words
+
+- (NSUInteger)indexOfFirstWordNotBefore:(NSString *)word
+{
+    return [self.sortedWords indexOfObject:word
+                             inSortedRange:NSMakeRange(0, self.sortedWords.count)
+                                   options:NSBinarySearchingInsertionIndex | NSBinarySearchingFirstEqual
+                           usingComparator:^NSComparisonResult(NSString *word1, NSString *word2) {
+                               return [word1 compare:word2 options:NSLiteralSearch];
+                           }];
+}
+
+- (void)insertSortedWord:(NSString *)word
+{
+    if (self.sortedWords != nil) {
+        [self.sortedWords insertObject:word atIndex:[self indexOfFirstWordNotBefore:word]];
+    }
+}
+
+- (void)removeSortedWord:(NSString *)word
+{
+    if (self.sortedWords != nil) {
+        NSUInteger const index = [self indexOfFirstWordNotBefore:word];
+        if (index < self.sortedWords.count && [self.sortedWords[index] isEqualToString:word]) {
+            [self.sortedWords removeObjectAtIndex:index];
+        }
+    }
+}
+
+- (NSMutableSet<NSManagedObjectID *> *)objectIDsWithWordPrefix:(NSString *)prefix
+{
+    if (self.sortedWords == nil) {
+        self.sortedWords = [[self.objectIDsByWord.allKeys sortedArrayUsingComparator:^NSComparisonResult(NSString *word1, NSString *word2) {
+            return [word1 compare:word2 options:NSLiteralSearch];
+        }] mutableCopy];
+    }
+    
+    NSMutableSet *result = [NSMutableSet set];
+    for (NSUInteger index = [self indexOfFirstWordNotBefore:prefix]; index < self.sortedWords.count; ++index) {
+        NSString *word = self.sortedWords[index];
+        if (! [word hasPrefix:prefix]) {
+            break;
+        }
+        [result unionSet:self.objectIDsByWord[word]];
+    }
+    return result;
+}
+
+@end
+
+
+
+@interface ZMLocalSearchIndex ()
+
+@property (nonatomic, weak) NSManagedObjectContext *moc;
+@property (nonatomic) BOOL isBuilt;
+@property (nonatomic) BOOL isBuildScheduled;
+
+@property (nonatomic) ZMSearchWordPostings *userNames;
+@property (nonatomic) NSMutableDictionary<NSString *, NSMutableSet<NSManagedObjectID *> *> *userIDsByEmailAddress;
+@property (nonatomic) NSMutableDictionary<NSManagedObjectID *, NSString *> *emailAddressesByUserID;
+
+@property (nonatomic) ZMSearchWordPostings *conversationNames;
+@property (nonatomic) NSMutableDictionary<NSManagedObjectID *, NSSet<NSManagedObjectID *> *> *participantIDsByConversationID;
+@property (nonatomic) NSMutableDictionary<NSManagedObjectID *, NSMutableSet<NSManagedObjectID *> *> *conversationIDsByParticipantID;
+
+@end
+
+
+
+@implementation ZMLocalSearchIndex
+
+ZM_EMPTY_ASSERTING_INIT()
+
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)moc
+{
+    self = [super init];
+    if (self) {
+        self.moc = moc;
+    }
+    return self;
+}
+
+#pragma mark - Building
+
+- (void)buildIfNeeded
+{
+    @synchronized(self) {
+        if (self.isBuilt) {
+            return;
+        }
+        self.userNames = [[ZMSearchWordPostings alloc] init];
+        self.userIDsByEmailAddress = [NSMutableDictionary dictionary];
+        self.emailAddressesByUserID = [NSMutableDictionary dictionary];
+        self.conversationNames = [[ZMSearchWordPostings alloc] init];
+        self.participantIDsByConversationID = [NSMutableDictionary dictionary];
+        self.conversationIDsByParticipantID = [NSMutableDictionary dictionary];
+        
+        NSFetchRequest *userRequest = [NSFetchRequest fetchRequestWithEntityName:ZMUser.entityName];
+        userRequest.returnsObjectsAsFaults = NO;
+        for (ZMUser *user in [self.moc executeFetchRequestOrAssert:userRequest]) {
+            [self indexUser:user];
+        }
+        
+        NSFetchRequest *conversationRequest = [NSFetchRequest fetchRequestWithEntityName:ZMConversation.entityName];
+        conversationRequest.predicate = [NSPredicate predicateWithFormat:@"conversationType == %d", ZMConversationTypeGroup];
+        conversationRequest.returnsObjectsAsFaults = NO;
+        conversationRequest.relationshipKeyPathsForPrefetching = @[@"otherActiveParticipants"];
+        for (ZMConversation *conversation in [self.moc executeFetchRequestOrAssert:conversationRequest]) {
+            [self indexConversation:conversation];
+        }
+        
+        self.isBuilt = YES;
+    }
+}
+
+- (void)scheduleBuild
+{
+    @synchronized(self) {
+        if (self.isBuildScheduled) {
+            return;
+        }
+        self.isBuildScheduled = YES;
+    }
+    ZM_WEAK(self);
+    [self.moc performGroupedBlock:^{
+        ZM_STRONG(self);
+        [self buildIfNeeded];
+    }];
+}
+
+/// Needs to be called while synchronized on self
+- (void)indexUser:(ZMUser *)user
+{
+    NSManagedObjectID *userID = user.objectID;
+    if (user.isZombieObject || user.isSelfUser) {
+        [self removeUserWithID:userID];
+        return;
+    }
+    [self.userNames setName:user.name forObjectID:userID];
+    
+    NSString *emailAddress = user.emailAddress.lowercaseString;
+    NSString *previousEmailAddress = self.emailAddressesByUserID[userID];
+    if (emailAddress == previousEmailAddress || [emailAddress isEqualToString:previousEmailAddress]) {
+        return;
+    }
+    [self removeEmailAddressOfUserWithID:userID];
+    if (emailAddress.length > 0) {
+        self.emailAddressesByUserID[userID] = emailAddress;
+        NSMutableSet *userIDs = self.userIDsByEmailAddress[emailAddress];
+        if (userIDs == nil) {
+            userIDs = [NSMutableSet set];
+            self.userIDsByEmailAddress[emailAddress] = userIDs;
+        }
+        [userIDs addObject:userID];
+    }
+}
+
+- (void)removeUserWithID:(NSManagedObjectID *)userID
+{
+    [self.userNames removeObjectID:userID];
+    [self removeEmailAddressOfUserWithID:userID];
+}
+
+- (void)removeEmailAddressOfUserWithID:(NSManagedObjectID *)userID
+{
+    NSString *emailAddress = self.emailAddressesByUserID[userID];
+    if (emailAddress == nil) {
+        return;
+    }
+    NSMutableSet *userIDs = self.userIDsByEmailAddress[emailAddress];
+    [userIDs removeObject:userID];
+    if (userIDs.count == 0) {
+        [self.userIDsByEmailAddress removeObjectForKey:emailAddress];
+    }
+    [self.emailAddressesByUserID removeObjectForKey:userID];
+}
+
+/// Needs to be called while synchronized on self
+- (void)indexConversation:(ZMConversation *)conversation
+{
+    NSManagedObjectID *conversationID = conversation.objectID;
+    if (conversation.isZombieObject || conversation.conversationType != ZMConversationTypeGroup) {
+        [self removeConversationWithID:conversationID];
+        return;
+    }
+    [self.conversationNames setName:conversation.userDefinedName forObjectID:conversationID];
+    
+    NSMutableSet *participantIDs = [NSMutableSet set];
+    for (ZMUser *participant in conversation.otherActiveParticipants) {
+        [participantIDs addObject:participant.objectID];
+    }
+    [self setParticipantIDs:participantIDs forConversationWithID:conversationID];
+}
+
+- (void)removeConversationWithID:(NSManagedObjectID *)conversationID
+{
+    [self.conversationNames removeObjectID:conversationID];
+    [self setParticipantIDs:[NSSet set] forConversationWithID:conversationID];
+}
+
+- (void)setParticipantIDs:(NSSet *)participantIDs forConversationWithID:(NSManagedObjectID *)conversationID
+{
+    NSSet *previousParticipantIDs = self.participantIDsByConversationID[conversationID] ?: [NSSet set];
+    if ([previousParticipantIDs isEqualToSet:participantIDs]) {
+        return;
+    }
+    for (NSManagedObjectID *participantID in previousParticipantIDs) {
+        if (! [participantIDs containsObject:participantID]) {
+            NSMutableSet *conversationIDs = self.conversationIDsByParticipantID[participantID];
+            [conversationIDs removeObject:conversationID];
+            if (conversationIDs.count == 0) {
+                [self.conversationIDsByParticipantID removeObjectForKey:participantID];
+            }
+        }
+    }
+    for (NSManagedObjectID *participantID in participantIDs) {
+        if (! [previousParticipantIDs containsObject:participantID]) {
+            NSMutableSet *conversationIDs = self.conversationIDsByParticipantID[participantID];
+            if (conversationIDs == nil) {
+                conversationIDs = [NSMutableSet set];
+                self.conversationIDsByParticipantID[participantID] = conversationIDs;
+            }
+            [conversationIDs addObject:conversationID];
+        }
+    }
+    if (participantIDs.count > 0) {
+        self.participantIDsByConversationID[conversationID] = [participantIDs copy];
+    } else {
+        [self.participantIDsByConversationID removeObjectForKey:conversationID];
+    }
+}
+
+#pragma mark - Queries
+
+- (NSArray<NSManagedObjectID *> *)userObjectIDsMatchingSearchString:(NSString *)searchString
+{
+    NSArray *words = SearchWordsInString(searchString);
+    if (words.count == 0) {
+        return nil;
+    }
+    NSString *emailAddress = [searchString stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]].lowercaseString;
+    
+    @synchronized(self) {
+        if (! self.isBuilt) {
+            [self scheduleBuild];
+            return nil;
+        }
+        
+        NSMutableSet *userIDs = [self userIDsMatchingWords:words];
+        NSSet *userIDsWithEmailAddress = self.userIDsByEmailAddress[emailAddress];
+        if (userIDsWithEmailAddress != nil) {
+            [userIDs unionSet:userIDsWithEmailAddress];
+        }
+        return [self sortedObjectIDs:userIDs inPostings:self.userNames firstWord:words.firstObject];
+    }
+}
+
+- (NSArray<NSManagedObjectID *> *)conversationObjectIDsMatchingSearchString:(NSString *)searchString
+{
+    NSArray *words = SearchWordsInString(searchString);
+    if (words.count == 0) {
+        return nil;
+    }
+    
+    @synchronized(self) {
+        if (! self.isBuilt) {
+            [self scheduleBuild];
+            return nil;
+        }
+        
+        NSMutableSet *conversationIDs;
+        for (NSString *word in words) {
+            NSMutableSet *matches = [self.conversationNames objectIDsWithWordPrefix:word];
+            for (NSManagedObjectID *userID in [self.userNames objectIDsWithWordPrefix:word]) {
+                NSSet *participantConversationIDs = self.conversationIDsByParticipantID[userID];
+                if (participantConversationIDs != nil) {
+                    [matches unionSet:participantConversationIDs];
+                }
+            }
+            if (conversationIDs == nil) {
+                conversationIDs = matches;
+            } else {
+                [conversationIDs intersectSet:matches];
+            }
+            if (conversationIDs.count == 0) {
+                break;
+            }
+        }
+        
+        // Conversations whose own name matches come before the ones that only match by their participants
+        NSMutableArray *matchingByName = [NSMutableArray array];
+        NSMutableArray *matchingByParticipants = [NSMutableArray array];
+        for (NSManagedObjectID *conversationID in conversationIDs) {
+            BOOL matchesName = YES;
+            for (NSString *word in words) {
+                if (! [self.conversationNames objectID:conversationID hasWordWithPrefix:word]) {
+                    matchesName = NO;
+                    break;
+                }
+            }
+            [(matchesName ? matchingByName : matchingByParticipants) addObject:conversationID];
+        }
+        NSArray *sorted = [self sortedObjectIDs:[NSSet setWithArray:matchingByName] inPostings:self.conversationNames firstWord:words.firstObject];
+        return [sorted arrayByAddingObjectsFromArray:[self sortedObjectIDs:[NSSet setWithArray:matchingByParticipants] inPostings:self.conversationNames firstWord:words.firstObject]];
+    }
+}
+
+- (NSMutableSet *)userIDsMatchingWords:(NSArray<NSString *> *)words
+{
+    NSMutableSet *userIDs;
+    for (NSString *word in words) {
+        NSMutableSet *matches = [self.userNames objectIDsWithWordPrefix:word];
+        if (userIDs == nil) {
+            userIDs = matches;
+        } else {
+            [userIDs intersectSet:matches];
+        }
+        if (userIDs.count == 0) {
+            break;
+        }
+    }
+    return userIDs ?: [NSMutableSet set];
+}
+
+/// Names that start with the first word of the query come first, then everything by name
+- (NSArray *)sortedObjectIDs:(NSSet *)objectIDs inPostings:(ZMSearchWordPostings *)postings firstWord:(NSString *)firstWord
+{
+    return [objectIDs.allObjects sortedArrayUsingComparator:^NSComparisonResult(NSManagedObjectID *objectID1, NSManagedObjectID *objectID2) {
+        NSString *name1 = [postings normalizedNameForObjectID:objectID1] ?: @"";
+        NSString *name2 = [postings normalizedNameForObjectID:objectID2] ?: @"";
+        BOOL const isPrefix1 = [name1 hasPrefix:firstWord];
+        BOOL const isPrefix2 = [name2 hasPrefix:firstWord];
+        if (isPrefix1 != isPrefix2) {
+            return isPrefix1 ? NSOrderedAscending : NSOrderedDescending;
+        }
+        return [name1 compare:name2 options:NSLiteralSearch];
+    }];
+}
+
+#pragma mark - ZMContextChangeTracker
+
+- (NSSet<NSString *> *)trackedEntityNames
+{
+    return [NSSet setWithObjects:ZMUser.entityName, ZMConversation.entityName, nil];
+}
+
+- (void)objectsDidChange:(NSSet *)objects
+{
+    @synchronized(self) {
+        if (! self.isBuilt) {
+            return;
+        }
+        for (NSManagedObject *object in objects) {
+            if ([object isKindOfClass:ZMUser.class]) {
+                [self indexUser:(ZMUser *)object];
+            }
+            else if ([object isKindOfClass:ZMConversation.class]) {
+                [self indexConversation:(ZMConversation *)object];
+            }
+        }
+    }
+}
+
+- (NSFetchRequest *)fetchRequestForTrackedObjects
+{
+    return nil;
+}
+
+- (void)addTrackedObjects:(NSSet *)objects;
+{
+    NOT_USED(objects);
+}
+
+@end
@@ -41,6 +41,17 @@ typedef void(^ZMSearchResultHandler)(ZMSearchResult *result);
 
 @property (nonatomic) NSTimeInterval timeout;
 @property (nonatomic) NSTimeInterval updateDelay;
+/// How long to wait before sending the request to the backend
+@property (nonatomic) NSTimeInterval remoteSearchDelay;
+
+/// YES while the request to the backend has not been sent or has not returned yet
+@property (nonatomic, readonly) BOOL isWaitingForRemoteResult;
+
+/// YES if the search is done and its result is still cached, so a search for a narrower query can filter its local results
+@property (nonatomic, readonly) BOOL hasRefinableLocalResult;
+
+/// YES if the search is done and its result is no longer cached. It can neither send its result again nor be refined.
+@property (nonatomic, readonly) BOOL hasExpired;
 
 @property (nonatomic, copy) ZMSearchResultHandler resultHandler;
 
@@ -52,6 +63,14 @@ typedef void(^ZMSearchResultHandler)(ZMSearchResult *result);
 
 - (void)start;
 
+/// Starts the search by filtering the local results of a search that the request of the receiver narrows down,
+/// instead of searching locally again. The backend is still asked, since it matches on more than names.
+/// Falls back to -start if that search has no refinable local result.
+- (void)startByRefiningLocalResultOfSearch:(ZMSearch *)search;
+
+/// Stops waiting for the backend and finishes with the local results, e.g. because a newer query replaced this one
+- (void)cancelRemoteSearch;
+
 + (ZMSearchToken)tokenForRequest:(ZMSearchRequest *)request;
 
 @end
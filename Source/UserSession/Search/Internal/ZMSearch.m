@@ -26,6 +26,7 @@
 #import "ZMSearchRequestCodec.h"
 #import "ZMUserSession+Internal.h"
 #import "ZMSearchRequest+Internal.h"
+#import "ZMLocalSearchIndex.h"
 
 @interface ZMSearchRequest (ZMSearchToken) <ZMSearchToken>
 @end
@@ -41,6 +42,12 @@
 
 @property (nonatomic) NSTimer *timeoutTimer;
 @property (nonatomic) NSTimer *updateDelayTimer;
+@property (nonatomic) NSTimer *remoteSearchDelayTimer;
+
+@property (nonatomic) BOOL isWaitingForRemoteResult;
+/// The objects found by the local search, in the search context. May only be accessed from the search context.
+@property (nonatomic) NSArray *localUserResults;
+@property (nonatomic) NSArray *localConversationResults;
 
 @property (nonatomic) ZMSearchState state; //May only be accessed / modified from ui queue
 
@@ -100,6 +107,7 @@
 
 
 - (void)tearDown {
+    [self releaseLocalResults];
     _userInterfaceContext = nil;
     _searchContext = nil;
     _userSession = nil;
@@ -107,6 +115,27 @@
 
     [self.timeoutTimer invalidate];
     [self.updateDelayTimer invalidate];
+    [self.remoteSearchDelayTimer invalidate];
+}
+
+- (BOOL)hasRefinableLocalResult
+{
+    // The local results are only reused as long as the result itself is cached
+    return self.state == ZMSearchStateDone && [self.resultCache objectForKey:self] != nil;
+}
+
+- (BOOL)hasExpired
+{
+    return self.state == ZMSearchStateDone && [self.resultCache objectForKey:self] == nil;
+}
+
+/// The local results are only needed to refine them while the result is cached
+- (void)releaseLocalResults
+{
+    [self.searchContext performGroupedBlock:^{
+        self.localUserResults = nil;
+        self.localConversationResults = nil;
+    }];
 }
 
 - (BOOL)tryToSendCachedResult {
@@ -119,6 +148,46 @@
     return NO;
 }
 
+- (void)startByRefiningLocalResultOfSearch:(ZMSearch *)search
+{
+    if (! search.hasRefinableLocalResult || ! [self.request refinesSearchRequest:search.request]) {
+        [self start];
+        return;
+    }
+    
+    if([self tryToSendCachedResult]) {
+        return;
+    }
+    
+    self.state = ZMSearchStateInProgress;
+    
+    [self startRefiningLocalResultOfSearch:search];
+    [self startTimeout];
+    [self startRemoteSearch];
+}
+
+/// Everything our query matches locally was matched by the broader query of the given search, so we only filter its local results
+- (void)startRefiningLocalResultOfSearch:(ZMSearch *)search
+{
+    ZM_WEAK(self);
+    [self.searchContext performGroupedBlock:^{
+        ZM_STRONG(self);
+        if(!self) {
+            return;
+        }
+        
+        NSPredicate *userPredicate = [ZMUser predicateForConnectedUsersWithSearchString:self.request.query];
+        NSArray *userResults = [search.localUserResults filteredArrayUsingPredicate:userPredicate];
+        
+        NSPredicate *conversationPredicate = [ZMConversation predicateForSearchString:self.request.query];
+        NSSortDescriptor *sortDescriptor = [NSSortDescriptor sortDescriptorWithKey:ZMNormalizedUserDefinedNameKey ascending:YES];
+        NSArray *conversations = [[search.localConversationResults filteredArrayUsingPredicate:conversationPredicate] sortedArrayUsingDescriptors:@[sortDescriptor]];
+        NSArray *conversationResults = [self sortedConversationResults:conversations forSearchString:self.request.query];
+        
+        [self handleLocalUserResults:userResults conversationResults:conversationResults];
+    }];
+}
+
 - (void)startLocalSearch
 {
     ZM_WEAK(self);
@@ -147,13 +216,36 @@
 
 - (NSArray *)connectedUsersMatchingSearchString:(NSString *)searchString
 {
-    NSFetchRequest *userFetchRequest = [ZMUser sortedFetchRequestWithPredicate:[ZMUser predicateForConnectedUsersWithSearchString:searchString]];
+    NSPredicate *predicate = [ZMUser predicateForConnectedUsersWithSearchString:searchString];
+    NSArray *candidateIDs = [self.userSession.localSearchIndex userObjectIDsMatchingSearchString:searchString];
+    if (candidateIDs != nil) {
+        if (candidateIDs.count == 0) {
+            return @[];
+        }
+        predicate = [self predicate:predicate restrictedToObjectIDs:candidateIDs];
+    }
+    NSFetchRequest *userFetchRequest = [ZMUser sortedFetchRequestWithPredicate:predicate];
     return [self.searchContext executeFetchRequestOrAssert:userFetchRequest];
 }
 
+/// The local search index returns a superset of what the predicate matches, so the predicate is only evaluated on those rows
+- (NSPredicate *)predicate:(NSPredicate *)predicate restrictedToObjectIDs:(NSArray<NSManagedObjectID *> *)objectIDs
+{
+    NSPredicate *objectIDsPredicate = [NSPredicate predicateWithFormat:@"SELF IN %@", objectIDs];
+    return [NSCompoundPredicate andPredicateWithSubpredicates:@[objectIDsPredicate, predicate]];
+}
+
 - (NSArray *)conversationsMatchingSearchString:(NSString *)searchString
 {
-    NSFetchRequest *conversationFetchRequest = [ZMConversation sortedFetchRequestWithPredicate:[ZMConversation predicateForSearchString:searchString]];
+    NSPredicate *predicate = [ZMConversation predicateForSearchString:searchString];
+    NSArray *candidateIDs = [self.userSession.localSearchIndex conversationObjectIDsMatchingSearchString:searchString];
+    if (candidateIDs != nil) {
+        if (candidateIDs.count == 0) {
+            return @[];
+        }
+        predicate = [self predicate:predicate restrictedToObjectIDs:candidateIDs];
+    }
+    NSFetchRequest *conversationFetchRequest = [ZMConversation sortedFetchRequestWithPredicate:predicate];
     
     NSSortDescriptor *sortDescriptor = [NSSortDescriptor sortDescriptorWithKey:ZMNormalizedUserDefinedNameKey ascending:YES];
     conversationFetchRequest.sortDescriptors = @[sortDescriptor];
@@ -185,6 +277,9 @@
 - (void)handleLocalUserResults:(NSArray *)userResults
            conversationResults:(NSArray *)conversationResults
 {
+    self.localUserResults = userResults;
+    self.localConversationResults = conversationResults;
+    
     ZM_WEAK(self);
     [self.userInterfaceContext performGroupedBlock:^{
 
@@ -264,7 +359,7 @@
 
 - (void)startTimeout
 {
-    self.timeoutTimer = [NSTimer scheduledTimerWithTimeInterval:self.timeout
+    self.timeoutTimer = [NSTimer scheduledTimerWithTimeInterval:self.timeout + self.remoteSearchDelay
                                                          target:self
                                                        selector:@selector(remoteRequestDidNotFinish:)
                                                        userInfo:nil
@@ -308,13 +403,47 @@
 
 - (void)startRemoteSearch
 {
-    ZM_WEAK(self);
     if (! self.request.includeRemoteResults) {
         // We pretend that the remote call timed out. Same as skipping it.
         [self remoteRequestDidNotFinish:nil];
         return;
     }
     
+    self.isWaitingForRemoteResult = YES;
+    if (self.remoteSearchDelay > 0) {
+        self.remoteSearchDelayTimer = [NSTimer scheduledTimerWithTimeInterval:self.remoteSearchDelay
+                                                                       target:self
+                                                                     selector:@selector(remoteSearchDelayDidPass:)
+                                                                     userInfo:nil
+                                                                      repeats:NO];
+    } else {
+        [self sendRemoteSearchRequest];
+    }
+}
+
+- (void)remoteSearchDelayDidPass:(id)sender
+{
+    NOT_USED(sender);
+    if (self.isWaitingForRemoteResult && self.userSession != nil) {
+        [self sendRemoteSearchRequest];
+    }
+}
+
+- (void)cancelRemoteSearch
+{
+    if (! self.isWaitingForRemoteResult) {
+        return;
+    }
+    // If the request was already sent, its response is ignored
+    self.isWaitingForRemoteResult = NO;
+    [self.remoteSearchDelayTimer invalidate];
+    [self.timeoutTimer invalidate];
+    [self remoteRequestDidNotFinish:nil];
+}
+
+- (void)sendRemoteSearchRequest
+{
+    ZM_WEAK(self);
     ZMTransportRequest *request = [ZMSearchRequestCodec searchRequestForQueryString:self.request.query levels:3 fetchLimit:30];
     [request setDebugInformationTranscoder:self];
     [request addCompletionHandler:[ZMCompletionHandler handlerOnGroupQueue:self.userInterfaceContext block:^(ZMTransportResponse *response) {
@@ -323,6 +452,11 @@
             // the session has been tornDown but not deallocated
             return;
         }
+        if (! self.isWaitingForRemoteResult) {
+            // the remote search has been cancelled
+            return;
+        }
+        self.isWaitingForRemoteResult = NO;
 
         ZMSearchResult *searchResult = [ZMSearchRequestCodec searchResultFromTransportResponse:response ignoredIDs:self.request.ignoredIDs userSession:self.userSession];
 
@@ -405,6 +539,7 @@
 {
     NOT_USED(sender);
     [self.resultCache removeObjectForKey:self];
+    [self releaseLocalResults];
 }
 
 - (void)sendSearchResult:(ZMSearchResult *)searchResult
@@ -26,20 +26,29 @@
 - (instancetype)init NS_UNAVAILABLE;
 
 /// Returns a address book matcher with contacts from a user session.
+/// Prefer the @c addressBookMatcher of the user session, which is only rebuilt when the address book changes.
 - (instancetype)initWithUserSession:(ZMUserSession *)userSession;
 
 /// Returns a address book matcher which perform matching operations on the array of contacts.
+/// This indexes the email addresses, phone numbers and names of the contacts up front, which takes a while
+/// for a large address book. It should not be done on the main queue.
 - (instancetype)initWithContacts:(NSArray *)contacts NS_DESIGNATED_INITIALIZER;
 
+@property (nonatomic, readonly) NSArray *contacts;
+
 /// Returns a contact matching a user based on email address or phone number.
+/// Email addresses are compared ignoring case and surrounding whitespace, phone numbers ignoring everything but digits
+/// and a leading '+'. They used to be compared exactly, so e.g. "John@Example.com" and "john@example.com", or
+/// "+49 30 1234" and "+49301234", now match where they did not before.
 - (ZMAddressBookContact *)contactForUser:(ZMUser *)user;
 
 /// Returns an index set over the users matched to contacts. For each contact
 /// the block is called with the contact and/or matching user if a match was
 /// found otherwise nil.
+/// Email addresses and phone numbers are normalized the same way as in @c -contactForUser:.
 - (NSIndexSet *)matchUsers:(NSArray *)users withContacts:(NSArray *)contacts block:(void (^)(ZMAddressBookContact *contact, ZMUser *matchedUser))block;
 
-/// Returns contacts filtered by the query.
+/// Returns contacts whose name contains the query, ignoring case and diacritics, in the order of the contacts.
 - (NSArray *)contactsMatchingQuery:(NSString *)query;
 
 @end
@@ -21,13 +21,68 @@
 #import "ZMAddressBookMatcher.h"
 #import "ZMUserSession+Internal.h"
 
+
+static NSString *NormalizedEmailAddress(NSString *emailAddress)
+{
+    NSString *normalized = [emailAddress stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]].lowercaseString;
+    return (normalized.length > 0) ? normalized : nil;
+}
+
+static NSString *NormalizedPhoneNumber(NSString *phoneNumber)
+{
+    NSMutableString *normalized = [NSMutableString stringWithCapacity:phoneNumber.length];
+    NSCharacterSet *digits = [NSCharacterSet decimalDigitCharacterSet];
+    for (NSUInteger i = 0; i < phoneNumber.length; ++i) {
+        unichar c = [phoneNumber characterAtIndex:i];
+        if ([digits characterIsMember:c] || (c == '+' && normalized.length == 0)) {
+            [normalized appendFormat:@"%C", c];
+        }
+    }
+    return (normalized.length > 0) ? normalized : nil;
+}
+
+/// Folds the string the way CONTAINS[cd] compares strings
+static NSString *FoldedString(NSString *string)
+{
+    return [string stringByFoldingWithOptions:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch locale:nil];
+}
+
+static NSArray<NSString *> *WordsInString(NSString *string)
+{
+    NSMutableArray *words = [NSMutableArray array];
+    for (NSString *word in [string componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]]) {
+        if (word.length > 0) {
+            [words addObject:word];
+        }
+    }
+    return words;
+}
+
+static NSComparisonResult CompareLiterally(NSString *lhs, NSString *rhs)
+{
+    return [lhs compare:rhs options:NSLiteralSearch];
+}
+
+
+
 @interface ZMAddressBookMatcher ()
 
-@property (nonatomic, readonly) NSArray *contacts;
+/// Normalized email address -> index of the first contact with that email address
+@property (nonatomic, readonly) NSDictionary<NSString *, NSNumber *> *contactIndexByEmailAddress;
+/// Normalized phone number -> index of the first contact with that phone number
+@property (nonatomic, readonly) NSDictionary<NSString *, NSNumber *> *contactIndexByPhoneNumber;
+/// The folded names of the contacts, in the order of the contacts
+@property (nonatomic, readonly) NSArray<NSString *> *foldedNames;
+/// Every suffix of every word of the folded names -> indexes of the contacts that have it.
+/// A word of a query is a substring of a name if it is the prefix of one of these suffixes.
+@property (nonatomic, readonly) NSDictionary<NSString *, NSIndexSet *> *contactIndexesByNameSuffix;
+/// The keys of contactIndexesByNameSuffix, sorted literally so that suffixes with the same prefix are next to each other
+@property (nonatomic, readonly) NSArray<NSString *> *sortedNameSuffixes;
 
 @end
 
 
+
 @implementation ZMAddressBookMatcher
 
 - (instancetype)initWithUserSession:(ZMUserSession *)userSession
@@ -41,38 +96,118 @@
     
     if (self) {
         _contacts = contacts;
+        [self buildIndexes];
     }
     
     return self;
 }
 
+- (void)buildIndexes
+{
+    NSMutableDictionary *contactIndexByEmailAddress = [NSMutableDictionary dictionary];
+    NSMutableDictionary *contactIndexByPhoneNumber = [NSMutableDictionary dictionary];
+    NSMutableArray *foldedNames = [NSMutableArray arrayWithCapacity:self.contacts.count];
+    NSMutableDictionary *contactIndexesByNameSuffix = [NSMutableDictionary dictionary];
+    
+    [self.contacts enumerateObjectsUsingBlock:^(ZMAddressBookContact *contact, NSUInteger idx, BOOL * __unused stop) {
+        for (NSString *emailAddress in contact.emailAddresses) {
+            NSString *key = NormalizedEmailAddress(emailAddress);
+            if (key != nil && contactIndexByEmailAddress[key] == nil) {
+                contactIndexByEmailAddress[key] = @(idx);
+            }
+        }
+        for (NSString *phoneNumber in contact.phoneNumbers) {
+            NSString *key = NormalizedPhoneNumber(phoneNumber);
+            if (key != nil && contactIndexByPhoneNumber[key] == nil) {
+                contactIndexByPhoneNumber[key] = @(idx);
+            }
+        }
+        
+        NSString *foldedName = FoldedString(contact.name) ?: @"";
+        [foldedNames addObject:foldedName];
+        for (NSString *word in WordsInString(foldedName)) {
+            [word enumerateSubstringsInRange:NSMakeRange(0, word.length) options:NSStringEnumerationByComposedCharacterSequences | NSStringEnumerationSubstringNotRequired usingBlock:^(NSString * __unused substring, NSRange substringRange, NSRange __unused enclosingRange, BOOL * __unused stopEnumeration) {
+                NSString *suffix = [word substringFromIndex:substringRange.location];
+                NSMutableIndexSet *indexes = contactIndexesByNameSuffix[suffix];
+                if (indexes == nil) {
+                    indexes = [NSMutableIndexSet indexSet];
+                    contactIndexesByNameSuffix[suffix] = indexes;
+                }
+                [indexes addIndex:idx];
+            }];
+        }
+    }];
+    
+    _contactIndexByEmailAddress = contactIndexByEmailAddress;
+    _contactIndexByPhoneNumber = contactIndexByPhoneNumber;
+    _foldedNames = foldedNames;
+    _contactIndexesByNameSuffix = contactIndexesByNameSuffix;
+    _sortedNameSuffixes = [contactIndexesByNameSuffix.allKeys sortedArrayUsingComparator:^NSComparisonResult(NSString *lhs, NSString *rhs) {
+        return CompareLiterally(lhs, rhs);
+    }];
+}
+
 - (NSArray *)contactsMatchingQuery:(NSString *)query
 {
     if (query.length == 0) {
         return self.contacts;
-    } else {
-        return [self.contacts filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF.name CONTAINS[cd] %@", query]];
     }
+    
+    NSString *foldedQuery = FoldedString(query);
+    NSIndexSet *candidates = [self contactIndexesWithNameContainingWordsOfFoldedQuery:foldedQuery];
+    
+    NSMutableArray *matchingContacts = [NSMutableArray array];
+    [candidates enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL * __unused stop) {
+        if ([self.foldedNames[idx] rangeOfString:foldedQuery options:NSLiteralSearch].location != NSNotFound) {
+            [matchingContacts addObject:self.contacts[idx]];
+        }
+    }];
+    return matchingContacts;
 }
 
-- (ZMAddressBookContact *)contactForUser:(ZMUser *)user
+/// Each word of the query lies within a word of any name that contains the query, so the contacts with a name suffix
+/// starting with the longest word of the query are a superset of the matching contacts.
+- (NSIndexSet *)contactIndexesWithNameContainingWordsOfFoldedQuery:(NSString *)foldedQuery
 {
-    ZMAddressBookContact *matchedContact;
-    
-    for (ZMAddressBookContact *contact in self.contacts) {
-        
-        if (user.emailAddress.length > 0 && [contact.emailAddresses containsObject:user.emailAddress]) {
-            matchedContact = contact;
-            break;
-        }
-        
-        if (user.phoneNumber.length > 0 && [contact.phoneNumbers containsObject:user.phoneNumber]) {
-            matchedContact = contact;
-            break;
+    NSString *longestWord;
+    for (NSString *word in WordsInString(foldedQuery)) {
+        if (word.length > longestWord.length) {
+            longestWord = word;
         }
     }
+    if (longestWord == nil) {
+        return [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, self.contacts.count)];
+    }
     
-    return matchedContact;
+    NSArray *suffixes = self.sortedNameSuffixes;
+    NSUInteger firstIndex = [suffixes indexOfObject:longestWord
+                                      inSortedRange:NSMakeRange(0, suffixes.count)
+                                            options:NSBinarySearchingInsertionIndex | NSBinarySearchingFirstEqual
+                                    usingComparator:^NSComparisonResult(NSString *lhs, NSString *rhs) {
+                                        return CompareLiterally(lhs, rhs);
+                                    }];
+    
+    NSMutableIndexSet *candidates = [NSMutableIndexSet indexSet];
+    for (NSUInteger i = firstIndex; i < suffixes.count && [suffixes[i] hasPrefix:longestWord]; ++i) {
+        [candidates addIndexes:self.contactIndexesByNameSuffix[suffixes[i]]];
+    }
+    return candidates;
+}
+
+- (ZMAddressBookContact *)contactForUser:(ZMUser *)user
+{
+    // The first contact that has either the email address or the phone number of the user
+    NSString *emailAddress = NormalizedEmailAddress(user.emailAddress);
+    NSString *phoneNumber = NormalizedPhoneNumber(user.phoneNumber);
+    NSNumber *emailAddressIndex = (emailAddress != nil) ? self.contactIndexByEmailAddress[emailAddress] : nil;
+    NSNumber *phoneNumberIndex = (phoneNumber != nil) ? self.contactIndexByPhoneNumber[phoneNumber] : nil;
+    
+    if (emailAddressIndex == nil && phoneNumberIndex == nil) {
+        return nil;
+    }
+    NSUInteger index = MIN(emailAddressIndex != nil ? emailAddressIndex.unsignedIntegerValue : NSNotFound,
+                           phoneNumberIndex != nil ? phoneNumberIndex.unsignedIntegerValue : NSNotFound);
+    return self.contacts[index];
 }
 
 - (NSIndexSet *)matchUsers:(NSArray *)users withContacts:(NSArray *)contacts block:(void (^)(ZMAddressBookContact *contact, ZMUser *user))block
@@ -80,42 +215,49 @@
     NSMutableDictionary *phoneNumberIndex = [NSMutableDictionary dictionary];
     NSMutableDictionary *emailAddressIndex = [NSMutableDictionary dictionary];
     
-    for (ZMUser *user in users) {
-        
-        if (user.phoneNumber.length > 0) {
-            [phoneNumberIndex setObject:user forKey:user.phoneNumber];
+    [users enumerateObjectsUsingBlock:^(ZMUser *user, NSUInteger idx, BOOL * __unused stop) {
+        NSString *phoneNumber = NormalizedPhoneNumber(user.phoneNumber);
+        if (phoneNumber != nil) {
+            [phoneNumberIndex setObject:@(idx) forKey:phoneNumber];
         }
         
-        if (user.emailAddress.length > 0) {
-            [emailAddressIndex setObject:user forKey:user.emailAddress];
+        NSString *emailAddress = NormalizedEmailAddress(user.emailAddress);
+        if (emailAddress != nil) {
+            [emailAddressIndex setObject:@(idx) forKey:emailAddress];
         }
-    }
+    }];
     
     NSMutableIndexSet *matchedIndexSet = [NSMutableIndexSet indexSet];
     
     for (ZMAddressBookContact *contact in contacts) {
-        ZMUser *matchedUser = nil;
+        NSNumber *matchedIndex = nil;
         
         for (NSString *emailAddress in contact.emailAddresses) {
-            matchedUser = [emailAddressIndex objectForKey:emailAddress];
+            NSString *key = NormalizedEmailAddress(emailAddress);
+            matchedIndex = (key != nil) ? [emailAddressIndex objectForKey:key] : nil;
             
-            if (matchedUser != nil) {
-                [matchedIndexSet addIndex:[users indexOfObject:matchedUser]];
+            if (matchedIndex != nil) {
                 break;
             }
         }
         
-        if (matchedUser == nil) {
+        if (matchedIndex == nil) {
             for (NSString *phoneNumber in contact.phoneNumbers) {
-                matchedUser = [phoneNumberIndex objectForKey:phoneNumber];
+                NSString *key = NormalizedPhoneNumber(phoneNumber);
+                matchedIndex = (key != nil) ? [phoneNumberIndex objectForKey:key] : nil;
                 
-                if (matchedUser != nil) {
-                    [matchedIndexSet addIndex:[users indexOfObject:matchedUser]];
+                if (matchedIndex != nil) {
                     break;
                 }
             }
         }
         
+        ZMUser *matchedUser = nil;
+        if (matchedIndex != nil) {
+            [matchedIndexSet addIndex:matchedIndex.unsignedIntegerValue];
+            matchedUser = users[matchedIndex.unsignedIntegerValue];
+        }
+        
         block(contact, matchedUser);
     }
     
@@ -25,6 +25,7 @@
 @interface ZMSearchDirectory (Testing)
 
 @property (nonatomic, readonly) ZMUserSession *userSession;
+@property (nonatomic, readonly) NSMutableDictionary *searchMap;
 - (instancetype)initWithUserSession:(ZMUserSession *)userSession searchContext:(NSManagedObjectContext *)searchContext;
 - (instancetype)initWithUserSession:(ZMUserSession *)userSession
                       searchContext:(NSManagedObjectContext *)searchContext
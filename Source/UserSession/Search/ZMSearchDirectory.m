@@ -34,10 +34,12 @@
 #import "ZMSearchResult+Internal.h"
 #import "ZMAddressBookMatcher.h"
 #import "ZMSearchRequest.h"
+#import "ZMSearchRequest+Internal.h"
 
 static NSString * const TopConversationsDidChangeName = @"ZMTopConversationsDidChange";
 static const NSTimeInterval DefaultRemoteSearchTimeout = 1.5;
 static const NSTimeInterval DefaultUpdateDelay = 60;
+static const NSTimeInterval DefaultRemoteSearchDelay = 0.3;
 static const NSTimeInterval TopConversationsTimeout = 60;
 static const int SuggestedUsersFetchLimit = 30;
 
@@ -182,6 +184,7 @@ NSString * const InvalidateTopConversationCacheNotificationName = @"ZMInvalidate
         
         self.remoteSearchTimeout = DefaultRemoteSearchTimeout;
         self.updateDelay = DefaultUpdateDelay;
+        self.remoteSearchDelay = DefaultRemoteSearchDelay;
         
         self.searchResultsCache = [[NSCache alloc] init];
         
@@ -195,6 +198,7 @@ NSString * const InvalidateTopConversationCacheNotificationName = @"ZMInvalidate
 {
     NOT_USED(note);
     [self markCachedTopConversationsAsStale];
+    [self.searchResultsCache removeAllObjects];
 }
 
 - (NSArray *)topConversations
@@ -227,18 +231,65 @@ NSString * const InvalidateTopConversationCacheNotificationName = @"ZMInvalidate
         [self storeSearchResultUserIDsInCache:searchResult];
         
         if (searchRequest.includeAddressBookContacts) {
-            searchResult = [self extendSearchResultWithContactsFromAddressBook:searchResult queryString:searchRequest.query];
+            // The address book is indexed in the background, so the result might have to wait for it
+            [self.userSession addressBookMatcherWithCompletionHandler:^(ZMAddressBookMatcher *matcher) {
+                ZMSearchResult *extendedSearchResult = [self extendSearchResult:searchResult withContactsFromAddressBookMatcher:matcher queryString:searchRequest.query];
+                [self sendSearchResult:extendedSearchResult forToken:token];
+            }];
+        } else {
+            [self sendSearchResult:searchResult forToken:token];
         }
-        
-        [self sendSearchResult:searchResult forToken:token];
     };
     
     self.searchMap[token] = search;
-    [search start];
+    [self startSearch:search];
     
     return token;
 }
 
+/// While the user is typing, each query replaces the previous one. We cancel the remote part of searches that are replaced,
+/// hold back the remote request of the new one while it might get replaced, too, and filter the local results of a
+/// shorter query instead of searching locally again if there are any.
+/// Searches whose result is no longer cached are of no use anymore, so they are removed on the way.
+- (void)startSearch:(ZMSearch *)search
+{
+    ZMSearch *searchToRefine;
+    BOOL replacesRunningSearch = NO;
+    NSMutableArray *expiredTokens = [NSMutableArray array];
+    
+    for (id<ZMSearch> otherSearch in self.searchMap.allValues) {
+        if (otherSearch == search || ! [otherSearch isKindOfClass:ZMSearch.class]) {
+            continue;
+        }
+        ZMSearch *other = (ZMSearch *)otherSearch;
+        if (other.hasExpired) {
+            [other tearDown];
+            [expiredTokens addObject:other.token];
+            continue;
+        }
+        if (! [search.request hasSameOptionsAsSearchRequest:other.request]) {
+            continue;
+        }
+        if (other.isWaitingForRemoteResult) {
+            [other cancelRemoteSearch];
+            replacesRunningSearch = YES;
+        }
+        if ([search.request refinesSearchRequest:other.request] && other.hasRefinableLocalResult &&
+            (searchToRefine == nil || other.request.query.length > searchToRefine.request.query.length))
+        {
+            searchToRefine = other;
+        }
+    }
+    [self.searchMap removeObjectsForKeys:expiredTokens];
+    
+    search.remoteSearchDelay = (replacesRunningSearch || searchToRefine != nil) ? self.remoteSearchDelay : 0;
+    if (searchToRefine != nil) {
+        [search startByRefiningLocalResultOfSearch:searchToRefine];
+    } else {
+        [search start];
+    }
+}
+
 - (ZMSearchToken)searchForUsersThatCanBeAddedToConversation:(ZMConversation *)conversation queryString:(NSString *)queryString;
 {
     ZMSearchRequest *request = [[ZMSearchRequest alloc] init];
@@ -361,18 +412,19 @@ NSString * const InvalidateTopConversationCacheNotificationName = @"ZMInvalidate
     }];
 }
 
-- (ZMSearchResult *)extendSearchResultWithContactsFromAddressBook:(ZMSearchResult *)searchResult queryString:(NSString *)queryString
+- (ZMSearchResult *)extendSearchResult:(ZMSearchResult *)searchResult withContactsFromAddressBookMatcher:(ZMAddressBookMatcher *)matcher queryString:(NSString *)queryString
 {
-    ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithUserSession:self.userSession];
-    
-    NSArray *queryContacts = [matcher contactsMatchingQuery:queryString];
-    NSArray *queryUsers = [searchResult.usersInContacts valueForKey:@"user"];
+    NSHashTable *queryContacts = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+    for (ZMAddressBookContact *contact in [matcher contactsMatchingQuery:queryString]) {
+        [queryContacts addObject:contact];
+    }
+    NSSet *queryUsers = [NSSet setWithArray:[searchResult.usersInContacts valueForKey:@"user"]];
     
     NSMutableArray *matchedUsers = [NSMutableArray array];
     NSMutableArray *localMatchedUsers = [NSMutableArray array];
     
     [matcher matchUsers:[self connectedAndBlockedAndPendingUsers]
-           withContacts:self.userSession.addressBookContacts
+           withContacts:matcher.contacts
                   block:^(ZMAddressBookContact *contact, ZMUser *user) {
                       if ([queryUsers containsObject:user] && (user.connection.status == ZMConnectionStatusAccepted)) {
                           if (contact == nil) {
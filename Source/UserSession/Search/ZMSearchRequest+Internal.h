@@ -23,4 +23,14 @@
 
 @property (nonatomic, readonly) NSArray *ignoredIDs;
 
+/// The words of the normalized query, as the search predicates of the data model match them
+@property (nonatomic, readonly) NSArray *normalizedQueryWords;
+
+/// Returns YES if both requests only differ in their query
+- (BOOL)hasSameOptionsAsSearchRequest:(ZMSearchRequest *)searchRequest;
+
+/// Returns YES if the query of the receiver narrows down the query of the given request, e.g. "ale" narrows down "al".
+/// Everything the receiver matches locally is then part of the results of the given request.
+- (BOOL)refinesSearchRequest:(ZMSearchRequest *)searchRequest;
+
 @end
@@ -22,6 +22,8 @@
 @import ZMCDataModel;
 
 #import "ZMSearchRequest.h"
+#import "ZMSearchRequest+Internal.h"
+#import "NSString+Normalization.h"
 
 
 @implementation ZMSearchRequest
@@ -93,8 +95,12 @@
         return YES;
     }
     
+    return [self.query isEqualToString:searchRequest.query] && [self hasSameOptionsAsSearchRequest:searchRequest];
+}
+
+- (BOOL)hasSameOptionsAsSearchRequest:(ZMSearchRequest *)searchRequest
+{
     BOOL isEqual =
-    [self.query isEqualToString:searchRequest.query] &&
     self.includeContacts == searchRequest.includeContacts &&
     self.includeAddressBookContacts == searchRequest.includeAddressBookContacts &&
     self.includeGroupConversations == searchRequest.includeGroupConversations &&
@@ -105,6 +111,31 @@
     return isEqual;
 }
 
+- (BOOL)refinesSearchRequest:(ZMSearchRequest *)searchRequest
+{
+    if (! [self hasSameOptionsAsSearchRequest:searchRequest]) {
+        return NO;
+    }
+    // Email addresses only match in full, so a longer email address does not narrow down the results of a shorter one
+    if ([self.query containsString:@"@"] || [searchRequest.query containsString:@"@"]) {
+        return NO;
+    }
+    NSString *query = [self.normalizedQueryWords componentsJoinedByString:@" "];
+    NSString *otherQuery = [searchRequest.normalizedQueryWords componentsJoinedByString:@" "];
+    return (otherQuery.length > 0) && [query hasPrefix:otherQuery];
+}
+
+- (NSArray *)normalizedQueryWords
+{
+    NSMutableArray *words = [NSMutableArray array];
+    for (NSString *word in [self.query.normalizedString componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]]) {
+        if (word.length > 0) {
+            [words addObject:word];
+        }
+    }
+    return words;
+}
+
 - (NSArray *)ignoredIDs
 {
     NSMutableArray *ignoredIDs = [NSMutableArray array];
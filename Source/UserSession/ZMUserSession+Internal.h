@@ -38,6 +38,8 @@
 @class ZMAPNSEnvironment;
 @class ClientUpdateStatus;
 @class AVSFlowManager;
+@class ZMLocalSearchIndex;
+@class ZMAddressBookMatcher;
 
 extern NSString * const ZMUserSessionFailedToAccessAddressBookNotificationName;
 extern NSString * const ZMAppendAVSLogNotificationName;
@@ -79,6 +81,7 @@ extern NSString * const ZMAppendAVSLogNotificationName;
 @property (nonatomic, readonly) NSManagedObjectContext *syncManagedObjectContext;
 @property (nonatomic, readonly) AVSFlowManager *flowManager;
 @property (nonatomic, readonly) ZMLocalNotificationDispatcher *localNotificationDispatcher;
+@property (nonatomic, readonly) ZMLocalSearchIndex *localSearchIndex;
 
 - (instancetype)initWithTransportSession:(ZMTransportSession *)session
                 syncManagedObjectContext:(NSManagedObjectContext *)syncManagedObjectContext
@@ -183,6 +186,14 @@ extern NSString * const ZMAppendAVSLogNotificationName;
 
 @property (nonatomic, readonly) NSArray *addressBookContacts;
 
+/// A matcher for the current address book contacts. It is built in the background when the contacts are reloaded,
+/// and is nil until it is done.
+@property (nonatomic, readonly) ZMAddressBookMatcher *addressBookMatcher;
+
+/// Calls the handler on the main queue with the matcher for the current address book contacts,
+/// right away if it is already built, otherwise once it is.
+- (void)addressBookMatcherWithCompletionHandler:(void (^)(ZMAddressBookMatcher *matcher))completionHandler;
+
 /// This operation is very expensive if the user's address book is large.
 - (void)reloadAddressBookContacts;
 
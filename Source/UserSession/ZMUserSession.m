@@ -28,6 +28,7 @@
 #import "ZMUserSession+Internal.h"
 #import "ZMSyncStrategy.h"
 #import "ZMOperationLoop.h"
+#import "ZMOperationLoop+Private.h"
 #import "NSError+ZMUserSessionInternal.h"
 #import "ZMCredentials.h"
 #import "ZMSearchDirectory+Internal.h"
@@ -47,6 +48,7 @@
 #import "NSURL+LaunchOptions.h"
 #import "ZMessagingLogs.h"
 #import "ZMAddressBook.h"
+#import "ZMAddressBookMatcher.h"
 #import "ZMAVSBridge.h"
 #import "ZMOnDemandFlowManager.h"
 #import "ZMCookie.h"
@@ -95,6 +97,8 @@ static NSString * const AppstoreURL = @"https://itunes.apple.com/us/app/zeta-cli
 @property (nonatomic) GiphyRequestsStatus *giphyRequestStatus;
 @property (nonatomic) BOOL isVersionBlacklisted;
 @property (nonatomic) NSArray *cachedAddressBookContacts;
+@property (nonatomic) ZMAddressBookMatcher *cachedAddressBookMatcher;
+@property (nonatomic) NSMutableArray *addressBookMatcherCompletionHandlers;
 @property (nonatomic) dispatch_once_t loadAddressBookContactsOnce;
 @property (nonatomic) ZMOnDemandFlowManager *onDemandFlowManager;
 
@@ -338,6 +342,11 @@ ZM_EMPTY_ASSERTING_INIT()
     self.clientRegistrationStatus.currentPhase == ZMClientRegistrationPhaseRegistered;
 }
 
+- (ZMLocalSearchIndex *)localSearchIndex
+{
+    return self.operationLoop.syncStrategy.localSearchIndex;
+}
+
 - (void)registerForRequestToOpenConversationNotification
 {
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didRequestToOpenSyncConversation:) name:ZMRequestToOpenSyncConversationNotificationName object:nil];
@@ -908,6 +917,56 @@ static NSString * const TrackingIdentifierKey = @"ZMTrackingIdentifier";
     return self.cachedAddressBookContacts;
 }
 
+- (ZMAddressBookMatcher *)addressBookMatcher
+{
+    NSArray *contacts = self.addressBookContacts;
+    if (contacts.count == 0 && self.cachedAddressBookMatcher.contacts != contacts) {
+        // Nothing to index, e.g. without address book authorization
+        self.cachedAddressBookMatcher = [[ZMAddressBookMatcher alloc] initWithContacts:contacts];
+    }
+    return (self.cachedAddressBookMatcher.contacts == contacts) ? self.cachedAddressBookMatcher : nil;
+}
+
+- (void)addressBookMatcherWithCompletionHandler:(void (^)(ZMAddressBookMatcher *matcher))completionHandler
+{
+    ZMAddressBookMatcher *matcher = self.addressBookMatcher;
+    if (matcher != nil) {
+        completionHandler(matcher);
+        return;
+    }
+    if (self.addressBookMatcherCompletionHandlers == nil) {
+        self.addressBookMatcherCompletionHandlers = [NSMutableArray array];
+    }
+    [self.addressBookMatcherCompletionHandlers addObject:[completionHandler copy]];
+}
+
+- (void)buildAddressBookMatcherForContacts:(NSArray *)contacts
+{
+    ZM_WEAK(self);
+    [self.managedObjectContext.dispatchGroup asyncOnQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0) block:^{
+        ZM_STRONG(self);
+        ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithContacts:contacts];
+        [self.managedObjectContext performGroupedBlock:^{
+            [self didBuildAddressBookMatcher:matcher];
+        }];
+    }];
+}
+
+- (void)didBuildAddressBookMatcher:(ZMAddressBookMatcher *)matcher
+{
+    if (matcher.contacts != self.cachedAddressBookContacts) {
+        // The contacts were reloaded in the meantime
+        return;
+    }
+    self.cachedAddressBookMatcher = matcher;
+    
+    NSArray *completionHandlers = self.addressBookMatcherCompletionHandlers;
+    self.addressBookMatcherCompletionHandlers = nil;
+    for (void (^completionHandler)(ZMAddressBookMatcher *) in completionHandlers) {
+        completionHandler(matcher);
+    }
+}
+
 - (void)reloadAddressBookContacts
 {
     ZMAddressBook *addressBook = [ZMAddressBook addressBook];
@@ -921,6 +980,7 @@ static NSString * const TrackingIdentifierKey = @"ZMTrackingIdentifier";
     }
     
     self.cachedAddressBookContacts = contacts;
+    [self buildAddressBookMatcherForContacts:contacts];
 }
 
 @end
@@ -231,4 +231,69 @@
     XCTAssertEqualObjects([self.sut userIDsInConversation:self.conversationA], [NSSet setWithObject:self.userB.objectID]);
 }
 
+- (void)testThatItReturnsTheTimeoutForAUser;
+{
+    // given
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:10];
+    [self.sut addUser:self.userA conversation:self.conversationA withTimeout:timeout];
+    
+    // then
+    XCTAssertEqualObjects([self.sut timeoutForUser:self.userA conversation:self.conversationA], timeout);
+    XCTAssertNil([self.sut timeoutForUser:self.userA conversation:self.conversationB]);
+    XCTAssertNil([self.sut timeoutForUser:self.userB conversation:self.conversationA]);
+}
+
+- (void)testThatItDoesNotPruneAUserWhoseTimeoutWasExtended;
+{
+    // given
+    NSDate *timeout1 = [NSDate dateWithTimeIntervalSinceNow:10];
+    NSDate *timeout2 = [NSDate dateWithTimeIntervalSinceNow:15];
+    NSDate *timeout3 = [NSDate dateWithTimeIntervalSinceNow:20];
+    [self.sut addUser:self.userA conversation:self.conversationA withTimeout:timeout1];
+    [self.sut addUser:self.userA conversation:self.conversationA withTimeout:timeout3];
+    
+    // when
+    NSSet *pruned = [self.sut pruneConversationsThatHaveTimedOutAfter:timeout2];
+    
+    // then
+    XCTAssertEqualObjects(pruned, [NSSet set]);
+    XCTAssertTrue([self.sut containsUser:self.userA conversation:self.conversationA]);
+    XCTAssertEqual(self.sut.firstTimeout, timeout3);
+}
+
+- (void)testThatItDoesNotPruneAConversationForAUserThatWasRemoved;
+{
+    // given
+    NSDate *timeout1 = [NSDate dateWithTimeIntervalSinceNow:10];
+    NSDate *timeout2 = [NSDate dateWithTimeIntervalSinceNow:20];
+    [self.sut addUser:self.userA conversation:self.conversationA withTimeout:timeout1];
+    [self.sut removeUser:self.userA conversation:self.conversationA];
+    
+    // then
+    XCTAssertEqualObjects([self.sut pruneConversationsThatHaveTimedOutAfter:timeout2], [NSSet set]);
+    XCTAssertEqualObjects([self.sut userIDsInConversation:self.conversationA], [NSSet set]);
+}
+
+- (void)testThatItKeepsTheEarliestTimeoutWhenTheSameUsersAreAddedManyTimes;
+{
+    // given
+    NSDate *start = [NSDate date];
+    for (NSUInteger i = 0; i < 200; ++i) {
+        [self.sut addUser:self.userA conversation:self.conversationA withTimeout:[start dateByAddingTimeInterval:100 + i]];
+        [self.sut addUser:self.userB conversation:self.conversationB withTimeout:[start dateByAddingTimeInterval:50 + i]];
+    }
+    
+    // then
+    XCTAssertEqualObjects(self.sut.firstTimeout, [start dateByAddingTimeInterval:249]);
+    
+    // when
+    NSSet *pruned = [self.sut pruneConversationsThatHaveTimedOutAfter:[start dateByAddingTimeInterval:260]];
+    
+    // then
+    XCTAssertEqualObjects(pruned, [NSSet setWithObject:self.conversationB.objectID]);
+    XCTAssertEqualObjects(self.sut.firstTimeout, [start dateByAddingTimeInterval:299]);
+    XCTAssertEqualObjects([self.sut userIDsInConversation:self.conversationA], [NSSet setWithObject:self.userA.objectID]);
+    XCTAssertEqualObjects([self.sut userIDsInConversation:self.conversationB], [NSSet set]);
+}
+
 @end
@@ -994,6 +994,38 @@ extension UserClientRequestStrategyTests {
         XCTAssertTrue(otherClient.failedToEstablishSession)
     }
     
+    func testThatItEstablishesSessionsWithSeveralClientsAndOnlyMarksTheFailedOnes() {
+        //given
+        let (selfClient, otherClient1) = createClients()
+        let lastKey = try! selfClient.keysStore.lastPreKey().data!.base64String()
+        let otherClient2 = self.createRemoteClient(generateValidPrekeysStrings(selfClient, howMany: 1), lastKey: lastKey)
+        let otherClient3 = self.createRemoteClient(generateValidPrekeysStrings(selfClient, howMany: 1), lastKey: lastKey)
+        
+        let message = messageThatMissesRecipient(otherClient1)
+        message.missesRecipient(otherClient2)
+        message.missesRecipient(otherClient3)
+        
+        let payload : [String: [String: AnyObject]] = [
+            otherClient1.user!.remoteIdentifier!.transportString() : [otherClient1.remoteIdentifier : ["id" : 12, "key" : lastKey]],
+            otherClient2.user!.remoteIdentifier!.transportString() : [otherClient2.remoteIdentifier : ["key" : "bad key"]],
+            otherClient3.user!.remoteIdentifier!.transportString() : [otherClient3.remoteIdentifier : ["id" : 12, "key" : lastKey]]
+        ]
+        let (request, response) = missingClientsRequestAndResponse(selfClient, missingClients: [otherClient1, otherClient2, otherClient3], payload: payload)
+        
+        //when
+        self.sut.updateUpdatedObject(selfClient, requestUserInfo: request.userInfo, response: response, keysToParse: request.keys)
+        
+        //then
+        XCTAssertEqual(selfClient.missingClients!.count, 0)
+        XCTAssertEqual(message.missingRecipients.count, 0)
+        XCTAssertFalse(message.isExpired)
+        XCTAssertFalse(otherClient1.failedToEstablishSession)
+        XCTAssertTrue(otherClient2.failedToEstablishSession)
+        XCTAssertFalse(otherClient3.failedToEstablishSession)
+        XCTAssertNotNil(try? selfClient.keysStore.box.sessionById(otherClient1.remoteIdentifier))
+        XCTAssertNotNil(try? selfClient.keysStore.box.sessionById(otherClient3.remoteIdentifier))
+    }
+    
     func generateValidPrekeysStrings(selfClient: UserClient, howMany: Int) -> [String] {
         return try! selfClient.keysStore.box.generatePreKeys(NSMakeRange(0, howMany)).map { $0.data!.base64String() }
     }
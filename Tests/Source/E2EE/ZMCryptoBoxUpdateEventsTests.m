@@ -64,6 +64,36 @@
     XCTAssertEqualObjects(decryptedEvent.uuid, notificationID);
 }
 
+- (void)testThatTheDecryptedOTRMessageAddEventCarriesThePlaintext
+{
+    // given
+    ZMUser *selfUser = [ZMUser selfUserInContext:self.syncMOC];
+    UserClient *selfClient = [self createSelfClient];
+    
+    ZMGenericMessage *message = [ZMGenericMessage messageWithText:self.name nonce:[NSUUID createUUID].transportString];
+    NSError *error;
+    CBSession *session = [selfClient.keysStore.box sessionWithId:selfClient.remoteIdentifier fromPreKey:[selfClient.keysStore lastPreKeyAndReturnError:&error] error:&error];
+    NSData *encryptedData = [session encrypt:message.data error:&error];
+    
+    NSDictionary *payload = @{
+                              @"recipient": selfClient.remoteIdentifier,
+                              @"sender": selfClient.remoteIdentifier,
+                              @"text": [encryptedData base64String]
+                              };
+    NSDictionary *streamPayload = [self eventStreamPayloadWithSender:selfUser internalPayload:payload type:@"conversation.otr-message-add"];
+    ZMUpdateEvent *event = [ZMUpdateEvent eventFromEventStreamPayload:streamPayload uuid:[NSUUID createUUID]];
+    
+    // when
+    ZMUpdateEvent *decryptedEvent = [selfClient.keysStore.box decryptUpdateEventAndAddClient:event managedObjectContext:self.syncMOC];
+    
+    // then
+    XCTAssertNil(event.zm_decryptedData);
+    XCTAssertEqualObjects(decryptedEvent.zm_decryptedData, message.data);
+    XCTAssertNil(decryptedEvent.zm_externalData);
+    XCTAssertEqualObjects([decryptedEvent zm_genericMessage], message);
+    XCTAssertEqual([decryptedEvent zm_genericMessage], [decryptedEvent zm_genericMessage]);
+}
+
 - (void)testThatItCanDecryptOTRAssetAddEvent
 {
     // given
@@ -109,6 +139,8 @@
     XCTAssertEqualObjects(decryptedMessage.nonce.transportString, message.messageId);
     XCTAssertEqualObjects(decryptedMessage.imageAssetStorage.mediumGenericMessage, message);
     XCTAssertEqualObjects(decryptedEvent.uuid, notificationID);
+    XCTAssertEqualObjects(decryptedEvent.zm_decryptedData, message.data);
+    XCTAssertEqualObjects([decryptedEvent zm_genericMessage], message);
 }
 
 - (void)testThatItInsertsAUnableToDecryptMessageIfItCanNotEstablishASession
@@ -195,6 +227,9 @@
     XCTAssertTrue(decryptedEvent.wasDecrypted);
     XCTAssertNotNil(externalData);
     XCTAssertNotNil(text);
+    XCTAssertEqualObjects(decryptedEvent.zm_decryptedData, externalMessage.data);
+    XCTAssertEqualObjects(decryptedEvent.zm_externalData, dataWithKeys.data);
+    XCTAssertEqualObjects([decryptedEvent zm_genericMessage].messageId, textMessage.messageId);
     
     // when
     ZMClientMessage *decryptedMessage = [ZMClientMessage createOrUpdateMessageFromUpdateEvent:decryptedEvent
@@ -208,6 +243,90 @@
     XCTAssertEqualObjects(decryptedEvent.uuid, notificationID);
 }
 
+- (void)testThatItDecryptsABatchOfEventsInOrder
+{
+    // given
+    ZMUser *selfUser = [ZMUser selfUserInContext:self.syncMOC];
+    UserClient *selfClient = [self createSelfClient];
+    
+    NSError *error;
+    CBSession *session = [selfClient.keysStore.box sessionWithId:selfClient.remoteIdentifier fromPreKey:[selfClient.keysStore lastPreKeyAndReturnError:&error] error:&error];
+    
+    NSMutableArray *messages = [NSMutableArray array];
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 3; i++) {
+        ZMGenericMessage *message = [ZMGenericMessage messageWithText:[NSString stringWithFormat:@"%@ %lu", self.name, (unsigned long)i] nonce:[NSUUID createUUID].transportString];
+        NSData *encryptedData = [session encrypt:message.data error:&error];
+        NSDictionary *payload = @{
+                                  @"recipient": selfClient.remoteIdentifier,
+                                  @"sender": selfClient.remoteIdentifier,
+                                  @"text": [encryptedData base64String]
+                                  };
+        NSDictionary *streamPayload = [self eventStreamPayloadWithSender:selfUser internalPayload:payload type:@"conversation.otr-message-add"];
+        [messages addObject:message];
+        [events addObject:[ZMUpdateEvent eventFromEventStreamPayload:streamPayload uuid:[NSUUID createUUID]]];
+    }
+    
+    // an event for another client and an unencrypted event
+    NSDictionary *otherClientPayload = @{
+                                         @"recipient": @"other-client",
+                                         @"sender": selfClient.remoteIdentifier,
+                                         @"text": @"foo"
+                                         };
+    ZMUpdateEvent *otherClientEvent = [ZMUpdateEvent eventFromEventStreamPayload:[self eventStreamPayloadWithSender:selfUser internalPayload:otherClientPayload type:@"conversation.otr-message-add"] uuid:[NSUUID createUUID]];
+    ZMUpdateEvent *unencryptedEvent = [ZMUpdateEvent eventFromEventStreamPayload:[self eventStreamPayloadWithSender:selfUser internalPayload:@{@"name": @"foo"} type:@"conversation.rename"] uuid:[NSUUID createUUID]];
+    [events insertObject:otherClientEvent atIndex:1];
+    [events insertObject:unencryptedEvent atIndex:3];
+    
+    // when
+    ZMUpdateEventsDecryptionBatchResult *batchResult = [selfClient.keysStore.box decryptUpdateEvents:events selfClientIdentifier:selfClient.remoteIdentifier];
+    NSArray<ZMUpdateEvent *> *decryptedEvents = [selfClient.keysStore.box processDecryptionResults:batchResult.results managedObjectContext:self.syncMOC];
+    
+    // then
+    XCTAssertEqual(batchResult.results.count, events.count);
+    for (NSUInteger i = 0; i < events.count; i++) {
+        XCTAssertEqual(batchResult.results[i].event, events[i]);
+    }
+    XCTAssertNil(batchResult.results[1].decryptedEvent);
+    XCTAssertFalse(batchResult.results[1].failedToDecrypt);
+    XCTAssertEqual(batchResult.results[3].decryptedEvent, unencryptedEvent);
+    XCTAssertEqual(batchResult.discoveredClientIdentifiersByUserID.count, 0u);
+    
+    XCTAssertEqual(decryptedEvents.count, 4u);
+    XCTAssertEqualObjects(decryptedEvents[0].zm_decryptedData, [messages[0] data]);
+    XCTAssertEqualObjects(decryptedEvents[1].zm_decryptedData, [messages[1] data]);
+    XCTAssertEqual(decryptedEvents[2], unencryptedEvent);
+    XCTAssertEqualObjects(decryptedEvents[3].zm_decryptedData, [messages[2] data]);
+}
+
+- (void)testThatItReportsFailedDecryptionsInABatch
+{
+    // given
+    ZMUser *selfUser = [ZMUser selfUserInContext:self.syncMOC];
+    UserClient *selfClient = [self createSelfClient];
+    ZMGenericMessage *message = [ZMGenericMessage messageWithText:@"text" nonce:[NSUUID createUUID].transportString];
+    
+    NSDictionary *payload = @{
+                              @"recipient": selfClient.remoteIdentifier,
+                              @"sender": [NSUUID UUID].transportString,
+                              @"text": message.data.base64String // wrong message content
+                              };
+    ZMUpdateEvent *event = [ZMUpdateEvent eventFromEventStreamPayload:[self eventStreamPayloadWithSender:selfUser internalPayload:payload type:@"conversation.otr-message-add"] uuid:[NSUUID createUUID]];
+    
+    // when
+    __block ZMUpdateEventsDecryptionBatchResult *batchResult;
+    [self performIgnoringZMLogError:^{
+        batchResult = [selfClient.keysStore.box decryptUpdateEvents:@[event] selfClientIdentifier:selfClient.remoteIdentifier];
+    }];
+    
+    // then
+    XCTAssertEqual(batchResult.results.count, 1u);
+    XCTAssertTrue(batchResult.results.firstObject.failedToDecrypt);
+    XCTAssertNil(batchResult.results.firstObject.decryptedEvent);
+    XCTAssertNotNil(batchResult.results.firstObject.error);
+    XCTAssertEqual(batchResult.discoveredClientIdentifiersByUserID.count, 0u);
+}
+
 #pragma mark - Helper
 
 - (NSDictionary *)eventStreamPayloadWithSender:(ZMUser *)sender internalPayload:(NSDictionary *)payload type:(NSString *)type
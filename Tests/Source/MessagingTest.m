@@ -60,6 +60,7 @@
 #import "ZMUserProfileUpdateTranscoder.h"
 #import "ZMMessageTranscoder+Internal.h"
 #import "ZMClientMessageTranscoder.h"
+#import "ZMRequestScheduler.h"
 #import <zmessaging/zmessaging-Swift.h>
 
 static const int32_t Mersenne1 = 524287;
@@ -397,6 +398,7 @@ static const int32_t Mersenne3 = 8191;
     
     
     [[[objectDirectory stub] andReturn:moc] moc];
+    [[[objectDirectory stub] andReturn:[[ZMRequestScheduler alloc] initWithManagedObjectContext:moc]] requestScheduler];
     [self verifyMockLater:objectDirectory];
 
     return objectDirectory;
@@ -25,6 +25,7 @@
 #import "ZMLocalNotification.h"
 #import "ZMBadge.h"
 #import "MessagingTest+EventFactory.h"
+#import <zmessaging/zmessaging-Swift.h>
 
 @interface ZMLocalNotificationDispatcherTest : MessagingTest
 @property (nonatomic) ZMLocalNotificationDispatcher *sut;
@@ -528,4 +529,189 @@
     [[self.mockUISharedApplication stub] cancelLocalNotification:OCMOCK_ANY];
 }
 
+
+- (void)testThatItCancelsTheOldestNotificationsOfAConversationWhenItHasTooManyNotifications
+{
+    // given
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 7; ++i) {
+        NSDictionary *data = @{@"name" : [NSString stringWithFormat:@"Name %lu", (unsigned long)i]};
+        [events addObject:[self eventWithPayload:data inConversation:self.conversation1 type:EventConversationRename]];
+    }
+    
+    NSMutableArray *scheduledNotifications = [NSMutableArray array];
+    [[self.mockUISharedApplication stub] scheduleLocalNotification:[OCMArg checkWithBlock:^BOOL(id obj) {
+        [scheduledNotifications addObject:obj];
+        return YES;
+    }]];
+    
+    NSMutableArray *cancelledNotifications = [NSMutableArray array];
+    [[self.mockUISharedApplication stub] cancelLocalNotification:[OCMArg checkWithBlock:^BOOL(id obj) {
+        [cancelledNotifications addObject:obj];
+        return YES;
+    }]];
+    
+    // when
+    [self.sut didReceiveUpdateEvents:events];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual(scheduledNotifications.count, 7u);
+    XCTAssertEqual(self.sut.eventsNotifications.count, 5u);
+    XCTAssertEqual(cancelledNotifications.count, 2u);
+    if (scheduledNotifications.count == 7u && cancelledNotifications.count == 2u) {
+        XCTAssertEqual(cancelledNotifications[0], scheduledNotifications[0]);
+        XCTAssertEqual(cancelledNotifications[1], scheduledNotifications[1]);
+    }
+}
+
+- (void)testThatItDoesNotCancelACallNotificationWhenAConversationHasTooManyNotifications
+{
+    // given
+    ZMUpdateEvent *callEvent = [self callStateEventInConversation:self.conversation1 othersAreJoined:YES selfIsJoined:NO otherIsSendingVideo:NO selfIsSendingVideo:NO sequence:nil];
+    NSMutableArray *events = [NSMutableArray arrayWithObject:callEvent];
+    for (NSUInteger i = 0; i < 6; ++i) {
+        NSDictionary *data = @{@"name" : [NSString stringWithFormat:@"Name %lu", (unsigned long)i]};
+        [events addObject:[self eventWithPayload:data inConversation:self.conversation1 type:EventConversationRename]];
+    }
+    
+    NSMutableArray *scheduledNotifications = [NSMutableArray array];
+    [[self.mockUISharedApplication stub] scheduleLocalNotification:[OCMArg checkWithBlock:^BOOL(id obj) {
+        [scheduledNotifications addObject:obj];
+        return YES;
+    }]];
+    
+    NSMutableArray *cancelledNotifications = [NSMutableArray array];
+    [[self.mockUISharedApplication stub] cancelLocalNotification:[OCMArg checkWithBlock:^BOOL(id obj) {
+        [cancelledNotifications addObject:obj];
+        return YES;
+    }]];
+    
+    // when
+    [self.sut didReceiveUpdateEvents:events];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual(scheduledNotifications.count, 7u);
+    XCTAssertEqual(self.sut.eventsNotifications.count, 6u);
+    XCTAssertEqual(cancelledNotifications.count, 1u);
+    if (scheduledNotifications.count == 7u && cancelledNotifications.count == 1u) {
+        XCTAssertEqual(cancelledNotifications[0], scheduledNotifications[1]);
+    }
+    ZMLocalNotificationForEvent *callNote = self.sut.eventsNotifications.firstObject;
+    XCTAssertTrue(callNote.isExemptFromConversationLimit);
+}
+
+- (void)testThatItKeepsNotificationsForEventsWithoutConversationIDTogetherWithoutLimitingThem
+{
+    // given
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 7; ++i) {
+        NSDictionary *payload = @{@"user" : @{@"id": [NSUUID createUUID].transportString,
+                                              @"name": [NSString stringWithFormat:@"Name %lu", (unsigned long)i]},
+                                  @"type" : EventNewConnection};
+        ZMUpdateEvent *event = [ZMUpdateEvent eventFromEventStreamPayload:payload uuid:nil];
+        XCTAssertNil(event.conversationUUID);
+        [events addObject:event];
+    }
+    
+    // expect
+    [[self.mockUISharedApplication stub] scheduleLocalNotification:OCMOCK_ANY];
+    [[self.mockUISharedApplication reject] cancelLocalNotification:OCMOCK_ANY];
+    
+    // when
+    [self.sut didReceiveUpdateEvents:events];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual(self.sut.eventsNotifications.count, 7u);
+    
+    // after
+    [self.mockUISharedApplication verify];
+    [[self.mockUISharedApplication stub] cancelLocalNotification:OCMOCK_ANY];
+}
+
+- (void)testThatItDoesNotLimitTheNumberOfNotificationsAcrossConversations
+{
+    // given
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 5; ++i) {
+        NSDictionary *data = @{@"name" : [NSString stringWithFormat:@"Name %lu", (unsigned long)i]};
+        [events addObject:[self eventWithPayload:data inConversation:self.conversation1 type:EventConversationRename]];
+        [events addObject:[self eventWithPayload:data inConversation:self.conversation2 type:EventConversationRename]];
+    }
+    
+    // expect
+    [[self.mockUISharedApplication stub] scheduleLocalNotification:OCMOCK_ANY];
+    [[self.mockUISharedApplication reject] cancelLocalNotification:OCMOCK_ANY];
+    
+    // when
+    [self.sut didReceiveUpdateEvents:events];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual(self.sut.eventsNotifications.count, 10u);
+    
+    // after
+    [self.mockUISharedApplication verify];
+    [[self.mockUISharedApplication stub] cancelLocalNotification:OCMOCK_ANY];
+}
+
+- (void)testThatItKeepsTheNotificationsOfOtherConversationsWhenCancellingNotificationsForAConversation
+{
+    // given
+    NSDictionary *data = @{@"content" : @"hallo"};
+    ZMUpdateEvent *event1 = [self eventWithPayload:data inConversation:self.conversation1 type:EventConversationAdd];
+    ZMUpdateEvent *event2 = [self eventWithPayload:data inConversation:self.conversation2 type:EventConversationAdd];
+    
+    [[self.mockUISharedApplication stub] scheduleLocalNotification:OCMOCK_ANY];
+    [[self.mockUISharedApplication stub] cancelLocalNotification:OCMOCK_ANY];
+    
+    [self.sut didReceiveUpdateEvents:@[event1, event2]];
+    WaitForAllGroupsToBeEmpty(0.5);
+    XCTAssertEqual(self.sut.eventsNotifications.count, 2u);
+    
+    // when
+    [self.sut cancelNotificationForConversation:self.conversation1];
+    
+    // then
+    XCTAssertEqual(self.sut.eventsNotifications.count, 1u);
+    ZMLocalNotificationForEvent *remainingNote = self.sut.eventsNotifications.firstObject;
+    XCTAssertEqual(remainingNote.conversation, self.conversation2);
+    
+    // when a new event for the cancelled conversation arrives, it creates a new notification
+    ZMUpdateEvent *event3 = [self eventWithPayload:data inConversation:self.conversation1 type:EventConversationAdd];
+    [self.sut didReceiveUpdateEvents:@[event3]];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual(self.sut.eventsNotifications.count, 2u);
+}
+
+- (void)testThatItAddsMessageAddEventsWithTheSameNonceInDifferentConversations
+{
+    // given
+    NSString *nonce = [NSUUID UUID].transportString;
+    NSDictionary *data = @{@"content" : @"hallo", @"nonce": nonce };
+    ZMUpdateEvent *event1 = [self eventWithPayload:data inConversation:self.conversation1 type:EventConversationAdd];
+    ZMUpdateEvent *event2 = [self eventWithPayload:data inConversation:self.conversation2 type:EventConversationAdd];
+    
+    // expect
+    __block UILocalNotification *notification1;
+    __block UILocalNotification *notification2;
+    [[self.mockUISharedApplication expect] scheduleLocalNotification:ZM_ARG_SAVE(notification1)];
+    [[self.mockUISharedApplication expect] scheduleLocalNotification:ZM_ARG_SAVE(notification2)];
+    
+    // when
+    [self.sut didReceiveUpdateEvents:@[event1, event2]];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqualObjects([self conversationFromNotification:notification1], self.conversation1);
+    XCTAssertEqualObjects([self conversationFromNotification:notification2], self.conversation2);
+    
+    // after
+    [[self.mockUISharedApplication stub] cancelLocalNotification:OCMOCK_ANY];
+}
+
 @end
@@ -21,6 +21,7 @@
 #import "MessagingTest.h"
 #import "ZMAddressBook.h"
 #import "ZMAddressBookEncoder.h"
+#import <CommonCrypto/CommonDigest.h>
 
 
 
@@ -381,6 +382,137 @@
     XCTAssert([self waitForCustomExpectationsWithTimeout:0.5]);
 }
 
+- (void)testThatItEncodesMoreThan1000ContactsInTheOrderOfTheAddressBook;
+{
+    // given
+    [self stubAddressBookWithNumberOfContacts:5000];
+    
+    // then
+    XCTestExpectation *e = [self expectationWithDescription:@"Got payload"];
+    [self.sut createPayloadWithCompletionHandler:^(ZMEncodedAddressBook *encoded) {
+        NSArray *cards = (NSArray *) encoded.otherData;
+        XCTAssertEqual(cards.count, 5000u);
+        [cards enumerateObjectsUsingBlock:^(NSDictionary *card, NSUInteger idx, BOOL * ZM_UNUSED stop) {
+            NSString *phone = [self.contacts[idx] phoneNumbers].firstObject;
+            XCTAssertEqualObjects(card[@"card_id"], ([NSString stringWithFormat:@"%lu", (unsigned long) idx]));
+            XCTAssertEqualObjects(card[@"contact"], @[[self hashOfString:phone]]);
+        }];
+        [e fulfill];
+    }];
+    XCTAssert([self waitForCustomExpectationsWithTimeout:2]);
+}
+
+- (void)testThatTheDigestIsTheSameAsWhenDigestingTheContactsOneAfterAnother;
+{
+    // given
+    [self stubAddressBookWithNumberOfContacts:3000];
+    CC_SHA512_CTX digestContext = {};
+    CC_SHA512_Init(&digestContext);
+    for (ZMAddressBookContact *contact in self.contacts) {
+        NSData *input = [contact.phoneNumbers.firstObject dataUsingEncoding:NSUTF8StringEncoding];
+        CC_SHA512_Update(&digestContext, input.bytes, (CC_LONG) input.length);
+        int32_t numberOfHashes = 1;
+        CC_SHA512_Update(&digestContext, &numberOfHashes, sizeof(numberOfHashes));
+    }
+    NSMutableData *expectedDigest = [NSMutableData dataWithLength:CC_SHA512_DIGEST_LENGTH];
+    CC_SHA512_Final((unsigned char *) expectedDigest.mutableBytes, &digestContext);
+    
+    // then
+    XCTestExpectation *e = [self expectationWithDescription:@"Got payload"];
+    [self.sut createPayloadWithCompletionHandler:^(ZMEncodedAddressBook *encoded) {
+        AssertEqualData(encoded.digest, expectedDigest);
+        [e fulfill];
+    }];
+    XCTAssert([self waitForCustomExpectationsWithTimeout:2]);
+}
+
+- (void)testThatItStopsEncodingContactsAtTheMaximumPayloadSize;
+{
+    // given
+    [self stubAddressBookWithNumberOfContacts:1000];
+    self.sut.maximumPayloadSize = 1000;
+    
+    // then
+    XCTestExpectation *e = [self expectationWithDescription:@"Got payload"];
+    [self.sut createPayloadWithCompletionHandler:^(ZMEncodedAddressBook *encoded) {
+        NSArray *cards = (NSArray *) encoded.otherData;
+        XCTAssertGreaterThan(cards.count, 0u);
+        XCTAssertLessThan(cards.count, 20u);
+        XCTAssertLessThanOrEqual([NSJSONSerialization dataWithJSONObject:cards options:0 error:nil].length, 1000u);
+        [e fulfill];
+    }];
+    XCTAssert([self waitForCustomExpectationsWithTimeout:0.5]);
+}
+
+- (void)testThatItReturnsADigestOfTheContactHashesOfEachCard;
+{
+    // given
+    [self stubAddressBookWithContacts];
+    
+    // then
+    XCTestExpectation *e = [self expectationWithDescription:@"Got payload"];
+    [self.sut createPayloadWithCompletionHandler:^(ZMEncodedAddressBook *encoded) {
+        NSArray *cards = (NSArray *) encoded.otherData;
+        XCTAssertEqual(encoded.cardDigests.count, 2u);
+        XCTAssertEqual(encoded.cardDigests.count, cards.count);
+        [cards enumerateObjectsUsingBlock:^(NSDictionary *card, NSUInteger idx, BOOL * ZM_UNUSED stop) {
+            XCTAssertEqualObjects(encoded.cardDigests[idx], [self hashOfString:[card[@"contact"] componentsJoinedByString:@""]]);
+        }];
+        [e fulfill];
+    }];
+    XCTAssert([self waitForCustomExpectationsWithTimeout:0.5]);
+}
+
+- (void)testThatItReturnsNoCardDigestsWhenTheAddressBookIsEmpty;
+{
+    // given
+    [self stubEmptyAddressBook];
+    
+    // then
+    XCTestExpectation *e = [self expectationWithDescription:@"Got payload"];
+    [self.sut createPayloadWithCompletionHandler:^(ZMEncodedAddressBook *encoded) {
+        XCTAssertEqualObjects(encoded.cardDigests, @[]);
+        [e fulfill];
+    }];
+    XCTAssert([self waitForCustomExpectationsWithTimeout:0.5]);
+}
+
+- (void)testPerformanceOfEncoding10000Contacts;
+{
+    // given
+    [self stubAddressBookWithNumberOfContacts:10000];
+    
+    // when
+    [self measureBlock:^{
+        XCTestExpectation *e = [self expectationWithDescription:@"Got payload"];
+        [self.sut createPayloadWithCompletionHandler:^(ZMEncodedAddressBook *encoded) {
+            XCTAssertEqual(((NSArray *) encoded.otherData).count, 10000u);
+            [e fulfill];
+        }];
+        XCTAssert([self waitForCustomExpectationsWithTimeout:10]);
+    }];
+}
+
+- (NSString *)hashOfString:(NSString *)string
+{
+    NSMutableData *digest = [NSMutableData dataWithLength:CC_SHA256_DIGEST_LENGTH];
+    NSData *input = [string dataUsingEncoding:NSUTF8StringEncoding];
+    CC_SHA256(input.bytes, (CC_LONG) input.length, (unsigned char *) digest.mutableBytes);
+    return [digest base64EncodedStringWithOptions:0];
+}
+
+- (void)stubAddressBookWithNumberOfContacts:(NSUInteger)numberOfContacts;
+{
+    NSMutableArray *contacts = [NSMutableArray array];
+    for (NSUInteger i = 0; i < numberOfContacts; ++i) {
+        ZMAddressBookContact *contact = [[ZMAddressBookContact alloc] init];
+        contact.phoneNumbers = @[[NSString stringWithFormat:@"+4930%07lu", (unsigned long) i]];
+        [contacts addObject:contact];
+    }
+    self.contacts = contacts;
+    [(ZMAddressBook *)[[self.addressBookMock stub] andReturn:self.contacts] contacts];
+}
+
 - (void)stubAddressBookWithSinlgeContactEmails:(NSArray *)emails phoneNumbers:(NSArray *)phoneNumbers;
 {
     ZMAddressBookContact *contactA = [[ZMAddressBookContact alloc] init];
@@ -29,6 +29,8 @@
 #import "ZMUserImageTranscoder.h"
 #import "StateBaseTest.h"
 #import "ZMObjectStrategyDirectory.h"
+#import "ZMRequestScheduler.h"
+#import "ZMRequestGenerator.h"
 
 @interface ZMEventProcessingStateTests : StateBaseTest
 
@@ -49,25 +51,25 @@
 
 - (NSArray *)syncObjectsUsedByState
 {
-    return  @[ /* Note: these must be in the same order as in the class */
+    return  @[ /* Note: these must be in the order the request scheduler asks them for requests: by priority class, then in the order of the class */
         self.objectDirectory.flowTranscoder,
         self.objectDirectory.callStateTranscoder,
+        self.objectDirectory.typingTranscoder,
+        self.objectDirectory.systemMessageTranscoder,
+        self.objectDirectory.textMessageTranscoder,
+        self.objectDirectory.clientMessageTranscoder,
+        self.objectDirectory.knockTranscoder,
         self.objectDirectory.userProfileUpdateTranscoder,
-        self.objectDirectory.addressBookTranscoder,
         self.objectDirectory.connectionTranscoder,
         self.objectDirectory.userTranscoder,
         self.objectDirectory.selfTranscoder,
         self.objectDirectory.conversationTranscoder,
         self.objectDirectory.pushTokenTranscoder,
-        self.objectDirectory.systemMessageTranscoder,
-        self.objectDirectory.textMessageTranscoder,
-        self.objectDirectory.clientMessageTranscoder,
-        self.objectDirectory.knockTranscoder,
+        self.objectDirectory.removedSuggestedPeopleTranscoder,
+        self.objectDirectory.addressBookTranscoder,
         self.objectDirectory.userImageTranscoder,
         self.objectDirectory.searchUserImageTranscoder,
         self.objectDirectory.assetTranscoder,
-        self.objectDirectory.typingTranscoder,
-        self.objectDirectory.removedSuggestedPeopleTranscoder,
         ];
 }
 
@@ -76,6 +78,11 @@
     XCTAssertEqual(self.sut.updateEventsPolicy, ZMUpdateEventPolicyProcess);
 }
 
+- (void)testThatItIncludesTheRequestsOfTheRequestScheduler
+{
+    XCTAssertTrue(self.sut.includesRequestSchedulerRequests);
+}
+
 - (void)testThatItCallsDidFinishSyncOnEnter
 {
     // expect
@@ -112,11 +119,41 @@
      the order used by the ZMEventProcessingState
      */
     
+    [[(id)self.stateMachine stub] didFinishSync];
     [self checkThatItCallsRequestGeneratorsOnObjectsOfClass:[self syncObjectsUsedByState] creationOfStateBlock:^ZMSyncState *(id<ZMObjectStrategyDirectory> directory) {
-        return [[ZMEventProcessingState alloc] initWithAuthenticationCenter:self.authenticationStatus clientRegistrationStatus:self.clientRegistrationStatus objectStrategyDirectory:directory stateMachineDelegate:self.stateMachine];
+        ZMEventProcessingState *state = [[ZMEventProcessingState alloc] initWithAuthenticationCenter:self.authenticationStatus clientRegistrationStatus:self.clientRegistrationStatus objectStrategyDirectory:directory stateMachineDelegate:self.stateMachine];
+        [[(id)directory stub] processAllEventsInBuffer];
+        [state didEnterState];
+        return state;
     }];
 }
 
+- (void)testThatItAddsItsTranscodersToTheRequestSchedulerOnlyWhileItIsTheCurrentState
+{
+    // given
+    [[(id)self.stateMachine stub] didFinishSync];
+    [[(id)self.objectDirectory stub] processAllEventsInBuffer];
+    ZMTransportRequest *dummyRequest = [ZMTransportRequest requestGetFromPath:@"foo"];
+    id<ZMRequestGenerator> generator = [OCMockObject niceMockForProtocol:@protocol(ZMRequestGenerator)];
+    [[[(id) generator stub] andReturn:dummyRequest] nextRequest];
+    [[[(id)self.objectDirectory.flowTranscoder stub] andReturn:@[generator]] requestGenerators];
+    
+    // then
+    XCTAssertNil([self.objectDirectory.requestScheduler nextRequest]);
+    
+    // when
+    [self.sut didEnterState];
+    
+    // then
+    XCTAssertEqual([self.objectDirectory.requestScheduler nextRequest], dummyRequest);
+    
+    // when
+    [self.sut didLeaveState];
+    
+    // then
+    XCTAssertNil([self.objectDirectory.requestScheduler nextRequest]);
+}
+
 - (void)testThatItFlushesTheUpdateEventsBufferOnEnter
 {
     // expect
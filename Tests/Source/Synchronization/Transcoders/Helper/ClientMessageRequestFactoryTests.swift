@@ -40,6 +40,37 @@ class ClientMessageRequestFactoryTests: MessagingTest {
         XCTAssertEqual(message.encryptedMessagePayloadData(), request?.binaryData)
     }
     
+    func testThatItEncryptsAMessageToALargeGroupConversationForAllClientsOfTheParticipants() {
+        //given
+        let selfClient = createSelfClient()
+        let conversation = ZMConversation.insertNewObjectInManagedObjectContext(syncMOC)
+        conversation.conversationType = .Group
+        conversation.remoteIdentifier = NSUUID.createUUID()
+        var expectedClientIds = Set<UInt64>()
+        for _ in 0..<10 {
+            let user = ZMUser.insertNewObjectInManagedObjectContext(syncMOC)
+            user.remoteIdentifier = NSUUID.createUUID()
+            let client = createClientForUser(user, createSessionWithSelfUser: true)
+            expectedClientIds.insert(client.clientId.client)
+            conversation.addParticipant(user)
+        }
+        let message = conversation.appendOTRMessageWithText(self.name, nonce: NSUUID.createUUID())
+        XCTAssertTrue(syncMOC.saveOrRollback())
+        
+        //when
+        let request = ClientMessageRequestFactory().upstreamRequestForMessage(message, forConversationWithId: conversation.remoteIdentifier!)
+        
+        //then
+        AssertOptionalNotNil(request?.binaryData) { data in
+            let otrMessage = ZMNewOtrMessage.builder().mergeFromData(data).build() as! ZMNewOtrMessage
+            XCTAssertEqual(otrMessage.sender.client, selfClient.clientId.client)
+            let clientIds = (otrMessage.recipients as! [ZMUserEntry]).flatMap { userEntry in
+                return (userEntry.clients as! [ZMClientEntry]).map { $0.client.client }
+            }
+            XCTAssertEqual(Set(clientIds), expectedClientIds)
+        }
+    }
+    
     func assertRequest(request: ZMTransportRequest?, forImageMessage message: ZMAssetClientMessage, conversationId: NSUUID, encrypted: Bool, expectedPath: String, expectedPayload: [String: NSObject]?, format: ZMImageFormat)
     {
         let imageData = message.imageAssetStorage!.imageDataForFormat(format, encrypted: encrypted)!
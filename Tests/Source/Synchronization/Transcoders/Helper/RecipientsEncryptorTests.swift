@@ -0,0 +1,172 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+import XCTest
+@testable import zmessaging
+import ZMProtos
+import ZMCDataModel
+import ZMUtilities
+import Cryptobox
+
+class RecipientsEncryptorTests: MessagingTest {
+    
+    var selfClient: UserClient!
+    var box: CBCryptoBox!
+    
+    override func setUp() {
+        super.setUp()
+        selfClient = createSelfClient()
+        box = selfClient.keysStore.box
+    }
+    
+    override func tearDown() {
+        selfClient = nil
+        box = nil
+        super.tearDown()
+    }
+    
+    // MARK: - Helper
+    
+    func createRecipients(count: Int, clientsPerUser: Int = 1, firstClientNumber: Int = 1) -> [UserClient] {
+        let preKeys = try! box.generatePreKeys(NSMakeRange(0, count))
+        var recipients = [UserClient]()
+        var user: ZMUser!
+        for (index, preKey) in preKeys.enumerate() {
+            if index % clientsPerUser == 0 {
+                user = ZMUser.insertNewObjectInManagedObjectContext(syncMOC)
+                user.remoteIdentifier = NSUUID.createUUID()
+            }
+            let client = UserClient.insertNewObjectInManagedObjectContext(syncMOC)
+            client.remoteIdentifier = String(format: "%llx", UInt64(firstClientNumber + index))
+            client.user = user
+            let session = try! box.sessionWithId(client.remoteIdentifier, fromPreKey: preKey)
+            box.setSessionToRequireSave(session)
+            recipients.append(client)
+        }
+        box.saveSessionsRequiringSave()
+        return recipients
+    }
+    
+    func recipientIdentifiers(message: ZMNewOtrMessage) -> [String] {
+        return (message.recipients as! [ZMUserEntry]).flatMap { userEntry in
+            return (userEntry.clients as! [ZMClientEntry]).map { clientEntry in
+                return "\(userEntry.user.uuid)-\(clientEntry.client.client)"
+            }
+        }
+    }
+    
+    func expectedRecipientIdentifiers(recipients: [UserClient]) -> [String] {
+        let sortedRecipients = recipients.sort { (lhs, rhs) in
+            let lhsUser = lhs.user!.remoteIdentifier!.transportString()
+            let rhsUser = rhs.user!.remoteIdentifier!.transportString()
+            return lhsUser == rhsUser ? lhs.remoteIdentifier < rhs.remoteIdentifier : lhsUser < rhsUser
+        }
+        return sortedRecipients.map { "\($0.user!.remoteIdentifier!.data())-\($0.clientId.client)" }
+    }
+    
+    // MARK: - Tests
+    
+    func testThatItEncryptsForAllRecipientsGroupedByUser() {
+        // given
+        let recipients = createRecipients(6, clientsPerUser: 2)
+        let sut = RecipientsEncryptor(box: box)
+        
+        // when
+        let message = sut.otrMessageWithData(self.name.dataUsingEncoding(NSUTF8StringEncoding)!, sender: selfClient, recipients: recipients.reverse())
+        
+        // then
+        XCTAssertEqual(message.sender.client, selfClient.clientId.client)
+        XCTAssertEqual(message.recipients.count, 3)
+        XCTAssertEqual(recipientIdentifiers(message), expectedRecipientIdentifiers(recipients))
+        for userEntry in message.recipients as! [ZMUserEntry] {
+            XCTAssertEqual(userEntry.clients.count, 2)
+            for clientEntry in userEntry.clients as! [ZMClientEntry] {
+                XCTAssertGreaterThan(clientEntry.text.length, 0)
+            }
+        }
+    }
+    
+    func testThatItCreatesTheSameRecipientsWhenEncryptingInParallelAndSerially() {
+        // given
+        let recipients = createRecipients(40, clientsPerUser: 4)
+        let serialEncryptor = RecipientsEncryptor(box: box, maximumNumberOfWorkers: 1)
+        let parallelEncryptor = RecipientsEncryptor(box: box, maximumNumberOfWorkers: 4, minimumNumberOfRecipientsForParallelEncryption: 1)
+        let data = self.name.dataUsingEncoding(NSUTF8StringEncoding)!
+        
+        // when
+        let serialMessage = serialEncryptor.otrMessageWithData(data, sender: selfClient, recipients: recipients)
+        let parallelMessage = parallelEncryptor.otrMessageWithData(data, sender: selfClient, recipients: recipients)
+        
+        // then
+        XCTAssertEqual(recipientIdentifiers(parallelMessage), recipientIdentifiers(serialMessage))
+        XCTAssertEqual(recipientIdentifiers(parallelMessage), expectedRecipientIdentifiers(recipients))
+    }
+    
+    func testThatItLeavesOutRecipientsWithoutASession() {
+        // given
+        let recipients = createRecipients(2)
+        let clientWithoutSession = UserClient.insertNewObjectInManagedObjectContext(syncMOC)
+        clientWithoutSession.remoteIdentifier = "abcdef"
+        clientWithoutSession.user = recipients.first!.user
+        let sut = RecipientsEncryptor(box: box)
+        
+        // when
+        let message = sut.otrMessageWithData(self.name.dataUsingEncoding(NSUTF8StringEncoding)!, sender: selfClient, recipients: recipients + [clientWithoutSession])
+        
+        // then
+        XCTAssertEqual(recipientIdentifiers(message), expectedRecipientIdentifiers(recipients))
+    }
+    
+    func testThatItEncryptsOnlyOnceForRecipientsThatArePassedSeveralTimes() {
+        // given
+        let recipients = createRecipients(3)
+        let sut = RecipientsEncryptor(box: box)
+        
+        // when
+        let message = sut.otrMessageWithData(self.name.dataUsingEncoding(NSUTF8StringEncoding)!, sender: selfClient, recipients: recipients + recipients)
+        
+        // then
+        XCTAssertEqual(recipientIdentifiers(message), expectedRecipientIdentifiers(recipients))
+    }
+    
+    // MARK: - Performance
+    
+    func measureEncryptingForRecipients(count: Int) {
+        let recipients = createRecipients(count, clientsPerUser: 5)
+        let sut = RecipientsEncryptor(box: box)
+        let data = ZMGenericMessage(text: self.name, nonce: NSUUID.createUUID().transportString()).data()
+        
+        measureBlock {
+            let message = sut.otrMessageWithData(data, sender: self.selfClient, recipients: recipients)
+            XCTAssertEqual(self.recipientIdentifiers(message).count, count)
+        }
+    }
+    
+    func testPerformanceOfEncryptingFor10Recipients() {
+        measureEncryptingForRecipients(10)
+    }
+    
+    func testPerformanceOfEncryptingFor100Recipients() {
+        measureEncryptingForRecipients(100)
+    }
+    
+    func testPerformanceOfEncryptingFor500Recipients() {
+        measureEncryptingForRecipients(500)
+    }
+}
@@ -34,6 +34,58 @@
 @end
 #endif
 
+/// A clock that only moves when it is advanced
+@interface ZMFakeExpirationClock : NSObject <ZMExpirationClock>
+
+@property (nonatomic) NSDate *currentDate;
+@property (nonatomic) NSDate *wakeUpDate;
+@property (nonatomic, copy) dispatch_block_t handler;
+@property (nonatomic) NSUInteger numberOfArmedWakeUps;
+
+- (void)advanceByTimeInterval:(NSTimeInterval)interval;
+
+@end
+
+
+
+@implementation ZMFakeExpirationClock
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self.currentDate = [NSDate date];
+    }
+    return self;
+}
+
+- (void)wakeUpAtDate:(NSDate *)date handler:(dispatch_block_t)handler
+{
+    self.wakeUpDate = date;
+    self.handler = handler;
+    ++self.numberOfArmedWakeUps;
+}
+
+- (void)cancelWakeUp
+{
+    self.wakeUpDate = nil;
+    self.handler = nil;
+}
+
+- (void)advanceByTimeInterval:(NSTimeInterval)interval
+{
+    self.currentDate = [self.currentDate dateByAddingTimeInterval:interval];
+    if (self.wakeUpDate != nil && [self.wakeUpDate compare:self.currentDate] != NSOrderedDescending) {
+        dispatch_block_t handler = self.handler;
+        [self cancelWakeUp];
+        handler();
+    }
+}
+
+@end
+
+
+
 @interface ZMMessageExpirationTimerTests : MessagingTest
 
 @property (nonatomic) ZMMessageExpirationTimer *sut;
@@ -311,3 +363,105 @@
 }
 
 @end
+
+
+
+@implementation ZMMessageExpirationTimerTests (Clock)
+
+- (ZMFakeExpirationClock *)replaceSutWithSutUsingFakeClock
+{
+    [self.sut tearDown];
+    ZMFakeExpirationClock *clock = [[ZMFakeExpirationClock alloc] init];
+    self.sut = [[ZMMessageExpirationTimer alloc] initWithManagedObjectContext:self.uiMOC entityName:[ZMTextMessage entityName] localNotificationDispatcher:self.mockLocalNotificationDispatcher filter:nil clock:clock];
+    return clock;
+}
+
+- (void)testThatItArmsASingleWakeUpForTheEarliestMessage
+{
+    // given
+    ZMFakeExpirationClock *clock = [self replaceSutWithSutUsingFakeClock];
+    ZMTextMessage *message1 = [self setupTextMessageWithExpirationTime:20];
+    ZMTextMessage *message2 = [self setupTextMessageWithExpirationTime:5];
+    ZMTextMessage *message3 = [self setupTextMessageWithExpirationTime:10];
+    
+    // when
+    [self.sut objectsDidChange:[NSSet setWithObjects:message1, message2, message3, nil]];
+    
+    // then
+    XCTAssertEqual(self.sut.runningTimersCount, 3u);
+    XCTAssertEqual(clock.numberOfArmedWakeUps, 1u);
+    XCTAssertEqualObjects(clock.wakeUpDate, message2.expirationDate);
+}
+
+- (void)testThatItExpiresOnlyTheMessagesThatAreDue
+{
+    // given
+    ZMFakeExpirationClock *clock = [self replaceSutWithSutUsingFakeClock];
+    ZMTextMessage *message1 = [self setupTextMessageWithExpirationTime:5];
+    ZMTextMessage *message2 = [self setupTextMessageWithExpirationTime:10];
+    [[self.mockLocalNotificationDispatcher expect] didFailToSentMessage:message1];
+    [[self.mockLocalNotificationDispatcher reject] didFailToSentMessage:message2];
+    [self.sut objectsDidChange:[NSSet setWithObjects:message1, message2, nil]];
+    
+    // when
+    [clock advanceByTimeInterval:7];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertTrue(message1.isExpired);
+    XCTAssertFalse(message2.isExpired);
+    XCTAssertEqual(self.sut.runningTimersCount, 1u);
+    XCTAssertEqualObjects(clock.wakeUpDate, message2.expirationDate);
+    [self.mockLocalNotificationDispatcher verify];
+}
+
+- (void)testThatItExpiresMessagesThatAreDueTogetherInOneBatch
+{
+    // given
+    ZMFakeExpirationClock *clock = [self replaceSutWithSutUsingFakeClock];
+    NSMutableSet *messages = [NSMutableSet set];
+    for (NSUInteger i = 0; i < 50; ++i) {
+        [messages addObject:[self setupTextMessageWithExpirationTime:5 + i * 0.01]];
+    }
+    [[self.mockLocalNotificationDispatcher stub] didFailToSentMessage:OCMOCK_ANY];
+    [self.sut objectsDidChange:messages];
+    XCTAssertEqual(clock.numberOfArmedWakeUps, 1u);
+    
+    // when
+    [clock advanceByTimeInterval:10];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    for (ZMTextMessage *message in messages) {
+        XCTAssertTrue(message.isExpired);
+    }
+    XCTAssertFalse(self.sut.hasMessageTimersRunning);
+    XCTAssertEqual(clock.numberOfArmedWakeUps, 1u);
+    XCTAssertNil(clock.wakeUpDate);
+    XCTAssertFalse(self.uiMOC.hasChanges);
+}
+
+- (void)testThatItArmsTheNextMessageWhenTheTimerForTheEarliestMessageIsStopped
+{
+    // given
+    ZMFakeExpirationClock *clock = [self replaceSutWithSutUsingFakeClock];
+    ZMTextMessage *message1 = [self setupTextMessageWithExpirationTime:5];
+    ZMTextMessage *message2 = [self setupTextMessageWithExpirationTime:10];
+    [self.sut objectsDidChange:[NSSet setWithObjects:message1, message2, nil]];
+    
+    // when
+    [self.sut stopTimerForMessage:message1];
+    
+    // then
+    XCTAssertEqual(self.sut.runningTimersCount, 1u);
+    XCTAssertEqualObjects(clock.wakeUpDate, message2.expirationDate);
+    
+    // when
+    [self.sut stopTimerForMessage:message2];
+    
+    // then
+    XCTAssertFalse(self.sut.hasMessageTimersRunning);
+    XCTAssertNil(clock.wakeUpDate);
+}
+
+@end
@@ -549,3 +549,133 @@
 @end
 
 
+
+
+
+@implementation ZMSimpleListRequestPaginatorTests (AdaptivePageSize)
+
+- (void)prepareForAdaptivePageSizeWithMinimum:(NSUInteger)minimum maximum:(NSUInteger)maximum
+{
+    [[self.singleRequestSync stub] readyForNextRequest];
+    [self.sut resetFetching];
+    [self.sut setMinimumPageSize:minimum maximumPageSize:maximum];
+    self.sut.usesAdaptivePageSize = YES;
+    self.sut.targetPageDuration = 2;
+    self.sut.targetPageByteCount = 1000;
+}
+
+- (void)testThatItUsesTheFixedPageSizeByDefault
+{
+    // given
+    [[self.singleRequestSync stub] readyForNextRequest];
+    [self.sut resetFetching];
+    
+    // when
+    [self.sut didMeasurePageWithLatency:0.01 processingDuration:0.01 payloadByteCount:10];
+    
+    // then
+    XCTAssertFalse(self.sut.usesAdaptivePageSize);
+    XCTAssertEqual(self.sut.pageSize, self.pageSize);
+    XCTAssertEqual(self.sut.minimumPageSize, self.pageSize);
+    XCTAssertEqual(self.sut.maximumPageSize, self.pageSize);
+}
+
+- (void)testThatItIncreasesThePageSizeForFastPages
+{
+    // given
+    [self prepareForAdaptivePageSizeWithMinimum:10 maximum:100];
+    
+    // when
+    [self.sut didMeasurePageWithLatency:0.1 processingDuration:0.1 payloadByteCount:100];
+    
+    // then
+    XCTAssertEqual(self.sut.pageSize, 2 * self.pageSize);
+}
+
+- (void)testThatItDoesNotIncreaseThePageSizeAboveTheMaximum
+{
+    // given
+    [self prepareForAdaptivePageSizeWithMinimum:10 maximum:30];
+    
+    // when
+    [self.sut didMeasurePageWithLatency:0.1 processingDuration:0.1 payloadByteCount:100];
+    
+    // then
+    XCTAssertEqual(self.sut.pageSize, 30u);
+}
+
+- (void)testThatItDecreasesThePageSizeForSlowPages
+{
+    // given
+    [self prepareForAdaptivePageSizeWithMinimum:5 maximum:100];
+    
+    // when
+    [self.sut didMeasurePageWithLatency:0.1 processingDuration:4 payloadByteCount:100];
+    
+    // then
+    XCTAssertEqual(self.sut.pageSize, self.pageSize / 2);
+}
+
+- (void)testThatItDoesNotDecreaseThePageSizeForAHighLatency
+{
+    // given
+    [self prepareForAdaptivePageSizeWithMinimum:5 maximum:100];
+    
+    // when
+    [self.sut didMeasurePageWithLatency:10 processingDuration:0.1 payloadByteCount:100];
+    
+    // then
+    XCTAssertEqual(self.sut.pageSize, 2 * self.pageSize);
+}
+
+- (void)testThatItDecreasesThePageSizeForLargePayloads
+{
+    // given
+    [self prepareForAdaptivePageSizeWithMinimum:5 maximum:100];
+    
+    // when
+    [self.sut didMeasurePageWithLatency:0.1 processingDuration:0.1 payloadByteCount:1250];
+    
+    // then
+    XCTAssertEqual(self.sut.pageSize, 16u);
+}
+
+- (void)testThatItHalvesThePageSizeAfterAFailureButNotBelowTheMinimum
+{
+    // given
+    [self prepareForAdaptivePageSizeWithMinimum:8 maximum:100];
+    
+    // when
+    [self.sut didFailToFetchPage];
+    
+    // then
+    XCTAssertEqual(self.sut.pageSize, 10u);
+    
+    // when
+    [self.sut didFailToFetchPage];
+    
+    // then
+    XCTAssertEqual(self.sut.pageSize, 8u);
+}
+
+- (void)testThatItKeepsStatisticsOfTheRecentPages
+{
+    // given
+    [[self.singleRequestSync stub] readyForNextRequest];
+    [self.sut resetFetching];
+    
+    // when
+    for (NSUInteger i = 0; i < 12; i++) {
+        [self.sut didMeasurePageWithLatency:i processingDuration:0.5 payloadByteCount:i * 100];
+    }
+    
+    // then
+    XCTAssertEqual(self.sut.recentPageStatistics.count, 10u);
+    ZMSimpleListRequestPaginatorPageStatistics *statistics = self.sut.recentPageStatistics.lastObject;
+    XCTAssertEqual(statistics.pageSize, self.pageSize);
+    XCTAssertEqual(statistics.latency, 11);
+    XCTAssertEqual(statistics.processingDuration, 0.5);
+    XCTAssertEqual(statistics.payloadByteCount, 1100u);
+}
+
+@end
@@ -23,6 +23,27 @@
 #import "ZMAddressBookEncoder.h"
 #import "ZMSingleRequestSync.h"
 #import "ZMAddressBook.h"
+#import <CommonCrypto/CommonDigest.h>
+
+
+
+/// Keeps the cards of the address book the way the backend would, and applies both full and delta uploads to them
+@interface ZMMockOnboardingEndpoint : NSObject
+
+/// The contact hashes of each card, keyed by the card's digest
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, NSArray<NSString *> *> *cards;
+@property (nonatomic) NSUInteger numberOfFullUploads;
+@property (nonatomic) NSUInteger numberOfDeltaUploads;
+@property (nonatomic) NSUInteger maximumNumberOfCardsInDeltaUpload;
+/// When set, delta uploads fail the way they do on a backend without the delta endpoint
+@property (nonatomic) BOOL rejectsDeltaUploads;
+/// The remote identifiers the next successful upload returns as matches
+@property (nonatomic, copy) NSArray<NSString *> *results;
+
++ (NSString *)digestOfContactHashes:(NSArray<NSString *> *)contactHashes;
+- (ZMTransportResponse *)responseForRequest:(ZMTransportRequest *)request;
+
+@end
 
 @interface ZMAddressBookSyncTests : ObjectTranscoderTests
 {
@@ -33,6 +54,7 @@
 @property (nonatomic) id addressBookUpload;
 @property (nonatomic) id addressBookMock;
 @property (nonatomic) NSArray *contacts;
+@property (nonatomic) NSURL *manifestURL;
 
 @end
 
@@ -42,6 +64,8 @@
 
 - (void)clearAddressBookAsNeedingToBeUploaded;
 
+@property (nonatomic, copy) NSArray<NSString *> *uploadedCardDigests;
+
 @end
 
 
@@ -69,7 +93,8 @@
     ZMUser *selfUser = [ZMUser selfUserInContext:self.uiMOC];
     selfUser.emailAddress = @"doe@example.com";
     
-    self.sut = (id) [[ZMAddressBookSync alloc] initWithManagedObjectContext:self.uiMOC addressBook:self.addressBookMock addressBookUpload:self.addressBookUpload];
+    self.manifestURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:NSUUID.createUUID.transportString];
+    self.sut = (id) [[ZMAddressBookSync alloc] initWithManagedObjectContext:self.uiMOC addressBook:self.addressBookMock addressBookUpload:self.addressBookUpload manifestURL:self.manifestURL];
 }
 
 - (void)tearDown
@@ -81,6 +106,8 @@
     WaitForAllGroupsToBeEmpty(0.5);
     [self.addressBookMock stopMocking];
     self.addressBookMock = nil;
+    [[NSFileManager defaultManager] removeItemAtURL:self.manifestURL error:NULL];
+    self.manifestURL = nil;
     
     [super tearDown];
 }
@@ -99,7 +126,7 @@
     contactC.phoneNumbers = @[];
     
     self.contacts = @[contactA, contactB, contactC];
-    [(ZMAddressBook *)[[self.addressBookMock stub] andReturn:self.contacts] contacts];
+    [(ZMAddressBook *)[[self.addressBookMock stub] andCall:@selector(contacts) onObject:self] contacts];
 }
 
 - (void)testThatItReturnsNilRequestWhenAddressBookDoesNotNeedToBeUploaded;
@@ -120,7 +147,7 @@
 {
     // given
     [self.sut tearDown];
-    self.sut = (id) [[ZMAddressBookSync alloc] initWithManagedObjectContext:self.uiMOC addressBook:self.addressBookMock addressBookUpload:nil];
+    self.sut = (id) [[ZMAddressBookSync alloc] initWithManagedObjectContext:self.uiMOC addressBook:self.addressBookMock addressBookUpload:nil manifestURL:self.manifestURL];
     [ZMAddressBookSync markAddressBookAsNeedingToBeUploadedInContext:self.uiMOC];
     NSError *error;
     XCTAssert([self.uiMOC save:&error], @"%@", error);
@@ -250,3 +277,393 @@
 }
 
 @end
+
+
+
+@implementation ZMAddressBookSyncTests (DeltaUpload)
+
+- (void)recreateSUTWithSingleRequestSync;
+{
+    [self.sut tearDown];
+    self.sut = (id) [[ZMAddressBookSync alloc] initWithManagedObjectContext:self.uiMOC addressBook:self.addressBookMock addressBookUpload:nil manifestURL:self.manifestURL];
+}
+
+- (ZMAddressBookContact *)contactWithIndex:(NSUInteger)index;
+{
+    ZMAddressBookContact *contact = [[ZMAddressBookContact alloc] init];
+    contact.emailAddresses = @[[NSString stringWithFormat:@"user%lu@example.com", (unsigned long) index]];
+    contact.phoneNumbers = @[[NSString stringWithFormat:@"+49151%08lu", (unsigned long) index]];
+    return contact;
+}
+
+- (NSArray *)contactsWithIndexesInRange:(NSRange)range;
+{
+    NSMutableArray *contacts = [NSMutableArray array];
+    for (NSUInteger i = range.location; i < NSMaxRange(range); ++i) {
+        [contacts addObject:[self contactWithIndex:i]];
+    }
+    return contacts;
+}
+
+/// Marks the address book as needing to be uploaded and sends requests to the endpoint until it no longer needs to be
+- (NSArray<ZMTransportRequest *> *)uploadAddressBookToEndpoint:(ZMMockOnboardingEndpoint *)endpoint;
+{
+    [ZMAddressBookSync markAddressBookAsNeedingToBeUploadedInContext:self.uiMOC];
+    NSMutableArray *requests = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 100 && self.sut.addressBookNeedsToBeUploaded; ++i) {
+        ZMTransportRequest *request = [self.sut nextRequest];
+        WaitForAllGroupsToBeEmpty(0.5);
+        if (request != nil) {
+            [requests addObject:request];
+            [request completeWithResponse:[endpoint responseForRequest:request]];
+            WaitForAllGroupsToBeEmpty(0.5);
+        }
+    }
+    XCTAssertFalse(self.sut.addressBookNeedsToBeUploaded);
+    return requests;
+}
+
+/// The contact hashes of each card when encoding the whole address book
+- (NSSet *)cardsOfFullEncoding;
+{
+    ZMAddressBookEncoder *encoder = [[ZMAddressBookEncoder alloc] initWithManagedObjectContext:self.uiMOC addressBook:self.addressBookMock];
+    __block NSSet *cards;
+    [encoder createPayloadWithCompletionHandler:^(ZMEncodedAddressBook *encoded) {
+        cards = [NSSet setWithArray:[(NSArray *) encoded.otherData mapWithBlock:^id(NSDictionary *card) {
+            return card[@"contact"];
+        }]];
+    }];
+    WaitForAllGroupsToBeEmpty(0.5);
+    return cards;
+}
+
+- (void)testThatItUploadsTheWholeAddressBookInTheExistingFormatWhenDeltaUploadsAreOff;
+{
+    // given
+    [self recreateSUTWithSingleRequestSync];
+    XCTAssertFalse(self.sut.usesDeltaUploads);
+    ZMMockOnboardingEndpoint *endpoint = [[ZMMockOnboardingEndpoint alloc] init];
+    [self uploadAddressBookToEndpoint:endpoint];
+    self.contacts = [self.contacts arrayByAddingObjectsFromArray:@[[self contactWithIndex:1], [self contactWithIndex:1]]];
+    
+    // when
+    NSArray *requests = [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertEqual(requests.count, 1u);
+    NSDictionary *payload = [[requests.firstObject payload] asDictionary];
+    XCTAssertEqualObjects([NSSet setWithArray:payload.allKeys], ([NSSet setWithObjects:@"self", @"cards", nil]));
+    NSArray *cards = [payload arrayForKey:@"cards"];
+    XCTAssertEqual(cards.count, 4u, @"Duplicate cards should be uploaded as they are");
+    [cards enumerateObjectsUsingBlock:^(NSDictionary *card, NSUInteger idx, BOOL *stop) {
+        NOT_USED(stop);
+        XCTAssertEqualObjects(card[@"card_id"], [NSString stringWithFormat:@"%lu", (unsigned long) idx]);
+    }];
+    XCTAssertEqual(endpoint.numberOfFullUploads, 2u);
+    XCTAssertEqual(endpoint.numberOfDeltaUploads, 0u);
+    XCTAssertNil(self.sut.uploadedCardDigests);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:self.manifestURL.path]);
+}
+
+- (void)testThatTheFirstUploadContainsTheWholeAddressBook;
+{
+    // given
+    [self recreateSUTWithSingleRequestSync];
+    self.sut.usesDeltaUploads = YES;
+    ZMMockOnboardingEndpoint *endpoint = [[ZMMockOnboardingEndpoint alloc] init];
+    XCTAssertNil(self.sut.uploadedCardDigests);
+    
+    // when
+    NSArray *requests = [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertEqual(requests.count, 1u);
+    XCTAssertNotNil([[[requests.firstObject payload] asDictionary] arrayForKey:@"cards"]);
+    XCTAssertEqual(endpoint.numberOfFullUploads, 1u);
+    XCTAssertEqual(endpoint.numberOfDeltaUploads, 0u);
+    XCTAssertEqualObjects([NSSet setWithArray:endpoint.cards.allValues], self.cardsOfFullEncoding);
+    XCTAssertEqualObjects([NSSet setWithArray:self.sut.uploadedCardDigests], [NSSet setWithArray:endpoint.cards.allKeys]);
+}
+
+- (void)testThatItStoresTheManifestInAFileAndNotInTheStoreMetadata;
+{
+    // given
+    [self recreateSUTWithSingleRequestSync];
+    self.sut.usesDeltaUploads = YES;
+    ZMMockOnboardingEndpoint *endpoint = [[ZMMockOnboardingEndpoint alloc] init];
+    NSDictionary *metadataBeforeUpload = [self.uiMOC.persistentStoreCoordinator metadataForPersistentStore:self.uiMOC.persistentStoreCoordinator.persistentStores.firstObject];
+    
+    // when
+    [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:self.manifestURL.path]);
+    NSDictionary *metadata = [self.uiMOC.persistentStoreCoordinator metadataForPersistentStore:self.uiMOC.persistentStoreCoordinator.persistentStores.firstObject];
+    NSMutableSet *addedKeys = [NSMutableSet setWithArray:metadata.allKeys];
+    [addedKeys minusSet:[NSSet setWithArray:metadataBeforeUpload.allKeys]];
+    for (NSString *key in addedKeys) {
+        XCTAssertFalse([metadata[key] isKindOfClass:NSArray.class], @"%@", key);
+    }
+    
+    // and when
+    [self recreateSUTWithSingleRequestSync];
+    
+    // then
+    XCTAssertEqualObjects([NSSet setWithArray:self.sut.uploadedCardDigests], [NSSet setWithArray:endpoint.cards.allKeys]);
+}
+
+- (void)testThatADeltaUploadAddsItsMatchesToTheSuggestedContacts;
+{
+    // given
+    [self recreateSUTWithSingleRequestSync];
+    self.sut.usesDeltaUploads = YES;
+    ZMMockOnboardingEndpoint *endpoint = [[ZMMockOnboardingEndpoint alloc] init];
+    NSUUID *matchOfFullUpload = NSUUID.createUUID;
+    endpoint.results = @[matchOfFullUpload.UUIDString];
+    [self uploadAddressBookToEndpoint:endpoint];
+    XCTAssertEqualObjects(self.uiMOC.suggestedUsersForUser.array, @[matchOfFullUpload]);
+    
+    self.contacts = [self.contacts arrayByAddingObject:[self contactWithIndex:1]];
+    NSUUID *matchOfDeltaUpload = NSUUID.createUUID;
+    endpoint.results = @[matchOfDeltaUpload.UUIDString];
+    
+    // when
+    NSArray *requests = [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertEqual(requests.count, 1u);
+    XCTAssertEqual(endpoint.numberOfDeltaUploads, 1u);
+    NSArray *expected = @[matchOfFullUpload, matchOfDeltaUpload];
+    XCTAssertEqualObjects(self.uiMOC.suggestedUsersForUser.array, expected);
+}
+
+- (void)testThatItOnlyUploadsTheAddedCards;
+{
+    // given
+    [self recreateSUTWithSingleRequestSync];
+    self.sut.usesDeltaUploads = YES;
+    ZMMockOnboardingEndpoint *endpoint = [[ZMMockOnboardingEndpoint alloc] init];
+    [self uploadAddressBookToEndpoint:endpoint];
+    
+    self.contacts = [self.contacts arrayByAddingObjectsFromArray:@[[self contactWithIndex:1], [self contactWithIndex:2], [self contactWithIndex:2]]];
+    
+    // when
+    NSArray *requests = [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertEqual(requests.count, 1u);
+    NSDictionary *payload = [[requests.firstObject payload] asDictionary];
+    XCTAssertEqualObjects([NSSet setWithArray:payload.allKeys], ([NSSet setWithObjects:@"self", @"cards_added", nil]));
+    XCTAssertEqual([payload arrayForKey:@"cards_added"].count, 2u);
+    XCTAssertEqual([payload arrayForKey:@"self"].count, 1u);
+    XCTAssertEqual(endpoint.numberOfDeltaUploads, 1u);
+    XCTAssertEqualObjects([NSSet setWithArray:endpoint.cards.allValues], self.cardsOfFullEncoding);
+    XCTAssertEqualObjects([NSSet setWithArray:self.sut.uploadedCardDigests], [NSSet setWithArray:endpoint.cards.allKeys]);
+}
+
+- (void)testThatItUploadsTheWholeAddressBookWhenCardsWereRemoved;
+{
+    // given
+    [self recreateSUTWithSingleRequestSync];
+    self.sut.usesDeltaUploads = YES;
+    ZMMockOnboardingEndpoint *endpoint = [[ZMMockOnboardingEndpoint alloc] init];
+    endpoint.results = @[NSUUID.createUUID.transportString];
+    [self uploadAddressBookToEndpoint:endpoint];
+    
+    ZMAddressBookContact *changedContact = [[ZMAddressBookContact alloc] init];
+    changedContact.emailAddresses = @[@"john@example.com"];
+    changedContact.phoneNumbers = @[@"+123456789012"];
+    self.contacts = @[self.contacts[0], changedContact, self.contacts[2]];
+    NSUUID *match = NSUUID.createUUID;
+    endpoint.results = @[match.transportString];
+    
+    // when
+    NSArray *requests = [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertEqual(requests.count, 1u);
+    XCTAssertNotNil([[[requests.firstObject payload] asDictionary] arrayForKey:@"cards"]);
+    XCTAssertEqual(endpoint.numberOfFullUploads, 2u);
+    XCTAssertEqual(endpoint.numberOfDeltaUploads, 0u);
+    XCTAssertEqualObjects(self.uiMOC.suggestedUsersForUser.array, @[match], @"Matches of removed cards should be dropped");
+    XCTAssertEqualObjects([NSSet setWithArray:self.sut.uploadedCardDigests], [NSSet setWithArray:endpoint.cards.allKeys]);
+}
+
+- (void)testThatItSplitsLargeDeltasIntoBoundedUploads;
+{
+    // given
+    [self recreateSUTWithSingleRequestSync];
+    self.sut.usesDeltaUploads = YES;
+    ZMMockOnboardingEndpoint *endpoint = [[ZMMockOnboardingEndpoint alloc] init];
+    self.contacts = [self contactsWithIndexesInRange:NSMakeRange(0, 400)];
+    [self uploadAddressBookToEndpoint:endpoint];
+    
+    self.contacts = [self contactsWithIndexesInRange:NSMakeRange(0, 1600)];
+    
+    // when
+    NSArray *requests = [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertEqual(requests.count, 3u);
+    XCTAssertEqual(endpoint.numberOfDeltaUploads, 3u);
+    XCTAssertLessThanOrEqual(endpoint.maximumNumberOfCardsInDeltaUpload, 500u);
+    XCTAssertEqual(endpoint.cards.count, 1600u);
+    XCTAssertEqualObjects([NSSet setWithArray:endpoint.cards.allValues], self.cardsOfFullEncoding);
+    XCTAssertEqualObjects([NSSet setWithArray:self.sut.uploadedCardDigests], [NSSet setWithArray:endpoint.cards.allKeys]);
+}
+
+- (void)testThatItUploadsTheWholeAddressBookWhenTheManifestIsMissing;
+{
+    // given
+    [self recreateSUTWithSingleRequestSync];
+    self.sut.usesDeltaUploads = YES;
+    ZMMockOnboardingEndpoint *endpoint = [[ZMMockOnboardingEndpoint alloc] init];
+    [self uploadAddressBookToEndpoint:endpoint];
+    
+    self.contacts = [self.contacts arrayByAddingObject:[self contactWithIndex:1]];
+    [[NSFileManager defaultManager] removeItemAtURL:self.manifestURL error:NULL];
+    
+    // when
+    NSArray *requests = [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertEqual(requests.count, 1u);
+    XCTAssertEqual([[[requests.firstObject payload] asDictionary] arrayForKey:@"cards"].count, 3u);
+    XCTAssertEqual(endpoint.numberOfFullUploads, 2u);
+    XCTAssertEqual(endpoint.numberOfDeltaUploads, 0u);
+    XCTAssertEqualObjects([NSSet setWithArray:endpoint.cards.allValues], self.cardsOfFullEncoding);
+}
+
+- (void)testThatItKeepsTheManifestWhenADeltaUploadExpires;
+{
+    // given
+    [self recreateSUTWithSingleRequestSync];
+    self.sut.usesDeltaUploads = YES;
+    ZMMockOnboardingEndpoint *endpoint = [[ZMMockOnboardingEndpoint alloc] init];
+    [self uploadAddressBookToEndpoint:endpoint];
+    NSArray *uploadedCardDigests = self.sut.uploadedCardDigests;
+    
+    self.contacts = [self.contacts arrayByAddingObject:[self contactWithIndex:1]];
+    [ZMAddressBookSync markAddressBookAsNeedingToBeUploadedInContext:self.uiMOC];
+    XCTAssertNil([self.sut nextRequest]);
+    WaitForAllGroupsToBeEmpty(0.5);
+    ZMTransportRequest *request = [self.sut nextRequest];
+    XCTAssertNotNil([[request.payload asDictionary] arrayForKey:@"cards_added"]);
+    
+    // when
+    [request completeWithResponse:[ZMTransportResponse responseWithPayload:nil HTTPstatus:0 transportSessionError:[NSError errorWithDomain:ZMTransportSessionErrorDomain code:ZMTransportSessionErrorCodeRequestExpired userInfo:nil]]];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertFalse(self.sut.addressBookNeedsToBeUploaded);
+    XCTAssertEqualObjects(self.sut.uploadedCardDigests, uploadedCardDigests);
+    
+    // and when
+    NSArray *requests = [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertEqual(requests.count, 1u, @"The same address book should be uploaded again");
+    XCTAssertEqual([[[requests.firstObject payload] asDictionary] arrayForKey:@"cards_added"].count, 1u);
+    XCTAssertEqual(endpoint.numberOfFullUploads, 1u);
+    XCTAssertEqualObjects([NSSet setWithArray:endpoint.cards.allValues], self.cardsOfFullEncoding);
+}
+
+- (void)testThatItUploadsTheWholeAddressBookOnceWhenADeltaIsRejected;
+{
+    // given
+    [self recreateSUTWithSingleRequestSync];
+    self.sut.usesDeltaUploads = YES;
+    ZMMockOnboardingEndpoint *endpoint = [[ZMMockOnboardingEndpoint alloc] init];
+    endpoint.rejectsDeltaUploads = YES;
+    [self uploadAddressBookToEndpoint:endpoint];
+    self.contacts = [self.contacts arrayByAddingObject:[self contactWithIndex:1]];
+    
+    // when
+    NSArray *requests = [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertEqual(requests.count, 2u);
+    XCTAssertNotNil([[[requests.firstObject payload] asDictionary] arrayForKey:@"cards_added"]);
+    XCTAssertNotNil([[[requests.lastObject payload] asDictionary] arrayForKey:@"cards"]);
+    XCTAssertEqual(endpoint.numberOfFullUploads, 2u);
+    XCTAssertEqualObjects([NSSet setWithArray:endpoint.cards.allValues], self.cardsOfFullEncoding);
+    
+    // and when
+    self.contacts = [self.contacts arrayByAddingObject:[self contactWithIndex:2]];
+    requests = [self uploadAddressBookToEndpoint:endpoint];
+    
+    // then
+    XCTAssertEqual(requests.count, 1u, @"No more delta uploads should be sent");
+    XCTAssertNotNil([[[requests.firstObject payload] asDictionary] arrayForKey:@"cards"]);
+    XCTAssertEqual(endpoint.numberOfDeltaUploads, 1u);
+}
+
+@end
+
+
+
+@implementation ZMMockOnboardingEndpoint
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _cards = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
++ (NSString *)digestOfContactHashes:(NSArray<NSString *> *)contactHashes;
+{
+    NSData *input = [[contactHashes componentsJoinedByString:@""] dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *digest = [NSMutableData dataWithLength:CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(input.bytes, (CC_LONG) input.length, (unsigned char *) digest.mutableBytes);
+    return [digest base64EncodedStringWithOptions:0];
+}
+
+/// Added cards have to be identified by the digest of their contact hashes, so that the manifest can refer to them
++ (BOOL)cardsHaveValidIdentifiers:(NSArray<NSDictionary *> *)cards;
+{
+    for (NSDictionary *card in cards) {
+        NSArray *contactHashes = [card arrayForKey:@"contact"];
+        if (! [[card stringForKey:@"card_id"] isEqualToString:[self.class digestOfContactHashes:contactHashes]]) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (ZMTransportResponse *)responseForRequest:(ZMTransportRequest *)request;
+{
+    NSDictionary *payload = [request.payload asDictionary];
+    if (request.method != ZMMethodPOST || ! [request.path isEqualToString:@"/onboarding/v2"] || payload == nil) {
+        return [ZMTransportResponse responseWithPayload:nil HTTPstatus:404 transportSessionError:nil];
+    }
+    
+    NSArray *fullCards = [payload optionalArrayForKey:@"cards"];
+    if (fullCards != nil) {
+        // Cards of whole uploads are identified by their index
+        ++self.numberOfFullUploads;
+        [self.cards removeAllObjects];
+        for (NSDictionary *card in fullCards) {
+            self.cards[[self.class digestOfContactHashes:card[@"contact"]]] = card[@"contact"];
+        }
+    }
+    else {
+        ++self.numberOfDeltaUploads;
+        if (self.rejectsDeltaUploads) {
+            return [ZMTransportResponse responseWithPayload:@{@"label": @"bad-request"} HTTPstatus:400 transportSessionError:nil];
+        }
+        NSArray *addedCards = [payload arrayForKey:@"cards_added"];
+        self.maximumNumberOfCardsInDeltaUpload = MAX(self.maximumNumberOfCardsInDeltaUpload, addedCards.count);
+        if (! [self.class cardsHaveValidIdentifiers:addedCards]) {
+            return [ZMTransportResponse responseWithPayload:@{@"label": @"invalid-card"} HTTPstatus:400 transportSessionError:nil];
+        }
+        for (NSDictionary *card in addedCards) {
+            self.cards[card[@"card_id"]] = card[@"contact"];
+        }
+    }
+    return [ZMTransportResponse responseWithPayload:@{@"results": self.results ?: @[]} HTTPstatus:200 transportSessionError:nil];
+}
+
+@end
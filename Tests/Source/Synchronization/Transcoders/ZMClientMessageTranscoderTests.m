@@ -232,6 +232,145 @@
     XCTAssertEqual(dependency, nextMessage);
 }
 
+- (void)testThatItDoesNotReturnAPreviousTextMessageAsDependencyOnceItIsDelivered
+{
+    //given
+    [self createSelfClient];
+    NSDate *zeroTime = [NSDate dateWithTimeIntervalSince1970:1000];
+    ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+    conversation.remoteIdentifier = [NSUUID createUUID];
+    
+    ZMTextMessage *message = [conversation appendMessageWithText:@"message a1"];
+    message.nonce = [NSUUID createUUID];
+    message.serverTimestamp = zeroTime;
+    
+    ZMGenericMessage *genericMessage = [ZMGenericMessage messageWithText:@"message a2" nonce:[NSUUID createUUID].transportString];
+    ZMClientMessage *lastMessage = [conversation appendClientMessageWithData:genericMessage.data];
+    lastMessage.serverTimestamp = [NSDate dateWithTimeInterval:10 sinceDate:zeroTime];
+    XCTAssertTrue([self.syncMOC saveOrRollback]);
+    XCTAssertEqual([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:lastMessage], message);
+    
+    // when
+    message.eventID = [self createEventID];
+    
+    // then
+    XCTAssertNil([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:lastMessage]);
+}
+
+- (void)testThatItDoesNotReturnAPreviousTextMessageAsDependencyOnceItIsExpired
+{
+    //given
+    [self createSelfClient];
+    NSDate *zeroTime = [NSDate dateWithTimeIntervalSince1970:1000];
+    ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+    conversation.remoteIdentifier = [NSUUID createUUID];
+    
+    ZMTextMessage *message = [conversation appendMessageWithText:@"message a1"];
+    message.nonce = [NSUUID createUUID];
+    message.serverTimestamp = zeroTime;
+    
+    ZMGenericMessage *genericMessage = [ZMGenericMessage messageWithText:@"message a2" nonce:[NSUUID createUUID].transportString];
+    ZMClientMessage *lastMessage = [conversation appendClientMessageWithData:genericMessage.data];
+    lastMessage.serverTimestamp = [NSDate dateWithTimeInterval:10 sinceDate:zeroTime];
+    XCTAssertTrue([self.syncMOC saveOrRollback]);
+    XCTAssertEqual([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:lastMessage], message);
+    
+    // when
+    [message expire];
+    
+    // then
+    XCTAssertNil([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:lastMessage]);
+}
+
+- (void)testThatItReturnsAPendingMessageAppendedAfterThePreviousLookupAsDependency
+{
+    //given
+    [self createSelfClient];
+    NSDate *zeroTime = [NSDate dateWithTimeIntervalSince1970:1000];
+    ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+    conversation.remoteIdentifier = [NSUUID createUUID];
+    
+    ZMTextMessage *firstMessage = [conversation appendMessageWithText:@"message a1"];
+    firstMessage.nonce = [NSUUID createUUID];
+    firstMessage.serverTimestamp = zeroTime;
+    firstMessage.eventID = [self createEventID];
+    XCTAssertTrue([self.syncMOC saveOrRollback]);
+    XCTAssertNil([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:firstMessage]);
+    
+    // when
+    ZMTextMessage *nextMessage = [conversation appendMessageWithText:@"message a2"];
+    nextMessage.nonce = [NSUUID createUUID];
+    nextMessage.serverTimestamp = [NSDate dateWithTimeInterval:10 sinceDate:zeroTime];
+    
+    ZMGenericMessage *genericMessage = [ZMGenericMessage messageWithText:@"message a3" nonce:[NSUUID createUUID].transportString];
+    ZMClientMessage *lastMessage = [conversation appendClientMessageWithData:genericMessage.data];
+    lastMessage.serverTimestamp = [NSDate dateWithTimeInterval:10 sinceDate:nextMessage.serverTimestamp];
+    XCTAssertTrue([self.syncMOC saveOrRollback]);
+    
+    // then
+    XCTAssertEqual([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:lastMessage], nextMessage);
+    XCTAssertNil([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:nextMessage]);
+}
+
+- (void)testThatItReturnsAnOlderPendingMessageAsDependencyAfterALookupForALaterMessage
+{
+    //given
+    [self createSelfClient];
+    NSDate *zeroTime = [NSDate dateWithTimeIntervalSince1970:1000];
+    ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+    conversation.remoteIdentifier = [NSUUID createUUID];
+    
+    ZMTextMessage *messageA = [conversation appendMessageWithText:@"message a"];
+    messageA.nonce = [NSUUID createUUID];
+    messageA.serverTimestamp = zeroTime;
+    
+    ZMTextMessage *messageB = [conversation appendMessageWithText:@"message b"];
+    messageB.nonce = [NSUUID createUUID];
+    messageB.serverTimestamp = [NSDate dateWithTimeInterval:2 * 60 sinceDate:zeroTime];
+    
+    ZMTextMessage *messageC = [conversation appendMessageWithText:@"message c"];
+    messageC.nonce = [NSUUID createUUID];
+    messageC.serverTimestamp = [NSDate dateWithTimeInterval:4 * 60 sinceDate:zeroTime];
+    XCTAssertTrue([self.syncMOC saveOrRollback]);
+    
+    // when
+    XCTAssertEqual([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:messageC], messageB);
+    
+    // then
+    XCTAssertEqual([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:messageB], messageA);
+}
+
+- (void)testThatItReturnsAPendingMessageThatWasSortedBeforeThePreviousLookupAsDependency
+{
+    //given
+    [self createSelfClient];
+    NSDate *zeroTime = [NSDate dateWithTimeIntervalSince1970:1000];
+    ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+    conversation.remoteIdentifier = [NSUUID createUUID];
+    
+    ZMTextMessage *firstMessage = [conversation appendMessageWithText:@"message a1"];
+    firstMessage.nonce = [NSUUID createUUID];
+    firstMessage.serverTimestamp = zeroTime;
+    firstMessage.eventID = [self createEventID];
+    
+    ZMTextMessage *lastMessage = [conversation appendMessageWithText:@"message a3"];
+    lastMessage.nonce = [NSUUID createUUID];
+    lastMessage.serverTimestamp = [NSDate dateWithTimeInterval:20 sinceDate:zeroTime];
+    XCTAssertTrue([self.syncMOC saveOrRollback]);
+    XCTAssertNil([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:lastMessage]);
+    
+    // when
+    ZMTextMessage *insertedMessage = [conversation appendMessageWithText:@"message a2"];
+    insertedMessage.nonce = [NSUUID createUUID];
+    insertedMessage.serverTimestamp = [NSDate dateWithTimeInterval:10 sinceDate:zeroTime];
+    [conversation sortMessages];
+    XCTAssertTrue([self.syncMOC saveOrRollback]);
+    XCTAssertEqual([conversation.messages indexOfObject:insertedMessage], 1u);
+    
+    // then
+    XCTAssertEqual([self.sut dependentObjectNeedingUpdateBeforeProcessingObject:lastMessage], insertedMessage);
+}
+
 - (void)testThatItGeneratesARequestToSendAClientMessage
 {
     // given
@@ -68,6 +68,15 @@ static NSString * const LastUpdateEventIDStoreKey = @"LastUpdateEventID";
     [sut tearDown];
 }
 
+- (void)testThatTheListPaginatorAdaptsItsPageSize
+{
+    // then
+    XCTAssertTrue(self.sut.listPaginator.usesAdaptivePageSize);
+    XCTAssertEqual(self.sut.listPaginator.pageSize, ZMMissingUpdateEventsTranscoderListPageSize);
+    XCTAssertEqual(self.sut.listPaginator.minimumPageSize, ZMMissingUpdateEventsTranscoderMinimumListPageSize);
+    XCTAssertEqual(self.sut.listPaginator.maximumPageSize, ZMMissingUpdateEventsTranscoderMaximumListPageSize);
+}
+
 - (void)testThatItOnlyProcessesMissingUpdateEvents;
 {
     // when
@@ -223,7 +232,7 @@ static NSString * const LastUpdateEventIDStoreKey = @"LastUpdateEventID";
     NSArray *callStateEvents = [ZMUpdateEvent eventsArrayFromPushChannelData:callStatePayload];
 
     // expect
-    [[(id)self.syncStrategy expect] processUpdateEvents:expectedEvents ignoreBuffer:YES];
+    [[(id)self.syncStrategy expect] processDownloadedNotificationStreamEvents:expectedEvents];
     [[(id)self.syncStrategy expect] processUpdateEvents:callStateEvents ignoreBuffer:NO];
     
     // when
@@ -276,7 +285,7 @@ static NSString * const LastUpdateEventIDStoreKey = @"LastUpdateEventID";
     NSArray *callStateEvents = [ZMUpdateEvent eventsArrayFromPushChannelData:callStatePayload];
     
     // expect
-    [[(id)self.syncStrategy expect] processUpdateEvents:expectedEvents ignoreBuffer:YES];
+    [[(id)self.syncStrategy expect] processDownloadedNotificationStreamEvents:expectedEvents];
     
     //in second pass we process call state events with buffer
     [[(id)self.syncStrategy expect] processUpdateEvents:callStateEvents ignoreBuffer:NO];
@@ -460,6 +469,35 @@ static NSString * const LastUpdateEventIDStoreKey = @"LastUpdateEventID";
     XCTAssertTrue([components.queryItems containsObject:[NSURLQueryItem queryItemWithName:@"since" value:lastUpdateEventID.transportString]], @"missing valid since parameter");
 }
 
+- (void)testThatItPassesLargePagesToTheSyncStrategyInChunks
+{
+    // given
+    NSUInteger const notificationCount = 2 * ZMMissingUpdateEventsTranscoderNotificationChunkSize + 10;
+    NSMutableArray *notifications = [NSMutableArray array];
+    for (NSUInteger i = 0; i < notificationCount; i++) {
+        [notifications addObject:@{
+                                   @"id" : [NSUUID createUUID].transportString,
+                                   @"payload" : @[@{@"type" : @"conversation.message-add"}]
+                                   }];
+    }
+    NSUUID *lastNotificationID = [NSUUID uuidWithTransportString:notifications.lastObject[@"id"]];
+    
+    NSMutableArray *chunkSizes = [NSMutableArray array];
+    [[[(id) self.syncStrategy stub] andDo:^(NSInvocation *invocation) {
+        __unsafe_unretained NSArray *events;
+        [invocation getArgument:&events atIndex:2];
+        [chunkSizes addObject:@(events.count)];
+    }] processDownloadedNotificationStreamEvents:OCMOCK_ANY];
+    
+    // when
+    [(id)self.sut.listPaginator didReceiveResponse:[ZMTransportResponse responseWithPayload:@{@"notifications" : notifications} HTTPstatus:200 transportSessionError:nil] forSingleRequest:nil];
+    
+    // then
+    NSArray *expectedChunkSizes = @[@(ZMMissingUpdateEventsTranscoderNotificationChunkSize), @(ZMMissingUpdateEventsTranscoderNotificationChunkSize), @10];
+    XCTAssertEqualObjects(chunkSizes, expectedChunkSizes);
+    XCTAssertEqualObjects(self.sut.lastUpdateEventID, lastNotificationID);
+}
+
 - (void)testThatTheLastUpdateEventIDIsReadFromTheManagedObjectContext
 {
     // given
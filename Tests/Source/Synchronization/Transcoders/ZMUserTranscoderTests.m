@@ -149,6 +149,28 @@ static NSString *const USER_PATH_WITH_QUERY = @"/users?ids=";
     XCTAssertEqual(requestedIDs.count, userCount);
 }
 
+- (void)testThatItLimitsTheNumberOfUserRequestsInFlight
+{
+    // given
+    NSUInteger const userCount = ZMUserTranscoderNumberOfUUIDsPerRequest * 10;
+    NSMutableSet *users = [NSMutableSet set];
+    for (NSUInteger i = 0; i < userCount; ++i) {
+        [users addObject:[self insertUserWithRemoteID]];
+    }
+    [self.sut objectsDidChange:users];
+    
+    // when
+    NSUInteger numberOfRequests = 0;
+    for (size_t i = 0; i < 10; ++i) {
+        if ([self.sut.requestGenerators nextRequest] != nil) {
+            ++numberOfRequests;
+        }
+    }
+    
+    // then
+    XCTAssertEqual(numberOfRequests, 4u);
+}
+
 - (void)testThatItReturnsSelfUserInContext
 {
     // given
@@ -0,0 +1,205 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import zmessaging;
+@import ZMCDataModel;
+
+#import "MessagingTest.h"
+#import "ZMChangeTrackerRegistry+Testing.h"
+
+
+
+@interface RecordingChangeTracker : NSObject <ZMContextChangeTracker>
+@property (nonatomic) NSMutableArray *changedObjects;
+@end
+
+@implementation RecordingChangeTracker
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self.changedObjects = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)objectsDidChange:(NSSet *)objects
+{
+    [self.changedObjects addObject:objects];
+}
+
+- (NSFetchRequest *)fetchRequestForTrackedObjects
+{
+    return nil;
+}
+
+- (void)addTrackedObjects:(NSSet __unused *)objects
+{
+}
+
+@end
+
+
+
+@interface RecordingEntityChangeTracker : RecordingChangeTracker
+@property (nonatomic) NSSet *entityNames;
+@property (nonatomic) NSSet *keys;
+@end
+
+@implementation RecordingEntityChangeTracker
+
+- (NSSet *)trackedEntityNames
+{
+    return self.entityNames;
+}
+
+@end
+
+
+
+@interface RecordingKeyChangeTracker : RecordingEntityChangeTracker
+@end
+
+@implementation RecordingKeyChangeTracker
+
+- (NSSet *)trackedLocallyModifiedKeys
+{
+    return self.keys;
+}
+
+@end
+
+
+
+@interface ZMChangeTrackerRegistryTests : MessagingTest
+
+@property (nonatomic) ZMUser *user;
+@property (nonatomic) ZMConversation *conversation;
+@property (nonatomic) ZMConnection *connection;
+
+@end
+
+
+
+@implementation ZMChangeTrackerRegistryTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    self.user = [ZMUser insertNewObjectInManagedObjectContext:self.syncMOC];
+    self.conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+    self.connection = [ZMConnection insertNewObjectInManagedObjectContext:self.syncMOC];
+    XCTAssert([self.syncMOC saveOrRollback]);
+}
+
+- (void)tearDown
+{
+    self.user = nil;
+    self.conversation = nil;
+    self.connection = nil;
+    [super tearDown];
+}
+
+- (NSSet *)allObjects
+{
+    return [NSSet setWithObjects:self.user, self.conversation, self.connection, nil];
+}
+
+- (void)testThatItGroupsObjectsByEntityName
+{
+    // when
+    NSDictionary *objectsByEntityName = [ZMChangeTrackerRegistry objectsByEntityName:[[self allObjects] setByAddingObject:@"not a managed object"]];
+    
+    // then
+    XCTAssertEqual(objectsByEntityName.count, 3u);
+    XCTAssertEqualObjects(objectsByEntityName[ZMUser.entityName], [NSSet setWithObject:self.user]);
+    XCTAssertEqualObjects(objectsByEntityName[ZMConversation.entityName], [NSSet setWithObject:self.conversation]);
+    XCTAssertEqualObjects(objectsByEntityName[ZMConnection.entityName], [NSSet setWithObject:self.connection]);
+}
+
+- (void)testThatItPassesAllObjectsToTrackersThatDoNotDeclareEntities
+{
+    // given
+    RecordingChangeTracker *tracker = [[RecordingChangeTracker alloc] init];
+    ZMChangeTrackerRegistry *sut = [[ZMChangeTrackerRegistry alloc] initWithChangeTrackers:@[tracker]];
+    NSSet *objects = [[self allObjects] setByAddingObject:@"not a managed object"];
+    
+    // when
+    [sut objectsDidChange:objects];
+    
+    // then
+    XCTAssertEqualObjects(tracker.changedObjects, @[objects]);
+}
+
+- (void)testThatItOnlyPassesObjectsOfTheTrackedEntities
+{
+    // given
+    RecordingEntityChangeTracker *userTracker = [[RecordingEntityChangeTracker alloc] init];
+    userTracker.entityNames = [NSSet setWithObject:ZMUser.entityName];
+    RecordingEntityChangeTracker *conversationAndConnectionTracker = [[RecordingEntityChangeTracker alloc] init];
+    conversationAndConnectionTracker.entityNames = [NSSet setWithObjects:ZMConversation.entityName, ZMConnection.entityName, nil];
+    ZMChangeTrackerRegistry *sut = [[ZMChangeTrackerRegistry alloc] initWithChangeTrackers:@[userTracker, conversationAndConnectionTracker]];
+    
+    // when
+    [sut objectsDidChange:[self allObjects]];
+    
+    // then
+    NSSet *expectedObjects = [NSSet setWithObjects:self.conversation, self.connection, nil];
+    XCTAssertEqualObjects(userTracker.changedObjects, @[[NSSet setWithObject:self.user]]);
+    XCTAssertEqualObjects(conversationAndConnectionTracker.changedObjects, @[expectedObjects]);
+}
+
+- (void)testThatItDoesNotCallTrackersWhenNoObjectsOfTheirEntitiesChanged
+{
+    // given
+    RecordingEntityChangeTracker *tracker = [[RecordingEntityChangeTracker alloc] init];
+    tracker.entityNames = [NSSet setWithObject:ZMMessage.entityName];
+    ZMChangeTrackerRegistry *sut = [[ZMChangeTrackerRegistry alloc] initWithChangeTrackers:@[tracker]];
+    
+    // when
+    [sut objectsDidChange:[self allObjects]];
+    
+    // then
+    XCTAssertEqual(tracker.changedObjects.count, 0u);
+}
+
+- (void)testThatItOnlyPassesObjectsWithLocalModificationsForTheTrackedKeys
+{
+    // given
+    ZMConversation *otherConversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+    XCTAssert([self.syncMOC saveOrRollback]);
+    
+    self.conversation.userDefinedName = @"Foo";
+    [self.conversation setLocallyModifiedKeys:[NSSet setWithObject:@"userDefinedName"]];
+    
+    RecordingKeyChangeTracker *tracker = [[RecordingKeyChangeTracker alloc] init];
+    tracker.entityNames = [NSSet setWithObject:ZMConversation.entityName];
+    tracker.keys = [NSSet setWithObject:@"userDefinedName"];
+    ZMChangeTrackerRegistry *sut = [[ZMChangeTrackerRegistry alloc] initWithChangeTrackers:@[tracker]];
+    
+    // when
+    [sut objectsDidChange:[NSSet setWithObjects:self.conversation, otherConversation, nil]];
+    
+    // then
+    XCTAssertEqualObjects(tracker.changedObjects, @[[NSSet setWithObject:self.conversation]]);
+}
+
+@end
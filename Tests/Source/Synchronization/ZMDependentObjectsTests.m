@@ -167,4 +167,114 @@
     }];
 }
 
+- (void)testThatItReturnsTheDependencyOfAnObject
+{
+    // when
+    [self.sut addManagedObject:self.messageA withDependency:self.conversation1];
+    [self.sut addManagedObject:self.messageB withDependency:self.conversation2];
+    
+    // then
+    XCTAssertEqual([self.sut anyDependencyForObject:self.messageA], self.conversation1);
+    XCTAssertEqual([self.sut anyDependencyForObject:self.messageB], self.conversation2);
+    XCTAssertNil([self.sut anyDependencyForObject:self.messageC]);
+}
+
+- (void)testThatItDoesNotReturnADependencyForAnObjectThatWasRemoved
+{
+    // given
+    [self.sut addManagedObject:self.messageA withDependency:self.conversation1];
+    [self.sut addManagedObject:self.messageB withDependency:self.conversation1];
+    
+    // when
+    [self.sut enumerateManagedObjectsForDependency:self.conversation1 withBlock:^BOOL(ZMManagedObject *mo) {
+        return (mo == self.messageA);
+    }];
+    
+    // then
+    XCTAssertNil([self.sut anyDependencyForObject:self.messageA]);
+    XCTAssertEqual([self.sut anyDependencyForObject:self.messageB], self.conversation1);
+}
+
+- (void)testThatItReturnsTheRemainingDependencyWhenAnObjectIsRemovedFromOneOfTwoDependencies
+{
+    // given
+    [self.sut addManagedObject:self.messageA withDependency:self.conversation1];
+    [self.sut addManagedObject:self.messageA withDependency:self.conversation2];
+    XCTAssertEqual([self.sut anyDependencyForObject:self.messageA], self.conversation1);
+    
+    // when
+    [self.sut enumerateManagedObjectsForDependency:self.conversation1 withBlock:^BOOL(ZMManagedObject *mo) {
+        NOT_USED(mo);
+        return YES;
+    }];
+    
+    // then
+    XCTAssertEqual([self.sut anyDependencyForObject:self.messageA], self.conversation2);
+    
+    // when
+    [self.sut enumerateManagedObjectsForDependency:self.conversation2 withBlock:^BOOL(ZMManagedObject *mo) {
+        NOT_USED(mo);
+        return YES;
+    }];
+    
+    // then
+    XCTAssertNil([self.sut anyDependencyForObject:self.messageA]);
+}
+
+- (void)testThatItKeepsTheDependencyOfObjectsThatAreNotRemoved
+{
+    // given
+    [self.sut addManagedObject:self.messageA withDependency:self.conversation1];
+    [self.sut addManagedObject:self.messageA withDependency:self.conversation1];
+    
+    // when
+    [self.sut enumerateManagedObjectsForDependency:self.conversation1 withBlock:^BOOL(ZMManagedObject *mo) {
+        NOT_USED(mo);
+        return NO;
+    }];
+    
+    // then
+    XCTAssertEqual([self.sut anyDependencyForObject:self.messageA], self.conversation1);
+}
+
+- (void)testThatItCanAddAnObjectAgainAfterItWasRemoved
+{
+    // given
+    [self.sut addManagedObject:self.messageA withDependency:self.conversation1];
+    [self.sut enumerateManagedObjectsForDependency:self.conversation1 withBlock:^BOOL(ZMManagedObject *mo) {
+        NOT_USED(mo);
+        return YES;
+    }];
+    
+    // when
+    [self.sut addManagedObject:self.messageA withDependency:self.conversation2];
+    
+    // then
+    XCTAssertEqual([self.sut anyDependencyForObject:self.messageA], self.conversation2);
+    NSMutableArray *result = [NSMutableArray array];
+    [self.sut enumerateManagedObjectsForDependency:self.conversation1 withBlock:^BOOL(ZMManagedObject *mo) {
+        [result addObject:mo];
+        return YES;
+    }];
+    XCTAssertEqual(result.count, 0u);
+}
+
+- (void)testPerformanceOfLookingUpDependenciesOfManyObjects
+{
+    // given
+    NSMutableArray *messages = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 2000; ++i) {
+        ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.uiMOC];
+        ZMTextMessage *message = [ZMTextMessage insertNewObjectInManagedObjectContext:self.uiMOC];
+        [self.sut addManagedObject:message withDependency:conversation];
+        [messages addObject:message];
+    }
+    
+    [self measureBlock:^{
+        for (ZMTextMessage *message in messages) {
+            XCTAssertNotNil([self.sut anyDependencyForObject:message]);
+        }
+    }];
+}
+
 @end
@@ -683,6 +683,65 @@
     WaitForAllGroupsToBeEmpty(0.5);
 }
 
+- (void)testThatItResolvesObjectIDsOfDifferentEntitiesInTheSyncContext
+{
+    // given
+    __block NSSet *objectIDs;
+    __block NSManagedObjectID *deletedObjectID;
+    [self.syncMOC performGroupedBlockAndWait:^{
+        ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+        ZMUser *user = [ZMUser insertNewObjectInManagedObjectContext:self.syncMOC];
+        ZMConversation *deletedConversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        objectIDs = [NSSet setWithObjects:conversation.objectID, user.objectID, nil];
+        deletedObjectID = deletedConversation.objectID;
+        [self.syncMOC deleteObject:deletedConversation];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+    }];
+    
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // when
+        NSSet *objects = [ZMOperationLoop objectSetFromObjectIDs:[objectIDs setByAddingObject:deletedObjectID]
+                                                       inContext:self.syncMOC
+                              relationshipKeyPathsForPrefetching:@{[ZMConversation entityName] : [NSSet setWithObject:@"otherActiveParticipants"]}];
+        
+        // then
+        NSMutableSet *resolvedObjectIDs = [NSMutableSet set];
+        for (NSManagedObject *object in objects) {
+            XCTAssertEqual(object.managedObjectContext, self.syncMOC);
+            XCTAssertFalse(object.isFault);
+            [resolvedObjectIDs addObject:object.objectID];
+        }
+        XCTAssertEqualObjects(resolvedObjectIDs, objectIDs);
+    }];
+}
+
+- (void)testPerformanceOfResolving5000ModifiedConversations
+{
+    // given
+    NSMutableSet *objectIDs = [NSMutableSet set];
+    [self.syncMOC performGroupedBlockAndWait:^{
+        for (NSUInteger i = 0; i < 5000; ++i) {
+            ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+            conversation.remoteIdentifier = [NSUUID createUUID];
+        }
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        for (ZMConversation *conversation in [self.syncMOC.registeredObjects copy]) {
+            if ([conversation isKindOfClass:ZMConversation.class]) {
+                [objectIDs addObject:conversation.objectID];
+            }
+        }
+    }];
+    
+    [self measureBlock:^{
+        [self.syncMOC performGroupedBlockAndWait:^{
+            [self.syncMOC reset];
+            NSSet *objects = [ZMOperationLoop objectSetFromObjectIDs:objectIDs inContext:self.syncMOC relationshipKeyPathsForPrefetching:nil];
+            XCTAssertEqual(objects.count, objectIDs.count);
+        }];
+    }];
+}
+
 - (void)testThatItAsksSyncStrategyForNextOperationOnZMOperationLoopNewRequestAvailableNotification
 {
     // given
@@ -712,6 +771,63 @@
     
 }
 
+- (void)testThatItCoalescesNotificationsThatArriveBeforeTheDrainRuns
+{
+    // given
+    [[[self.syncStrategy stub] andReturnValue:@NO] slowSyncInProgress];
+    [[self.syncStrategy stub] dataDidChange];
+    ZMTransportEnqueueResult *resultNO = [ZMTransportEnqueueResult resultDidHaveLessRequestsThanMax:NO didGenerateNonNullRequest:NO];
+    [[[self.transportSession stub] andReturn:resultNO] attemptToEnqueueSyncRequestWithGenerator:OCMOCK_ANY];
+    WaitForAllGroupsToBeEmpty(0.5);
+    uint64_t const wakeUpsBefore = self.sut.numberOfRequestedWakeUps;
+    uint64_t const drainsBefore = self.sut.numberOfDrains;
+    
+    // block the sync context so that all notifications arrive before the drain can run
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    [self.syncMOC performGroupedBlock:^{
+        dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    }];
+    
+    // when
+    for (NSUInteger i = 0; i < 10; ++i) {
+        [ZMOperationLoop notifyNewRequestsAvailable:self];
+    }
+    dispatch_semaphore_signal(semaphore);
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual(self.sut.numberOfRequestedWakeUps - wakeUpsBefore, 10u);
+    XCTAssertEqual(self.sut.numberOfDrains - drainsBefore, 1u);
+}
+
+- (void)testThatANotificationDuringADrainSchedulesAnotherDrain
+{
+    // given
+    [[[self.syncStrategy stub] andReturnValue:@NO] slowSyncInProgress];
+    [[self.syncStrategy stub] dataDidChange];
+    ZMTransportEnqueueResult *resultNO = [ZMTransportEnqueueResult resultDidHaveLessRequestsThanMax:NO didGenerateNonNullRequest:NO];
+    __block BOOL shouldNotifyDuringDrain = NO;
+    __block BOOL didNotifyDuringDrain = NO;
+    [[[[self.transportSession stub] andReturn:resultNO] andDo:^(NSInvocation *invocation ZM_UNUSED) {
+        if (shouldNotifyDuringDrain) {
+            shouldNotifyDuringDrain = NO;
+            didNotifyDuringDrain = YES;
+            [ZMOperationLoop notifyNewRequestsAvailable:self];
+        }
+    }] attemptToEnqueueSyncRequestWithGenerator:OCMOCK_ANY];
+    WaitForAllGroupsToBeEmpty(0.5);
+    uint64_t const drainsBefore = self.sut.numberOfDrains;
+    shouldNotifyDuringDrain = YES;
+    
+    // when
+    [ZMOperationLoop notifyNewRequestsAvailable:self];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertTrue(didNotifyDuringDrain);
+    XCTAssertEqual(self.sut.numberOfDrains - drainsBefore, 2u);
+}
+
 
 - (void)testThatPushChannelDataIsSplitAndForwardedToAllIndividualObjects
 {
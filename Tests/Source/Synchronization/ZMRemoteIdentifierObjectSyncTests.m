@@ -468,3 +468,190 @@ typedef ZMTransportRequest * (^stubbedRequestForObjectSync_t)(id self, ZMRemoteI
 }
 
 @end
+
+
+
+@implementation ZMRemoteIdentifierObjectTranscoderTests (BatchesInFlight)
+
+- (NSArray *)stubRequestsForRemoteIdentifierCount:(NSUInteger)count identifiersPerRequest:(NSUInteger)identifiersPerRequest requestedIDs:(NSMutableArray *)requestedIDs
+{
+    NSMutableArray *remoteIDs = [NSMutableArray array];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [remoteIDs addObject:NSUUID.createUUID];
+    }
+    [[[self.transcoder stub] andReturnValue:OCMOCK_VALUE(identifiersPerRequest)] maximumRemoteIdentifiersPerRequestForObjectSync:OCMOCK_ANY];
+    NSMutableArray *requests = [NSMutableArray array];
+    [[[self.transcoder stub] andDo:^(NSInvocation *invocation) {
+        __unsafe_unretained NSSet *identifiers;
+        [invocation getArgument:&identifiers atIndex:3];
+        [requestedIDs addObject:identifiers];
+        // the invocation does not retain its return value
+        ZMTransportRequest *request = [ZMTransportRequest requestGetFromPath:@"foo"];
+        [requests addObject:request];
+        [invocation setReturnValue:&request];
+    }] requestForObjectSync:OCMOCK_ANY remoteIdentifiers:OCMOCK_ANY];
+    return remoteIDs;
+}
+
+- (ZMTransportResponse *)expiredResponse
+{
+    NSError *error = [NSError errorWithDomain:ZMTransportSessionErrorDomain code:ZMTransportSessionErrorCodeRequestExpired userInfo:nil];
+    return [ZMTransportResponse responseWithTransportSessionError:error];
+}
+
+- (void)testThatItDoesNotHaveMoreThanTheMaximumNumberOfBatchesInFlight
+{
+    // given
+    NSMutableArray *requestedIDs = [NSMutableArray array];
+    NSArray *remoteIDs = [self stubRequestsForRemoteIdentifierCount:10 identifiersPerRequest:2 requestedIDs:requestedIDs];
+    [[self.transcoder stub] didReceiveResponse:OCMOCK_ANY remoteIdentifierObjectSync:OCMOCK_ANY forRemoteIdentifiers:OCMOCK_ANY];
+    self.sut.maximumNumberOfBatchesInFlight = 2;
+    [self.sut setRemoteIdentifiersAsNeedingDownload:[NSSet setWithArray:remoteIDs]];
+    
+    // when
+    ZMTransportRequest *request1 = [self.sut nextRequest];
+    ZMTransportRequest *request2 = [self.sut nextRequest];
+    ZMTransportRequest *request3 = [self.sut nextRequest];
+    
+    // then
+    XCTAssertNotNil(request1);
+    XCTAssertNotNil(request2);
+    XCTAssertNil(request3);
+    XCTAssertEqual(self.sut.numberOfBatchesInFlight, 2u);
+    
+    // and when
+    [request1 completeWithResponse:[ZMTransportResponse responseWithPayload:@{} HTTPstatus:200 transportSessionError:nil]];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual(self.sut.numberOfBatchesInFlight, 1u);
+    XCTAssertNotNil([self.sut nextRequest]);
+    XCTAssertNil([self.sut nextRequest]);
+    XCTAssertEqual(requestedIDs.count, 3u);
+}
+
+- (void)testThatItForwardsAResponseToTheTranscoderWithoutWaitingForEarlierBatches
+{
+    // given
+    NSMutableArray *requestedIDs = [NSMutableArray array];
+    NSArray *remoteIDs = [self stubRequestsForRemoteIdentifierCount:4 identifiersPerRequest:2 requestedIDs:requestedIDs];
+    NSMutableArray *forwardedIDs = [NSMutableArray array];
+    [[[self.transcoder stub] andDo:^(NSInvocation *invocation) {
+        __unsafe_unretained NSSet *identifiers;
+        [invocation getArgument:&identifiers atIndex:4];
+        [forwardedIDs addObject:identifiers];
+    }] didReceiveResponse:OCMOCK_ANY remoteIdentifierObjectSync:OCMOCK_ANY forRemoteIdentifiers:OCMOCK_ANY];
+    [self.sut setRemoteIdentifiersAsNeedingDownload:[NSSet setWithArray:remoteIDs]];
+    ZMTransportResponse *success = [ZMTransportResponse responseWithPayload:@{} HTTPstatus:200 transportSessionError:nil];
+    
+    ZMTransportRequest *request1 = [self.sut nextRequest];
+    ZMTransportRequest *request2 = [self.sut nextRequest];
+    
+    // when
+    [request2 completeWithResponse:success];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqualObjects(forwardedIDs, @[requestedIDs.lastObject]);
+    XCTAssertFalse(self.sut.isDone);
+    
+    // and when
+    [request1 completeWithResponse:success];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqualObjects(forwardedIDs, (@[requestedIDs.lastObject, requestedIDs.firstObject]));
+    XCTAssertTrue(self.sut.isDone);
+}
+
+- (void)testThatItDoesNotLimitTheNumberOfBatchesInFlightByDefault
+{
+    // given
+    NSMutableArray *requestedIDs = [NSMutableArray array];
+    NSArray *remoteIDs = [self stubRequestsForRemoteIdentifierCount:10 identifiersPerRequest:2 requestedIDs:requestedIDs];
+    [self.sut setRemoteIdentifiersAsNeedingDownload:[NSSet setWithArray:remoteIDs]];
+    
+    // when
+    while ([self.sut nextRequest] != nil);
+    
+    // then
+    XCTAssertEqual(requestedIDs.count, 5u);
+    XCTAssertEqual(self.sut.numberOfBatchesInFlight, 5u);
+}
+
+- (void)testThatItRetriesABatchThatFailsWithATemporaryErrorAndThenGivesUpOnIt
+{
+    // given
+    NSMutableArray *requestedIDs = [NSMutableArray array];
+    NSArray *remoteIDs = [self stubRequestsForRemoteIdentifierCount:2 identifiersPerRequest:2 requestedIDs:requestedIDs];
+    [[self.transcoder reject] didReceiveResponse:OCMOCK_ANY remoteIdentifierObjectSync:OCMOCK_ANY forRemoteIdentifiers:OCMOCK_ANY];
+    self.sut.maximumNumberOfAttemptsPerBatch = 3;
+    [self.sut setRemoteIdentifiersAsNeedingDownload:[NSSet setWithArray:remoteIDs]];
+    ZMTransportResponse *temporaryError = [ZMTransportResponse responseWithPayload:nil HTTPstatus:500 transportSessionError:nil];
+    
+    // when
+    for (NSUInteger i = 0; i < 2; ++i) {
+        [[self.sut nextRequest] completeWithResponse:temporaryError];
+        WaitForAllGroupsToBeEmpty(0.5);
+        XCTAssertFalse(self.sut.isDone);
+    }
+    [[self.sut nextRequest] completeWithResponse:temporaryError];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual(requestedIDs.count, 3u);
+    XCTAssertEqualObjects(requestedIDs.firstObject, requestedIDs.lastObject);
+    XCTAssertNil([self.sut nextRequest]);
+    XCTAssertTrue(self.sut.isDone);
+    XCTAssertEqual(self.sut.remoteIdentifiersThatWillBeDownloaded.count, 0u);
+    [self.transcoder verify];
+}
+
+- (void)testThatItRetriesAnExpiredBatch
+{
+    // given
+    NSMutableArray *requestedIDs = [NSMutableArray array];
+    NSArray *remoteIDs = [self stubRequestsForRemoteIdentifierCount:2 identifiersPerRequest:2 requestedIDs:requestedIDs];
+    [[self.transcoder expect] didReceiveResponse:OCMOCK_ANY remoteIdentifierObjectSync:self.sut forRemoteIdentifiers:[NSSet setWithArray:remoteIDs]];
+    [self.sut setRemoteIdentifiersAsNeedingDownload:[NSSet setWithArray:remoteIDs]];
+    
+    // when
+    [[self.sut nextRequest] completeWithResponse:self.expiredResponse];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertFalse(self.sut.isDone);
+    
+    // and when
+    [[self.sut nextRequest] completeWithResponse:[ZMTransportResponse responseWithPayload:@{} HTTPstatus:200 transportSessionError:nil]];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual(requestedIDs.count, 2u);
+    XCTAssertEqualObjects(requestedIDs.firstObject, requestedIDs.lastObject);
+    XCTAssertTrue(self.sut.isDone);
+    [self.transcoder verify];
+}
+
+- (void)testThatItDoesNotCountTryAgainLaterAsAnAttempt
+{
+    // given
+    NSMutableArray *requestedIDs = [NSMutableArray array];
+    NSArray *remoteIDs = [self stubRequestsForRemoteIdentifierCount:2 identifiersPerRequest:2 requestedIDs:requestedIDs];
+    [[self.transcoder stub] didReceiveResponse:OCMOCK_ANY remoteIdentifierObjectSync:OCMOCK_ANY forRemoteIdentifiers:OCMOCK_ANY];
+    self.sut.maximumNumberOfAttemptsPerBatch = 1;
+    [self.sut setRemoteIdentifiersAsNeedingDownload:[NSSet setWithArray:remoteIDs]];
+    NSError *error = [NSError errorWithDomain:ZMTransportSessionErrorDomain code:ZMTransportSessionErrorCodeTryAgainLater userInfo:nil];
+    
+    // when
+    for (NSUInteger i = 0; i < 3; ++i) {
+        [[self.sut nextRequest] completeWithResponse:[ZMTransportResponse responseWithTransportSessionError:error]];
+        WaitForAllGroupsToBeEmpty(0.5);
+    }
+    
+    // then
+    XCTAssertEqual(requestedIDs.count, 3u);
+    XCTAssertFalse(self.sut.isDone);
+}
+
+@end
@@ -0,0 +1,286 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMTransport;
+
+#import "MessagingTest.h"
+#import "ZMRequestScheduler.h"
+#import "ZMRequestGenerator.h"
+
+
+
+@interface ZMFakeSchedulerRequestGenerator : NSObject <ZMRequestGenerator>
+
+@property (nonatomic) NSUInteger numberOfRequestsLeft;
+@property (nonatomic) NSUInteger numberOfRequestsReturned;
+@property (nonatomic) NSMutableArray<ZMTransportRequest *> *requests;
+
+@end
+
+
+
+@implementation ZMFakeSchedulerRequestGenerator
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        self.numberOfRequestsLeft = NSUIntegerMax;
+        self.requests = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (ZMTransportRequest *)nextRequest
+{
+    if (self.numberOfRequestsLeft == 0) {
+        return nil;
+    }
+    --self.numberOfRequestsLeft;
+    ++self.numberOfRequestsReturned;
+    ZMTransportRequest *request = [ZMTransportRequest requestGetFromPath:@"/foo"];
+    [self.requests addObject:request];
+    return request;
+}
+
+@end
+
+
+
+@interface ZMRequestSchedulerTests : MessagingTest
+
+@property (nonatomic) ZMRequestScheduler *sut;
+@property (nonatomic) ZMFakeSchedulerRequestGenerator *realtimeGenerator;
+@property (nonatomic) ZMFakeSchedulerRequestGenerator *userVisibleGenerator;
+@property (nonatomic) ZMFakeSchedulerRequestGenerator *metadataGenerator;
+@property (nonatomic) ZMFakeSchedulerRequestGenerator *bulkGenerator;
+
+@end
+
+
+
+@implementation ZMRequestSchedulerTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.sut = [[ZMRequestScheduler alloc] initWithManagedObjectContext:self.uiMOC];
+    
+    self.realtimeGenerator = [[ZMFakeSchedulerRequestGenerator alloc] init];
+    self.userVisibleGenerator = [[ZMFakeSchedulerRequestGenerator alloc] init];
+    self.metadataGenerator = [[ZMFakeSchedulerRequestGenerator alloc] init];
+    self.bulkGenerator = [[ZMFakeSchedulerRequestGenerator alloc] init];
+    
+    // added in reverse order to make sure that the order of adding does not matter across classes
+    [self.sut addRequestGenerator:self.bulkGenerator priorityClass:ZMRequestPriorityClassBulk];
+    [self.sut addRequestGenerator:self.metadataGenerator priorityClass:ZMRequestPriorityClassMetadata];
+    [self.sut addRequestGenerator:self.userVisibleGenerator priorityClass:ZMRequestPriorityClassUserVisible];
+    [self.sut addRequestGenerator:self.realtimeGenerator priorityClass:ZMRequestPriorityClassRealtime];
+}
+
+- (void)tearDown
+{
+    self.sut = nil;
+    self.realtimeGenerator = nil;
+    self.userVisibleGenerator = nil;
+    self.metadataGenerator = nil;
+    self.bulkGenerator = nil;
+    [super tearDown];
+}
+
+- (void)testThatItAsksTheHighestPriorityClassFirst
+{
+    // when
+    ZMTransportRequest *request = [self.sut nextRequest];
+    
+    // then
+    XCTAssertEqualObjects(request, self.realtimeGenerator.requests.firstObject);
+    XCTAssertEqual(self.userVisibleGenerator.numberOfRequestsReturned, 0u);
+}
+
+- (void)testThatItAsksLowerPriorityClassesWhenHigherOnesHaveNoRequests
+{
+    // given
+    self.realtimeGenerator.numberOfRequestsLeft = 0;
+    self.userVisibleGenerator.numberOfRequestsLeft = 0;
+    
+    // when
+    ZMTransportRequest *request = [self.sut nextRequest];
+    
+    // then
+    XCTAssertEqualObjects(request, self.metadataGenerator.requests.firstObject);
+}
+
+- (void)testThatItReturnsNilWhenNoClassHasRequests
+{
+    // given
+    self.realtimeGenerator.numberOfRequestsLeft = 0;
+    self.userVisibleGenerator.numberOfRequestsLeft = 0;
+    self.metadataGenerator.numberOfRequestsLeft = 0;
+    self.bulkGenerator.numberOfRequestsLeft = 0;
+    
+    // then
+    XCTAssertNil([self.sut nextRequest]);
+}
+
+- (void)testThatItDoesNotAskARemovedRequestGeneratorSource
+{
+    // given
+    id source = [OCMockObject mockForProtocol:@protocol(ZMRequestGeneratorSource)];
+    [[source reject] requestGenerators];
+    [self.sut addRequestGeneratorSource:source priorityClass:ZMRequestPriorityClassRealtime];
+    
+    // when
+    [self.sut removeRequestGeneratorSource:source];
+    ZMTransportRequest *request = [self.sut nextRequest];
+    
+    // then
+    XCTAssertEqualObjects(request, self.realtimeGenerator.requests.firstObject);
+    [source verify];
+}
+
+- (void)testThatItAsksGeneratorsOfTheSameClassInTheOrderTheyWereAdded
+{
+    // given
+    ZMFakeSchedulerRequestGenerator *first = [[ZMFakeSchedulerRequestGenerator alloc] init];
+    ZMFakeSchedulerRequestGenerator *second = [[ZMFakeSchedulerRequestGenerator alloc] init];
+    ZMRequestScheduler *sut = [[ZMRequestScheduler alloc] initWithManagedObjectContext:self.uiMOC];
+    [sut addRequestGenerator:first priorityClass:ZMRequestPriorityClassMetadata];
+    [sut addRequestGenerator:second priorityClass:ZMRequestPriorityClassMetadata];
+    first.numberOfRequestsLeft = 1;
+    
+    // when
+    ZMTransportRequest *request1 = [sut nextRequest];
+    ZMTransportRequest *request2 = [sut nextRequest];
+    
+    // then
+    XCTAssertEqualObjects(request1, first.requests.firstObject);
+    XCTAssertEqualObjects(request2, second.requests.firstObject);
+}
+
+- (void)testThatItServesClassesByTheirWeightWhenAllClassesHaveRequests
+{
+    // given
+    NSUInteger const rounds = 4;
+    NSUInteger totalWeight = 0;
+    for (NSUInteger priorityClass = 0; priorityClass < ZMRequestPriorityClassCount; ++priorityClass) {
+        totalWeight += [self.sut weightForPriorityClass:priorityClass];
+    }
+    
+    // when
+    for (NSUInteger i = 0; i < rounds * totalWeight; ++i) {
+        XCTAssertNotNil([self.sut nextRequest]);
+    }
+    
+    // then
+    XCTAssertEqual(self.realtimeGenerator.numberOfRequestsReturned, rounds * [self.sut weightForPriorityClass:ZMRequestPriorityClassRealtime]);
+    XCTAssertEqual(self.userVisibleGenerator.numberOfRequestsReturned, rounds * [self.sut weightForPriorityClass:ZMRequestPriorityClassUserVisible]);
+    XCTAssertEqual(self.metadataGenerator.numberOfRequestsReturned, rounds * [self.sut weightForPriorityClass:ZMRequestPriorityClassMetadata]);
+    XCTAssertEqual(self.bulkGenerator.numberOfRequestsReturned, rounds * [self.sut weightForPriorityClass:ZMRequestPriorityClassBulk]);
+}
+
+- (void)testThatItDoesNotStarveTheBulkClass
+{
+    // given
+    NSUInteger const count = 10 * [self.sut weightForPriorityClass:ZMRequestPriorityClassRealtime];
+    
+    // when
+    for (NSUInteger i = 0; i < count; ++i) {
+        (void) [self.sut nextRequest];
+    }
+    
+    // then
+    XCTAssertGreaterThan(self.bulkGenerator.numberOfRequestsReturned, 0u);
+}
+
+- (void)testThatAnIdleClassDoesNotCatchUpOnTurnsItMissed
+{
+    // given
+    self.userVisibleGenerator.numberOfRequestsLeft = 0;
+    self.metadataGenerator.numberOfRequestsLeft = 0;
+    self.bulkGenerator.numberOfRequestsLeft = 0;
+    NSUInteger const realtimeWeight = [self.sut weightForPriorityClass:ZMRequestPriorityClassRealtime];
+    for (NSUInteger i = 0; i < 4 * realtimeWeight; ++i) {
+        (void) [self.sut nextRequest];
+    }
+    
+    // when
+    self.bulkGenerator.numberOfRequestsLeft = NSUIntegerMax;
+    for (NSUInteger i = 0; i < realtimeWeight; ++i) {
+        (void) [self.sut nextRequest];
+    }
+    
+    // then
+    XCTAssertEqual(self.bulkGenerator.numberOfRequestsReturned, 1u);
+}
+
+- (void)testThatItLimitsTheNumberOfRequestsInFlightPerClass
+{
+    // given
+    self.realtimeGenerator.numberOfRequestsLeft = 0;
+    self.userVisibleGenerator.numberOfRequestsLeft = 0;
+    self.metadataGenerator.numberOfRequestsLeft = 0;
+    [self.sut setMaximumNumberOfRequestsInFlight:2 forPriorityClass:ZMRequestPriorityClassBulk];
+    
+    // when
+    XCTAssertNotNil([self.sut nextRequest]);
+    XCTAssertNotNil([self.sut nextRequest]);
+    
+    // then
+    XCTAssertNil([self.sut nextRequest]);
+    XCTAssertEqual([self.sut numberOfRequestsInFlightForPriorityClass:ZMRequestPriorityClassBulk], 2u);
+    
+    // and when
+    [self.bulkGenerator.requests.firstObject completeWithResponse:[ZMTransportResponse responseWithPayload:@{} HTTPstatus:200 transportSessionError:nil]];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual([self.sut numberOfRequestsInFlightForPriorityClass:ZMRequestPriorityClassBulk], 1u);
+    XCTAssertNotNil([self.sut nextRequest]);
+}
+
+- (void)testThatItDoesNotLimitTheNumberOfRequestsInFlightByDefault
+{
+    // given
+    self.realtimeGenerator.numberOfRequestsLeft = 0;
+    self.userVisibleGenerator.numberOfRequestsLeft = 0;
+    self.metadataGenerator.numberOfRequestsLeft = 0;
+    self.bulkGenerator.numberOfRequestsLeft = 10;
+    
+    // when
+    while ([self.sut nextRequest] != nil);
+    
+    // then
+    XCTAssertEqual([self.sut numberOfRequestsInFlightForPriorityClass:ZMRequestPriorityClassBulk], 10u);
+}
+
+- (void)testThatALimitedClassDoesNotBlockOtherClasses
+{
+    // given
+    [self.sut setMaximumNumberOfRequestsInFlight:0 forPriorityClass:ZMRequestPriorityClassRealtime];
+    
+    // when
+    ZMTransportRequest *request = [self.sut nextRequest];
+    
+    // then
+    XCTAssertEqualObjects(request, self.userVisibleGenerator.requests.firstObject);
+    XCTAssertEqual(self.realtimeGenerator.numberOfRequestsReturned, 0u);
+}
+
+@end
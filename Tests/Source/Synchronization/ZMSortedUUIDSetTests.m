@@ -0,0 +1,189 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMTesting;
+
+#import "ZMSortedUUIDSet.h"
+
+
+@interface ZMSortedUUIDSetTests : ZMTBaseTest
+@end
+
+
+
+@implementation ZMSortedUUIDSetTests
+
+- (NSSet<NSUUID *> *)createUUIDs:(NSUInteger)count
+{
+    NSMutableSet *uuids = [NSMutableSet setWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [uuids addObject:[NSUUID UUID]];
+    }
+    return uuids;
+}
+
+- (NSArray<NSUUID *> *)sortedUUIDs:(id<NSFastEnumeration>)uuids
+{
+    NSMutableArray *result = [NSMutableArray array];
+    for (NSUUID *uuid in uuids) {
+        [result addObject:uuid];
+    }
+    [result sortUsingComparator:^NSComparisonResult(NSUUID *uuid1, NSUUID *uuid2) {
+        uuid_t u1;
+        uuid_t u2;
+        [uuid1 getUUIDBytes:u1];
+        [uuid2 getUUIDBytes:u2];
+        int const order = memcmp(u1, u2, sizeof(u1));
+        return (order < 0) ? NSOrderedAscending : ((order > 0) ? NSOrderedDescending : NSOrderedSame);
+    }];
+    return result;
+}
+
+- (void)testThatItKeepsTheUUIDsSorted
+{
+    // given
+    ZMSortedUUIDSet *sut = [[ZMSortedUUIDSet alloc] init];
+    NSSet *first = [self createUUIDs:50];
+    NSSet *second = [self createUUIDs:50];
+    
+    // when
+    [sut addUUIDs:first];
+    [sut addUUIDs:second];
+    
+    // then
+    XCTAssertEqual(sut.count, 100u);
+    XCTAssertEqualObjects(sut.allUUIDs, [self sortedUUIDs:[first setByAddingObjectsFromSet:second]]);
+}
+
+- (void)testThatItDoesNotAddTheSameUUIDTwice
+{
+    // given
+    ZMSortedUUIDSet *sut = [[ZMSortedUUIDSet alloc] init];
+    NSSet *uuids = [self createUUIDs:10];
+    NSUUID *other = [NSUUID UUID];
+    
+    // when
+    [sut addUUIDs:uuids];
+    [sut addUUIDs:[NSSet setWithObjects:uuids.anyObject, other, nil]];
+    
+    // then
+    XCTAssertEqual(sut.count, 11u);
+    XCTAssertTrue([sut containsUUID:other]);
+    XCTAssertTrue([sut containsUUID:uuids.anyObject]);
+    XCTAssertFalse([sut containsUUID:[NSUUID UUID]]);
+}
+
+- (void)testThatItRemovesUUIDsFromTheFront
+{
+    // given
+    ZMSortedUUIDSet *sut = [[ZMSortedUUIDSet alloc] init];
+    NSSet *uuids = [self createUUIDs:10];
+    NSArray *sorted = [self sortedUUIDs:uuids];
+    [sut addUUIDs:uuids];
+    
+    // when
+    NSSet *removed = [sut removeFirstUUIDs:4];
+    
+    // then
+    XCTAssertEqualObjects(removed, [NSSet setWithArray:[sorted subarrayWithRange:NSMakeRange(0, 4)]]);
+    XCTAssertEqualObjects(sut.allUUIDs, [sorted subarrayWithRange:NSMakeRange(4, 6)]);
+    XCTAssertFalse([sut containsUUID:sorted.firstObject]);
+    
+    // and when
+    removed = [sut removeFirstUUIDs:100];
+    
+    // then
+    XCTAssertEqual(removed.count, 6u);
+    XCTAssertEqual(sut.count, 0u);
+}
+
+- (void)testThatItMergesIntoASetThatHadUUIDsRemovedFromTheFront
+{
+    // given
+    ZMSortedUUIDSet *sut = [[ZMSortedUUIDSet alloc] init];
+    NSSet *uuids = [self createUUIDs:10];
+    [sut addUUIDs:uuids];
+    NSSet *removed = [sut removeFirstUUIDs:5];
+    NSSet *added = [self createUUIDs:5];
+    
+    // when
+    [sut addUUIDs:added];
+    
+    // then
+    NSMutableSet *expected = [uuids mutableCopy];
+    [expected minusSet:removed];
+    [expected unionSet:added];
+    XCTAssertEqualObjects(sut.allUUIDs, [self sortedUUIDs:expected]);
+}
+
+- (void)testThatItKeepsTheUUIDsSortedWhileGrowingWithManySmallBatches
+{
+    // given
+    ZMSortedUUIDSet *sut = [[ZMSortedUUIDSet alloc] init];
+    NSMutableSet *expected = [NSMutableSet set];
+    
+    // when
+    for (NSUInteger i = 0; i < 200; ++i) {
+        NSSet *uuids = [self createUUIDs:5];
+        // one UUID that is already in the set
+        XCTAssertTrue([sut addUUIDs:(expected.count > 0) ? [uuids setByAddingObject:expected.anyObject] : uuids]);
+        [expected unionSet:uuids];
+        if (i % 10 == 0) {
+            [expected minusSet:[sut removeFirstUUIDs:3]];
+        }
+    }
+    
+    // then
+    XCTAssertEqualObjects(sut.allUUIDs, [self sortedUUIDs:expected]);
+}
+
+- (void)testThatItRemovesAllUUIDs
+{
+    // given
+    ZMSortedUUIDSet *sut = [[ZMSortedUUIDSet alloc] init];
+    [sut addUUIDs:[self createUUIDs:10]];
+    
+    // when
+    [sut removeAllUUIDs];
+    
+    // then
+    XCTAssertEqual(sut.count, 0u);
+    XCTAssertEqualObjects(sut.allUUIDs, @[]);
+}
+
+- (void)testPerformanceOfAddingAndRemovingBatchesWith100kUUIDs
+{
+    NSSet *initial = [self createUUIDs:100000];
+    NSMutableArray *retries = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 100; ++i) {
+        [retries addObject:[self createUUIDs:50]];
+    }
+    
+    [self measureBlock:^{
+        ZMSortedUUIDSet *sut = [[ZMSortedUUIDSet alloc] init];
+        [sut addUUIDs:initial];
+        for (NSSet *retry in retries) {
+            (void) [sut removeFirstUUIDs:50];
+            [sut addUUIDs:retry];
+        }
+        XCTAssertEqual(sut.count, 100000u);
+    }];
+}
+
+@end
@@ -472,6 +472,25 @@
 }
 
 
+- (void)testThatItDiscardsDownloadedNotificationStreamEventsFromTheBufferAndProcessesThem
+{
+    // given
+    NSArray *downloadedEvents = [ZMUpdateEvent eventsArrayFromPushChannelData:@{@"id" : @"5cc1ab91-45f4-49ec-bb7a-a5517b7a4173",
+                                                                                @"payload" : @[@{@"type" : @"user.update", @"foo" : @"bar"}]}];
+    XCTAssertEqual(downloadedEvents.count, 1u);
+    
+    // expect
+    [self expectSyncObjectsToProcessEvents:YES
+                                liveEvents:YES
+                             decryptEvents:NO
+                   returnIDsForPrefetching:YES
+                                withEvents:downloadedEvents];
+    [[self.updateEventsBuffer expect] discardUpdateEventsWithIdentifiers:[NSSet setWithObject:[downloadedEvents.firstObject uuid]]];
+    
+    // when
+    [self.sut processDownloadedNotificationStreamEvents:downloadedEvents];
+}
+
 - (void)testThatItForwardsUpdateEventsToBufferIfTheCurrentStateShouldBufferThemAndDoesNotDecryptTheUpdateEvents
 {
     // given
@@ -825,6 +844,49 @@
 
 }
 
+- (void)testThatNextRequestAsksTheRequestSchedulerWhenTheStateMachineHasNoRequest
+{
+    // given
+    ZMTransportRequest *dummyRequest = [OCMockObject mockForClass:ZMTransportRequest.class];
+    [[self.mockUpstreamSync1 stub] fetchRequestForTrackedObjects];
+    [[self.mockUpstreamSync2 stub] fetchRequestForTrackedObjects];
+    [[[(id)self.stateMachine stub] andReturn:nil] nextRequest];
+    [[[(id)self.stateMachine stub] andReturnValue:OCMOCK_VALUE(NO)] includesRequestSchedulerRequests];
+    id requestScheduler = [OCMockObject partialMockForObject:self.sut.requestScheduler];
+    
+    // expect
+    [[[requestScheduler expect] andReturn:dummyRequest] nextRequest];
+    
+    // when
+    ZMTransportRequest *request = [self.sut nextRequest];
+    
+    // then
+    XCTAssertEqualObjects(dummyRequest, request);
+    [requestScheduler verify];
+    [requestScheduler stopMocking];
+}
+
+- (void)testThatNextRequestDoesNotAskTheRequestSchedulerAgainWhenTheStateMachineAlreadyDid
+{
+    // given
+    [[self.mockUpstreamSync1 stub] fetchRequestForTrackedObjects];
+    [[self.mockUpstreamSync2 stub] fetchRequestForTrackedObjects];
+    [[[(id)self.stateMachine stub] andReturn:nil] nextRequest];
+    [[[(id)self.stateMachine stub] andReturnValue:OCMOCK_VALUE(YES)] includesRequestSchedulerRequests];
+    id requestScheduler = [OCMockObject partialMockForObject:self.sut.requestScheduler];
+    
+    // expect
+    [[requestScheduler reject] nextRequest];
+    
+    // when
+    ZMTransportRequest *request = [self.sut nextRequest];
+    
+    // then
+    XCTAssertNil(request);
+    [requestScheduler verify];
+    [requestScheduler stopMocking];
+}
+
 - (void)testThatManagedObjectChangesArePassedToAllSyncObjectsCaches
 {
     
@@ -1089,7 +1151,13 @@
                    returnIDsForPrefetching:NO
                                 withEvents:events];
     
-    [[[self.updateEventsBuffer expect] andReturn:events] updateEvents];
+    [[[self.updateEventsBuffer expect] andDo:^(NSInvocation *invocation) {
+        __unsafe_unretained void(^block)(ZMUpdateEvent *);
+        [invocation getArgument:&block atIndex:2];
+        for (ZMUpdateEvent *event in events) {
+            block(event);
+        }
+    }] enumerateUpdateEventsUsingBlock:OCMOCK_ANY];
     
     [self.sut processUpdateEvents:events ignoreBuffer:NO];
     
@@ -1135,7 +1203,13 @@
                    returnIDsForPrefetching:NO
                                 withEvents:events];
     
-    [[[self.updateEventsBuffer expect] andReturn:events] updateEvents];
+    [[[self.updateEventsBuffer expect] andDo:^(NSInvocation *invocation) {
+        __unsafe_unretained void(^block)(ZMUpdateEvent *);
+        [invocation getArgument:&block atIndex:2];
+        for (ZMUpdateEvent *event in events) {
+            block(event);
+        }
+    }] enumerateUpdateEventsUsingBlock:OCMOCK_ANY];
 
     [self.sut processUpdateEvents:events ignoreBuffer:NO];
     
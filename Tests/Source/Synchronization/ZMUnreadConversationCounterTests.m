@@ -0,0 +1,251 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMCDataModel;
+
+#import "MessagingTest.h"
+#import "ZMUnreadConversationCounter.h"
+
+
+@interface ZMUnreadConversationCounterTests : MessagingTest
+
+@property (nonatomic) ZMUnreadConversationCounter *sut;
+
+@end
+
+
+
+@implementation ZMUnreadConversationCounterTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.sut = [[ZMUnreadConversationCounter alloc] initWithManagedObjectContext:self.syncMOC];
+}
+
+- (void)tearDown
+{
+    self.sut = nil;
+    [super tearDown];
+}
+
+- (ZMConversation *)insertGroupConversationWithUnreadCount:(int64_t)unreadCount
+{
+    ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+    conversation.conversationType = ZMConversationTypeGroup;
+    conversation.internalEstimatedUnreadCount = unreadCount;
+    return conversation;
+}
+
+- (void)testThatItFetchesTheUnreadConversationsOnTheFirstRead
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        [self insertGroupConversationWithUnreadCount:1];
+        [self insertGroupConversationWithUnreadCount:3];
+        [self insertGroupConversationWithUnreadCount:0];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        
+        // then
+        XCTAssertEqual(self.sut.unreadConversationCount, 2u);
+        XCTAssertEqual(self.sut.unreadConversationCount, [ZMConversation unreadConversationCountInContext:self.syncMOC]);
+    }];
+}
+
+- (void)testThatItUpdatesTheCountFromChangedConversations
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMConversation *conversation1 = [self insertGroupConversationWithUnreadCount:1];
+        ZMConversation *conversation2 = [self insertGroupConversationWithUnreadCount:0];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        XCTAssertEqual(self.sut.unreadConversationCount, 1u);
+        
+        // when
+        conversation1.internalEstimatedUnreadCount = 0;
+        conversation2.internalEstimatedUnreadCount = 2;
+        ZMConversation *conversation3 = [self insertGroupConversationWithUnreadCount:5];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        [self.sut objectsDidChange:[NSSet setWithObjects:conversation1, conversation2, conversation3, nil]];
+        
+        // then
+        XCTAssertEqual(self.sut.unreadConversationCount, 2u);
+        XCTAssertEqual(self.sut.unreadConversationCount, [ZMConversation unreadConversationCountInContext:self.syncMOC]);
+    }];
+}
+
+- (void)testThatItCountsAConversationOnlyOnceWhenItChangesSeveralTimes
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMConversation *conversation = [self insertGroupConversationWithUnreadCount:1];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        XCTAssertEqual(self.sut.unreadConversationCount, 1u);
+        
+        // when
+        conversation.internalEstimatedUnreadCount = 2;
+        [self.sut objectsDidChange:[NSSet setWithObject:conversation]];
+        conversation.internalEstimatedUnreadCount = 3;
+        [self.sut objectsDidChange:[NSSet setWithObject:conversation]];
+        
+        // then
+        XCTAssertEqual(self.sut.unreadConversationCount, 1u);
+    }];
+}
+
+- (void)testThatItDoesNotCountTheSelfConversation
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMConversation *conversation = [self insertGroupConversationWithUnreadCount:1];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        XCTAssertEqual(self.sut.unreadConversationCount, 1u);
+        
+        // when
+        conversation.conversationType = ZMConversationTypeSelf;
+        [self.sut objectsDidChange:[NSSet setWithObject:conversation]];
+        
+        // then
+        XCTAssertEqual(self.sut.unreadConversationCount, 0u);
+    }];
+}
+
+- (void)testThatItRemovesDeletedConversations
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMConversation *conversation = [self insertGroupConversationWithUnreadCount:1];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        XCTAssertEqual(self.sut.unreadConversationCount, 1u);
+        
+        // when
+        [self.syncMOC deleteObject:conversation];
+        [self.sut objectsDidChange:[NSSet setWithObject:conversation]];
+        
+        // then
+        XCTAssertEqual(self.sut.unreadConversationCount, 0u);
+    }];
+}
+
+- (ZMConnection *)insertOneOnOneConversationWithConnectionStatus:(ZMConnectionStatus)status
+{
+    ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+    conversation.conversationType = ZMConversationTypeOneOnOne;
+    ZMConnection *connection = [ZMConnection insertNewObjectInManagedObjectContext:self.syncMOC];
+    connection.conversation = conversation;
+    connection.status = status;
+    return connection;
+}
+
+- (void)testThatItTracksConnections
+{
+    XCTAssertTrue([self.sut.trackedEntityNames containsObject:ZMConnection.entityName]);
+}
+
+- (void)testThatItUpdatesTheCountWhenOnlyTheConnectionChanges
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMConnection *blockedConnection = [self insertOneOnOneConversationWithConnectionStatus:ZMConnectionStatusAccepted];
+        blockedConnection.conversation.internalEstimatedUnreadCount = 1;
+        ZMConnection *pendingConnection = [self insertOneOnOneConversationWithConnectionStatus:ZMConnectionStatusSent];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        XCTAssertEqual(self.sut.unreadConversationCount, 1u);
+        
+        // when
+        blockedConnection.status = ZMConnectionStatusBlocked;
+        pendingConnection.status = ZMConnectionStatusPending;
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        [self.sut objectsDidChange:[NSSet setWithObjects:blockedConnection, pendingConnection, nil]];
+        
+        // then
+        XCTAssertEqual(self.sut.unreadConversationCount, 1u);
+        XCTAssertEqual(self.sut.unreadConversationCount, [ZMConversation unreadConversationCountInContext:self.syncMOC]);
+        
+        // when
+        pendingConnection.status = ZMConnectionStatusAccepted;
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        [self.sut objectsDidChange:[NSSet setWithObject:pendingConnection]];
+        
+        // then
+        XCTAssertEqual(self.sut.unreadConversationCount, 0u);
+        XCTAssertEqual(self.sut.unreadConversationCount, [ZMConversation unreadConversationCountInContext:self.syncMOC]);
+    }];
+}
+
+- (void)testThatItIgnoresChangesBeforeTheFirstRead
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMConversation *conversation = [self insertGroupConversationWithUnreadCount:1];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        
+        // when
+        [self.sut objectsDidChange:[NSSet setWithObject:conversation]];
+        [self.sut objectsDidChange:[NSSet setWithObject:conversation]];
+        
+        // then
+        XCTAssertEqual(self.sut.unreadConversationCount, 1u);
+    }];
+}
+
+#if DEBUG
+- (void)testThatTheSelfCheckCorrectsAMissedChange
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        self.sut.selfCheckInterval = 3;
+        ZMConversation *conversation = [self insertGroupConversationWithUnreadCount:1];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        XCTAssertEqual(self.sut.unreadConversationCount, 1u);
+        
+        // when
+        conversation.internalEstimatedUnreadCount = 0;
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        [self performIgnoringZMLogError:^{
+            for (NSUInteger i = 0; i < self.sut.selfCheckInterval; ++i) {
+                (void)self.sut.unreadConversationCount;
+            }
+        }];
+        
+        // then
+        XCTAssertEqual(self.sut.unreadConversationCount, 0u);
+    }];
+}
+#endif
+
+- (void)testThatItFetchesAgainAfterAReset
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMConversation *conversation = [self insertGroupConversationWithUnreadCount:1];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        XCTAssertEqual(self.sut.unreadConversationCount, 1u);
+        
+        // when
+        conversation.internalEstimatedUnreadCount = 0;
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        [self.sut reset];
+        
+        // then
+        XCTAssertEqual(self.sut.unreadConversationCount, 0u);
+    }];
+}
+
+@end
@@ -118,3 +118,233 @@
 }
 
 @end
+
+
+
+@implementation ZMUpdateEventsBufferTests (Index)
+
+- (void)testThatItDoesNotAddAnEventWithTheSameIdentifierTwice
+{
+    // given
+    ZMUpdateEvent *event = [self dummyEvent];
+    [self.sut addUpdateEvent:event];
+    
+    // when
+    [self.sut addUpdateEvent:event];
+    
+    // then
+    XCTAssertEqual(self.sut.count, 1u);
+    XCTAssertEqualObjects(self.sut.updateEvents, @[event]);
+}
+
+- (void)testThatItIgnoresEventsThatWereDiscardedBeforeTheyWereAdded
+{
+    // given
+    ZMUpdateEvent *event1 = [self dummyEvent];
+    ZMUpdateEvent *event2 = [self dummyEvent];
+    [self.sut addUpdateEvent:event1];
+    
+    // when
+    [self.sut discardUpdateEventsWithIdentifiers:[NSSet setWithObjects:event1.uuid, event2.uuid, nil]];
+    [self.sut addUpdateEvent:event2];
+    
+    // then
+    XCTAssertEqual(self.sut.count, 0u);
+    XCTAssertEqualObjects(self.sut.updateEvents, @[]);
+}
+
+- (void)testThatItAcceptsADiscardedIdentifierAgainAfterProcessingTheBuffer
+{
+    // given
+    ZMUpdateEvent *event = [self dummyEvent];
+    [self.sut discardUpdateEventsWithIdentifiers:[NSSet setWithObject:event.uuid]];
+    [[(id)self.consumer expect] consumeUpdateEvents:@[]];
+    [self.sut processAllEventsInBuffer];
+    
+    // when
+    [self.sut addUpdateEvent:event];
+    
+    // then
+    XCTAssertEqualObjects(self.sut.updateEvents, @[event]);
+}
+
+@end
+
+
+
+@implementation ZMUpdateEventsBufferTests (Journal)
+
+- (ZMUpdateEvent *)eventWithIndex:(NSUInteger)index
+{
+    NSDictionary *data = @{@"id" : NSUUID.createUUID.transportString,
+                           @"payload" : @[@{@"type" : @"conversation.typing",
+                                            @"conversation" : NSUUID.createUUID.transportString,
+                                            @"data" : @{@"index" : @(index)}}]};
+    return [ZMUpdateEvent eventsArrayFromPushChannelData:data].firstObject;
+}
+
+- (NSArray *)identifiersOfEvents:(NSArray *)events
+{
+    return [events mapWithBlock:^id(ZMUpdateEvent *event) {
+        return event.uuid;
+    }];
+}
+
+- (ZMUpdateEventsBuffer *)bufferWithMaximumNumberOfEventsInMemory:(NSUInteger)maximum journalURL:(NSURL *)journalURL
+{
+    return [[ZMUpdateEventsBuffer alloc] initWithUpdateEventConsumer:self.consumer maximumNumberOfEventsInMemory:maximum journalURL:journalURL];
+}
+
+- (NSURL *)journalURL
+{
+    return [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.journal", NSUUID.createUUID.transportString]]];
+}
+
+- (void)testThatItSpillsEventsBeyondTheMemoryBudgetAndReplaysThemInOrder
+{
+    // given
+    ZMUpdateEventsBuffer *sut = [self bufferWithMaximumNumberOfEventsInMemory:3 journalURL:self.journalURL];
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 10; ++i) {
+        [events addObject:[self eventWithIndex:i]];
+    }
+    
+    // when
+    for (ZMUpdateEvent *event in events) {
+        [sut addUpdateEvent:event];
+    }
+    
+    // then
+    XCTAssertEqual(sut.count, 10u);
+    XCTAssertEqual(sut.numberOfSpilledEvents, 7u);
+    NSArray *replayed = sut.updateEvents;
+    XCTAssertEqualObjects([self identifiersOfEvents:replayed], [self identifiersOfEvents:events]);
+    XCTAssertEqualObjects([replayed.lastObject payload], [events.lastObject payload]);
+}
+
+- (void)testThatItKeepsTheDebugInformationOfASpilledEvent
+{
+    // given
+    ZMUpdateEventsBuffer *sut = [self bufferWithMaximumNumberOfEventsInMemory:1 journalURL:self.journalURL];
+    ZMUpdateEvent *event1 = [self eventWithIndex:1];
+    ZMUpdateEvent *event2 = [self eventWithIndex:2];
+    [event2 appendDebugInformation:@"From push channel (web socket)"];
+    
+    // when
+    [sut addUpdateEvent:event1];
+    [sut addUpdateEvent:event2];
+    
+    // then
+    XCTAssertEqual(sut.numberOfSpilledEvents, 1u);
+    ZMUpdateEvent *replayed = sut.updateEvents.lastObject;
+    XCTAssertEqualObjects(replayed.uuid, event2.uuid);
+    XCTAssertEqualObjects(replayed.debugInformation, event2.debugInformation);
+}
+
+- (void)testThatItDiscardsASpilledEvent
+{
+    // given
+    ZMUpdateEventsBuffer *sut = [self bufferWithMaximumNumberOfEventsInMemory:1 journalURL:self.journalURL];
+    ZMUpdateEvent *event1 = [self eventWithIndex:1];
+    ZMUpdateEvent *event2 = [self eventWithIndex:2];
+    ZMUpdateEvent *event3 = [self eventWithIndex:3];
+    [sut addUpdateEvent:event1];
+    [sut addUpdateEvent:event2];
+    [sut addUpdateEvent:event3];
+    
+    // when
+    [sut discardUpdateEventWithIdentifier:event2.uuid];
+    [sut addUpdateEvent:event2];
+    
+    // then
+    XCTAssertEqualObjects([self identifiersOfEvents:sut.updateEvents], (@[event1.uuid, event3.uuid, event2.uuid]));
+}
+
+- (void)testThatItHandsSpilledEventsToTheConsumerInChunksAndRemovesTheJournal
+{
+    // given
+    NSURL *journalURL = self.journalURL;
+    ZMUpdateEventsBuffer *sut = [self bufferWithMaximumNumberOfEventsInMemory:2 journalURL:journalURL];
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 5; ++i) {
+        [events addObject:[self eventWithIndex:i]];
+        [sut addUpdateEvent:events.lastObject];
+    }
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:journalURL.path]);
+    
+    // expect
+    NSMutableArray *consumedChunks = [NSMutableArray array];
+    [[[(id)self.consumer stub] andDo:^(NSInvocation *invocation) {
+        __unsafe_unretained NSArray *chunk;
+        [invocation getArgument:&chunk atIndex:2];
+        [consumedChunks addObject:[self identifiersOfEvents:chunk]];
+    }] consumeUpdateEvents:OCMOCK_ANY];
+    
+    // when
+    [sut processAllEventsInBuffer];
+    
+    // then
+    NSArray *identifiers = [self identifiersOfEvents:events];
+    XCTAssertEqualObjects(consumedChunks, (@[[identifiers subarrayWithRange:NSMakeRange(0, 2)],
+                                             [identifiers subarrayWithRange:NSMakeRange(2, 2)],
+                                             [identifiers subarrayWithRange:NSMakeRange(4, 1)]]));
+    XCTAssertEqual(sut.count, 0u);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:journalURL.path]);
+}
+
+- (void)testThatItRemovesAJournalThatWasLeftBehindWhenItIsCreated
+{
+    // given
+    NSURL *journalURL = self.journalURL;
+    ZMUpdateEventsBuffer *previousBuffer = [self bufferWithMaximumNumberOfEventsInMemory:1 journalURL:journalURL];
+    [previousBuffer addUpdateEvent:[self eventWithIndex:1]];
+    [previousBuffer addUpdateEvent:[self eventWithIndex:2]];
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:journalURL.path]);
+    
+    // when
+    ZMUpdateEventsBuffer *sut = [self bufferWithMaximumNumberOfEventsInMemory:1 journalURL:journalURL];
+    
+    // then
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:journalURL.path]);
+    XCTAssertEqual(sut.count, 0u);
+    XCTAssertEqual(previousBuffer.numberOfSpilledEvents, 1u);
+}
+
+- (void)testThatItKeepsAllEventsInMemoryWithoutAJournalURL
+{
+    // given
+    ZMUpdateEventsBuffer *sut = [[ZMUpdateEventsBuffer alloc] initWithUpdateEventConsumer:self.consumer maximumNumberOfEventsInMemory:1 journalURL:nil];
+    ZMUpdateEvent *event1 = [self eventWithIndex:1];
+    ZMUpdateEvent *event2 = [self eventWithIndex:2];
+    
+    // when
+    [sut addUpdateEvent:event1];
+    [sut addUpdateEvent:event2];
+    
+    // then
+    XCTAssertEqual(sut.numberOfSpilledEvents, 0u);
+    XCTAssertEqualObjects([self identifiersOfEvents:sut.updateEvents], (@[event1.uuid, event2.uuid]));
+}
+
+- (void)testThatItEnumeratesSpilledEventsInTheOrderTheyWereAdded
+{
+    // given
+    ZMUpdateEventsBuffer *sut = [self bufferWithMaximumNumberOfEventsInMemory:2 journalURL:self.journalURL];
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 5; ++i) {
+        [events addObject:[self eventWithIndex:i]];
+        [sut addUpdateEvent:events.lastObject];
+    }
+    NSMutableArray *enumeratedEvents = [NSMutableArray array];
+    
+    // when
+    [sut enumerateUpdateEventsUsingBlock:^(ZMUpdateEvent *event) {
+        [enumeratedEvents addObject:event];
+    }];
+    
+    // then
+    XCTAssertEqualObjects([self identifiersOfEvents:enumeratedEvents], [self identifiersOfEvents:events]);
+}
+
+@end
+
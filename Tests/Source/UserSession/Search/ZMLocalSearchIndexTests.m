@@ -0,0 +1,350 @@
+// 
+// Wire
+// Copyright (C) 2016 Wire Swiss GmbH
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// 
+
+
+@import ZMCDataModel;
+
+#import "MessagingTest.h"
+#import "ZMLocalSearchIndex.h"
+
+
+@interface ZMLocalSearchIndexTests : MessagingTest
+
+@property (nonatomic) ZMLocalSearchIndex *sut;
+
+@end
+
+
+
+@implementation ZMLocalSearchIndexTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.sut = [[ZMLocalSearchIndex alloc] initWithManagedObjectContext:self.syncMOC];
+}
+
+- (void)tearDown
+{
+    self.sut = nil;
+    [super tearDown];
+}
+
+- (ZMUser *)insertUserWithName:(NSString *)name connected:(BOOL)connected
+{
+    ZMUser *user = [ZMUser insertNewObjectInManagedObjectContext:self.syncMOC];
+    user.name = name;
+    user.remoteIdentifier = [NSUUID createUUID];
+    if (connected) {
+        ZMConnection *connection = [ZMConnection insertNewObjectInManagedObjectContext:self.syncMOC];
+        connection.to = user;
+        connection.status = ZMConnectionStatusAccepted;
+    }
+    return user;
+}
+
+- (ZMConversation *)insertGroupConversationWithName:(NSString *)name participants:(NSArray<ZMUser *> *)participants
+{
+    ZMConversation *conversation = [ZMConversation insertNewObjectInManagedObjectContext:self.syncMOC];
+    conversation.userDefinedName = name;
+    conversation.conversationType = ZMConversationTypeGroup;
+    conversation.remoteIdentifier = [NSUUID createUUID];
+    for (ZMUser *participant in participants) {
+        [conversation addParticipant:participant];
+    }
+    return conversation;
+}
+
+- (void)saveAndBuildIndex
+{
+    XCTAssertTrue([self.syncMOC saveOrRollback]);
+    [self.sut buildIfNeeded];
+}
+
+- (void)testThatItReturnsNilAndSchedulesABuildWhenItIsNotBuilt
+{
+    // given
+    [self.syncMOC performGroupedBlockAndWait:^{
+        [self insertUserWithName:@"Somebody" connected:YES];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+    }];
+    
+    // when
+    NSArray *result = [self.sut userObjectIDsMatchingSearchString:@"Some"];
+    
+    // then
+    XCTAssertNil(result);
+    WaitForAllGroupsToBeEmpty(0.5);
+    XCTAssertTrue(self.sut.isBuilt);
+    XCTAssertEqual([self.sut userObjectIDsMatchingSearchString:@"Some"].count, 1u);
+}
+
+- (void)testThatItReturnsNilForAQueryWithoutWords
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        [self saveAndBuildIndex];
+        
+        // then
+        XCTAssertNil([self.sut userObjectIDsMatchingSearchString:@""]);
+        XCTAssertNil([self.sut conversationObjectIDsMatchingSearchString:@"  "]);
+    }];
+}
+
+- (void)testThatItFindsUsersByThePrefixesOfTheWordsOfTheirName
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMUser *user1 = [self insertUserWithName:@"Some Body" connected:YES];
+        ZMUser *user2 = [self insertUserWithName:@"Some" connected:YES];
+        [self insertUserWithName:@"Any Body" connected:YES];
+        [self saveAndBuildIndex];
+        
+        // then
+        XCTAssertEqualObjects([self.sut userObjectIDsMatchingSearchString:@"Some Bo"], @[user1.objectID]);
+        XCTAssertEqualObjects([NSSet setWithArray:[self.sut userObjectIDsMatchingSearchString:@"so"]], ([NSSet setWithObjects:user1.objectID, user2.objectID, nil]));
+        XCTAssertEqualObjects([self.sut userObjectIDsMatchingSearchString:@"mebo"], @[]);
+    }];
+}
+
+- (void)testThatItIgnoresCaseAndDiacritics
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMUser *user = [self insertUserWithName:@"Émile Zola" connected:YES];
+        [self saveAndBuildIndex];
+        
+        // then
+        XCTAssertEqualObjects([self.sut userObjectIDsMatchingSearchString:@"emi"], @[user.objectID]);
+        XCTAssertEqualObjects([self.sut userObjectIDsMatchingSearchString:@"ZOL"], @[user.objectID]);
+    }];
+}
+
+- (void)testThatItFindsUsersByTheirFullEmailAddress
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMUser *user = [self insertUserWithName:@"User1" connected:YES];
+        user.emailAddress = @"user1@example.com";
+        [self saveAndBuildIndex];
+        
+        // then
+        XCTAssertEqualObjects([self.sut userObjectIDsMatchingSearchString:@"User1@Example.com"], @[user.objectID]);
+    }];
+}
+
+- (void)testThatItDoesNotIndexTheSelfUser
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMUser *selfUser = [ZMUser selfUserInContext:self.syncMOC];
+        selfUser.name = @"Myself";
+        [self saveAndBuildIndex];
+        
+        // then
+        XCTAssertEqualObjects([self.sut userObjectIDsMatchingSearchString:@"Myself"], @[]);
+    }];
+}
+
+- (void)testThatItRanksNamesThatStartWithTheQueryFirst
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMUser *user1 = [self insertUserWithName:@"Anna Bell" connected:YES];
+        ZMUser *user2 = [self insertUserWithName:@"Bella Zweig" connected:YES];
+        ZMUser *user3 = [self insertUserWithName:@"Bell" connected:YES];
+        [self saveAndBuildIndex];
+        
+        // then
+        NSArray *expected = @[user3.objectID, user2.objectID, user1.objectID];
+        XCTAssertEqualObjects([self.sut userObjectIDsMatchingSearchString:@"bel"], expected);
+    }];
+}
+
+- (void)testThatItUpdatesUsersThatChanged
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMUser *user = [self insertUserWithName:@"Old Name" connected:YES];
+        [self saveAndBuildIndex];
+        
+        // when
+        user.name = @"New Name";
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        [self.sut objectsDidChange:[NSSet setWithObject:user]];
+        
+        // then
+        XCTAssertEqualObjects([self.sut userObjectIDsMatchingSearchString:@"old"], @[]);
+        XCTAssertEqualObjects([self.sut userObjectIDsMatchingSearchString:@"new na"], @[user.objectID]);
+    }];
+}
+
+- (void)testThatItFindsConversationsByNameBeforeConversationsByParticipants
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMUser *user1 = [self insertUserWithName:@"Ruth" connected:YES];
+        ZMUser *user2 = [self insertUserWithName:@"Barbara" connected:YES];
+        ZMConversation *conversation1 = [self insertGroupConversationWithName:nil participants:@[user1, user2]];
+        ZMConversation *conversation2 = [self insertGroupConversationWithName:@"Ruthless" participants:@[user2]];
+        [self insertGroupConversationWithName:@"Other" participants:@[user2]];
+        [self saveAndBuildIndex];
+        
+        // then
+        NSArray *expected = @[conversation2.objectID, conversation1.objectID];
+        XCTAssertEqualObjects([self.sut conversationObjectIDsMatchingSearchString:@"ruth"], expected);
+    }];
+}
+
+- (void)testThatItUpdatesTheParticipantsOfConversationsThatChanged
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        ZMUser *user1 = [self insertUserWithName:@"Ruth" connected:YES];
+        ZMUser *user2 = [self insertUserWithName:@"Barbara" connected:YES];
+        ZMConversation *conversation = [self insertGroupConversationWithName:@"Team" participants:@[user2]];
+        [self saveAndBuildIndex];
+        XCTAssertEqualObjects([self.sut conversationObjectIDsMatchingSearchString:@"ruth"], @[]);
+        
+        // when
+        [conversation addParticipant:user1];
+        XCTAssertTrue([self.syncMOC saveOrRollback]);
+        [self.sut objectsDidChange:[NSSet setWithObject:conversation]];
+        
+        // then
+        XCTAssertEqualObjects([self.sut conversationObjectIDsMatchingSearchString:@"ruth"], @[conversation.objectID]);
+    }];
+}
+
+@end
+
+
+
+@implementation ZMLocalSearchIndexTests (Consistency)
+
+- (NSArray<NSString *> *)firstNames
+{
+    return @[@"Anna", @"Bernd", @"Çelik", @"Dörte", @"Emil", @"Fiona", @"Gustav", @"Hanna", @"Ivan", @"Jürgen", @"Karin", @"Lars"];
+}
+
+- (NSArray<NSString *> *)lastNames
+{
+    return @[@"Meyer", @"Nowak", @"O'Brien", @"Petersen", @"Quast", @"Roth", @"Schmidt-Weber", @"Tanaka"];
+}
+
+- (void)insertUsers:(NSUInteger)numberOfUsers conversations:(NSUInteger)numberOfConversations
+{
+    NSArray *firstNames = self.firstNames;
+    NSArray *lastNames = self.lastNames;
+    NSMutableArray *users = [NSMutableArray array];
+    for (NSUInteger i = 0; i < numberOfUsers; ++i) {
+        NSString *firstName = firstNames[i % firstNames.count];
+        NSString *name = [NSString stringWithFormat:@"%@ %@ %lu", firstName, lastNames[(i / firstNames.count) % lastNames.count], (unsigned long)i];
+        ZMUser *user = [self insertUserWithName:name connected:(i % 3 != 0)];
+        if (i % 2 == 0) {
+            // every other address is stored with upper case letters
+            NSString *emailAddress = [NSString stringWithFormat:@"%@.%lu@example.com", firstName, (unsigned long)i];
+            user.emailAddress = (i % 4 == 0) ? emailAddress.lowercaseString : emailAddress;
+        }
+        [users addObject:user];
+    }
+    for (NSUInteger i = 0; i < numberOfConversations; ++i) {
+        NSString *name = (i % 4 == 0) ? nil : [NSString stringWithFormat:@"%@ Team %lu", lastNames[i % lastNames.count], (unsigned long)i];
+        NSArray *participants = @[users[(i * 7) % users.count], users[(i * 13 + 1) % users.count], users[(i * 31 + 2) % users.count]];
+        [self insertGroupConversationWithName:name participants:participants];
+    }
+}
+
+- (NSArray<NSString *> *)queries
+{
+    return @[@"a", @"an", @"anna", @"celik", @"Dö", @"ivan 1", @"o'b", @"obrien", @"schmidt", @"weber", @"team", @"roth team", @"ruth", @"12", @"x", @"emil meyer",
+             @"anna.0@example.com", @"EMIL.4@example.com", @"ivan.8@example.com", @"çelik.2@example.com", @"Gustav.6@Example.com", @" karin.10@example.com ",
+             @"karin.10@", @"karin.10", @"example.com", @"@example"];
+}
+
+- (NSSet *)objectIDsOfObjects:(NSArray *)objects
+{
+    NSMutableSet *objectIDs = [NSMutableSet set];
+    for (NSManagedObject *object in objects) {
+        [objectIDs addObject:object.objectID];
+    }
+    return objectIDs;
+}
+
+- (void)testThatItReturnsEverythingTheSearchPredicatesMatch
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        [self insertUsers:300 conversations:80];
+        [self saveAndBuildIndex];
+        
+        for (NSString *query in self.queries) {
+            // when
+            NSArray *users = [self.syncMOC executeFetchRequestOrAssert:[ZMUser sortedFetchRequestWithPredicate:[ZMUser predicateForConnectedUsersWithSearchString:query]]];
+            NSArray *conversations = [self.syncMOC executeFetchRequestOrAssert:[ZMConversation sortedFetchRequestWithPredicate:[ZMConversation predicateForSearchString:query]]];
+            NSSet *userCandidates = [NSSet setWithArray:[self.sut userObjectIDsMatchingSearchString:query]];
+            NSSet *conversationCandidates = [NSSet setWithArray:[self.sut conversationObjectIDsMatchingSearchString:query]];
+            
+            // then
+            XCTAssertTrue([[self objectIDsOfObjects:users] isSubsetOfSet:userCandidates], @"Users missing for \"%@\"", query);
+            XCTAssertTrue([[self objectIDsOfObjects:conversations] isSubsetOfSet:conversationCandidates], @"Conversations missing for \"%@\"", query);
+        }
+    }];
+}
+
+- (void)testThatRestrictingThePredicatesToTheCandidatesDoesNotChangeTheResults
+{
+    [self.syncMOC performGroupedBlockAndWait:^{
+        // given
+        [self insertUsers:300 conversations:80];
+        [self saveAndBuildIndex];
+        
+        for (NSString *query in self.queries) {
+            // when
+            NSPredicate *predicate = [ZMUser predicateForConnectedUsersWithSearchString:query];
+            NSArray *candidates = [self.sut userObjectIDsMatchingSearchString:query];
+            NSPredicate *restricted = [NSCompoundPredicate andPredicateWithSubpredicates:@[[NSPredicate predicateWithFormat:@"SELF IN %@", candidates], predicate]];
+            NSArray *expected = [self.syncMOC executeFetchRequestOrAssert:[ZMUser sortedFetchRequestWithPredicate:predicate]];
+            NSArray *actual = [self.syncMOC executeFetchRequestOrAssert:[ZMUser sortedFetchRequestWithPredicate:restricted]];
+            
+            // then
+            XCTAssertEqualObjects(actual, expected, @"Different results for \"%@\"", query);
+        }
+    }];
+}
+
+- (void)testPerformanceOfQueryingAnIndexOf20000UsersAnd5000Conversations
+{
+    // given
+    [self.syncMOC performGroupedBlockAndWait:^{
+        [self insertUsers:20000 conversations:5000];
+        [self saveAndBuildIndex];
+        [self.sut userObjectIDsMatchingSearchString:@"warm up"];
+    }];
+    NSArray *queries = self.queries;
+    
+    // when
+    [self measureBlock:^{
+        for (NSString *query in queries) {
+            [self.sut userObjectIDsMatchingSearchString:query];
+            [self.sut conversationObjectIDsMatchingSearchString:query];
+        }
+    }];
+}
+
+@end
@@ -1727,6 +1727,180 @@ typedef void (^URLSessionCompletionBlock)(NSData *data, NSURLResponse *response,
 
 
 
+@implementation ZMSearchDirectoryTests (PrefixRefinement)
+
+- (void)testThatItFiltersTheLocalResultOfAShorterQueryAndStillSearchesRemotely
+{
+    // given
+    self.sut.updateDelay = 999999;
+    self.sut.remoteSearchDelay = 0.05;
+    ZMConversation *conversation1 = [self createGroupConversationWithName:@"Alexis Group"];
+    [self createGroupConversationWithName:@"Alma Group"];
+    NSDictionary *remoteUserData1 = [self userDataWithName:@"Alexis Remote" id:[NSUUID createUUID] connected:NO];
+    // the backend also matches e.g. on handles, so a remote result does not need to match the query by name
+    NSDictionary *remoteUserData2 = [self userDataWithName:@"Bob" id:[NSUUID createUUID] connected:NO];
+    
+    __block ZMTransportRequest *request1;
+    __block ZMTransportRequest *request2;
+    [[self.transportSession expect] enqueueSearchRequest:ZM_ARG_SAVE(request1)];
+    [[self.transportSession expect] enqueueSearchRequest:ZM_ARG_SAVE(request2)];
+    
+    [self.sut searchForUsersAndConversationsMatchingQueryString:@"al"];
+    [self finishRequest:request1 withResponseData:[self responseDataForUsers:@[remoteUserData1]] failureRecorder:NewFailureRecorder()];
+    [self waitForSearchResultsWithFailureRecorder:NewFailureRecorder() shouldFail:NO];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // when
+    [self resetSearchResultExpectation];
+    ZMSearchToken token = [self.sut searchForUsersAndConversationsMatchingQueryString:@"Ale"];
+    [self spinMainQueueWithTimeout:0.2];
+    
+    // then
+    [self.transportSession verify];
+    XCTAssertEqualObjects(request2.path, @"/search/contacts?q=Ale&l=3&size=30");
+    
+    // and when
+    [self finishRequest:request2 withResponseData:[self responseDataForUsers:@[remoteUserData1, remoteUserData2]] failureRecorder:NewFailureRecorder()];
+    [self waitForSearchResultsWithFailureRecorder:NewFailureRecorder() shouldFail:NO];
+    
+    // then
+    ZMSearchResult *result = [self firstSearchResultForToken:token];
+    XCTAssertEqual(result.usersInDirectory.count, 2u);
+    XCTAssertTrue([self isUserDataFromDirectory:remoteUserData2 equalToSearchUser:result.usersInDirectory.lastObject]);
+    XCTAssertEqual(result.groupConversations.count, 1u);
+    XCTAssertEqualObjects(conversation1, result.groupConversations[0]);
+}
+
+- (void)testThatItDoesNotFilterTheResultOfAShorterEmailAddress
+{
+    // given
+    self.sut.updateDelay = 999999;
+    
+    __block ZMTransportRequest *request1;
+    __block ZMTransportRequest *request2;
+    [[self.transportSession expect] enqueueSearchRequest:ZM_ARG_SAVE(request1)];
+    [[self.transportSession expect] enqueueSearchRequest:ZM_ARG_SAVE(request2)];
+    
+    [self.sut searchForUsersAndConversationsMatchingQueryString:@"alex@example.co"];
+    [self finishRequest:request1 withResponseData:[self responseDataForUsers:@[]] failureRecorder:NewFailureRecorder()];
+    [self waitForSearchResultsWithFailureRecorder:NewFailureRecorder() shouldFail:NO];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // when
+    [self.sut searchForUsersAndConversationsMatchingQueryString:@"alex@example.com"];
+    
+    // then
+    [self.transportSession verify];
+    XCTAssertNotNil(request2);
+}
+
+- (void)testThatItSearchesAgainAfterTheCacheWasInvalidated
+{
+    // given
+    self.sut.updateDelay = 999999;
+    [self createConnectedUserWithName:@"Alice"];
+    
+    [self.sut searchForLocalUsersAndConversationsMatchingQueryString:@"al"];
+    [self waitForSearchResultsWithFailureRecorder:NewFailureRecorder() shouldFail:NO];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    ZMUser *user2 = [self createConnectedUserWithName:@"Alina"];
+    
+    // when
+    [ZMSearchDirectory invalidateCachedTopConversations];
+    [self resetSearchResultExpectation];
+    ZMSearchToken token = [self.sut searchForLocalUsersAndConversationsMatchingQueryString:@"ali"];
+    [self waitForSearchResultsWithFailureRecorder:NewFailureRecorder() shouldFail:NO];
+    
+    // then
+    ZMSearchResult *result = [self firstSearchResultForToken:token];
+    XCTAssertEqual(result.usersInContacts.count, 2u);
+    XCTAssertTrue([[result.usersInContacts valueForKey:@"user"] containsObject:user2]);
+}
+
+- (void)testThatItRemovesSearchesWhoseResultIsNoLongerCached
+{
+    // given
+    self.sut.updateDelay = 0.05;
+    [self createConnectedUserWithName:@"Alice"];
+    
+    ZMSearchToken token1 = [self.sut searchForLocalUsersAndConversationsMatchingQueryString:@"al"];
+    [self waitForSearchResultsWithFailureRecorder:NewFailureRecorder() shouldFail:NO];
+    WaitForAllGroupsToBeEmpty(0.5);
+    XCTAssertNotNil(self.sut.searchMap[token1]);
+    [self spinMainQueueWithTimeout:0.2];
+    
+    // when
+    [self resetSearchResultExpectation];
+    ZMSearchToken token2 = [self.sut searchForLocalUsersAndConversationsMatchingQueryString:@"ali"];
+    [self waitForSearchResultsWithFailureRecorder:NewFailureRecorder() shouldFail:NO];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertNil(self.sut.searchMap[token1]);
+    XCTAssertNotNil(self.sut.searchMap[token2]);
+    XCTAssertEqual(self.sut.searchMap.count, 1u);
+}
+
+- (void)testThatItHoldsBackTheRemoteRequestOfAQueryThatReplacesARunningSearch
+{
+    // given
+    [self.sut removeSearchResultObserver:self];
+    self.sut.remoteSearchDelay = 0.1;
+    
+    __block ZMTransportRequest *request1;
+    __block ZMTransportRequest *request2;
+    [[self.transportSession expect] enqueueSearchRequest:ZM_ARG_SAVE(request1)];
+    [[self.transportSession expect] enqueueSearchRequest:ZM_ARG_SAVE(request2)];
+    
+    // when
+    [self.sut searchForUsersAndConversationsMatchingQueryString:@"a"];
+    [self.sut searchForUsersAndConversationsMatchingQueryString:@"al"];
+    
+    // then
+    XCTAssertNotNil(request1);
+    XCTAssertNil(request2);
+    
+    // and when
+    [self spinMainQueueWithTimeout:0.3];
+    
+    // then
+    [self.transportSession verify];
+    XCTAssertEqualObjects(request2.path, @"/search/contacts?q=al&l=3&size=30");
+    [self finishRequest:request1 withResponseData:[self responseDataForUsers:@[]] failureRecorder:NewFailureRecorder()];
+    [self finishRequest:request2 withResponseData:[self responseDataForUsers:@[]] failureRecorder:NewFailureRecorder()];
+    WaitForAllGroupsToBeEmpty(0.5);
+}
+
+- (void)testThatItDoesNotSendTheRemoteRequestOfAQueryThatWasReplacedWhileItWasHeldBack
+{
+    // given
+    [self.sut removeSearchResultObserver:self];
+    self.sut.remoteSearchDelay = 0.1;
+    
+    __block ZMTransportRequest *request1;
+    __block ZMTransportRequest *request2;
+    [[self.transportSession expect] enqueueSearchRequest:ZM_ARG_SAVE(request1)];
+    [[self.transportSession expect] enqueueSearchRequest:ZM_ARG_SAVE(request2)];
+    
+    // when
+    [self.sut searchForUsersAndConversationsMatchingQueryString:@"a"];
+    [self.sut searchForUsersAndConversationsMatchingQueryString:@"al"];
+    [self.sut searchForUsersAndConversationsMatchingQueryString:@"ale"];
+    [self spinMainQueueWithTimeout:0.3];
+    
+    // then
+    [self.transportSession verify];
+    XCTAssertEqualObjects(request2.path, @"/search/contacts?q=ale&l=3&size=30");
+    [self finishRequest:request1 withResponseData:[self responseDataForUsers:@[]] failureRecorder:NewFailureRecorder()];
+    [self finishRequest:request2 withResponseData:[self responseDataForUsers:@[]] failureRecorder:NewFailureRecorder()];
+    WaitForAllGroupsToBeEmpty(0.5);
+}
+
+@end
+
+
+
 @implementation ZMSearchDirectoryTests (TopConversations)
 
 - (void)testThatItRequests9TopConversations
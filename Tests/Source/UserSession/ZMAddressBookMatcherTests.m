@@ -135,4 +135,192 @@
     XCTAssertEqualObjects(matchingContacts, expectedMatchingContacts);
 }
 
+- (void)testThatContactForUserMatchesOnEmailAddressIgnoringCase {
+    // given
+    ZMUser *user = [ZMUser insertNewObjectInManagedObjectContext:self.uiMOC];
+    user.emailAddress = @"john.doe@example.com";
+    
+    ZMAddressBookContact *contact = [[ZMAddressBookContact alloc] init];
+    contact.emailAddresses = @[@"John.Doe@Example.com"];
+    
+    ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithContacts:@[contact]];
+    
+    // when
+    ZMAddressBookContact *matchedContact = [matcher contactForUser:user];
+    
+    // Then
+    XCTAssertEqualObjects(contact, matchedContact);
+}
+
+- (void)testThatContactForUserMatchesOnPhoneNumberIgnoringFormatting {
+    // given
+    ZMUser *user = [ZMUser insertNewObjectInManagedObjectContext:self.uiMOC];
+    user.phoneNumber = @"+4915112345678";
+    
+    ZMAddressBookContact *contact = [[ZMAddressBookContact alloc] init];
+    contact.phoneNumbers = @[@"+49 151 1234-5678"];
+    
+    ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithContacts:@[contact]];
+    
+    // when
+    ZMAddressBookContact *matchedContact = [matcher contactForUser:user];
+    
+    // Then
+    XCTAssertEqualObjects(contact, matchedContact);
+}
+
+- (void)testThatContactForUserReturnsTheFirstMatchingContact {
+    // given
+    ZMUser *user = [ZMUser insertNewObjectInManagedObjectContext:self.uiMOC];
+    user.emailAddress = @"john.doe@example.com";
+    user.phoneNumber = @"+591023901222";
+    
+    ZMAddressBookContact *contact1 = [[ZMAddressBookContact alloc] init];
+    contact1.emailAddresses = @[@"eva@example.com"];
+    
+    ZMAddressBookContact *contact2 = [[ZMAddressBookContact alloc] init];
+    contact2.phoneNumbers = @[user.phoneNumber];
+    
+    ZMAddressBookContact *contact3 = [[ZMAddressBookContact alloc] init];
+    contact3.emailAddresses = @[user.emailAddress];
+    
+    ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithContacts:@[contact1, contact2, contact3]];
+    
+    // when
+    ZMAddressBookContact *matchedContact = [matcher contactForUser:user];
+    
+    // Then
+    XCTAssertEqual(contact2, matchedContact);
+}
+
+- (void)testThatContactForUserReturnsNilWhenNoContactMatches {
+    // given
+    ZMUser *user = [ZMUser insertNewObjectInManagedObjectContext:self.uiMOC];
+    user.emailAddress = @"john.doe@example.com";
+    
+    ZMAddressBookContact *contact = [[ZMAddressBookContact alloc] init];
+    contact.emailAddresses = @[@"eva@example.com"];
+    
+    ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithContacts:@[contact]];
+    
+    // then
+    XCTAssertNil([matcher contactForUser:user]);
+}
+
+- (void)testThatContactsMatchingQueryMatchesAcrossWords
+{
+    // given
+    ZMAddressBookContact *contact1 = [[ZMAddressBookContact alloc] init];
+    contact1.firstName = @"Anna";
+    contact1.lastName = @"Smith";
+    
+    ZMAddressBookContact *contact2 = [[ZMAddressBookContact alloc] init];
+    contact2.firstName = @"Nadia";
+    contact2.lastName = @"Small";
+    
+    ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithContacts:@[contact1, contact2]];
+    
+    // then
+    XCTAssertEqualObjects([matcher contactsMatchingQuery:@"NA SM"], @[contact1]);
+    XCTAssertEqualObjects([matcher contactsMatchingQuery:@"sm"], (@[contact1, contact2]));
+    XCTAssertEqualObjects([matcher contactsMatchingQuery:@"mit"], @[contact1]);
+    XCTAssertEqualObjects([matcher contactsMatchingQuery:@"xyz"], @[]);
+}
+
+@end
+
+
+
+@implementation ZMAddressBookMatcherTests (LargeAddressBook)
+
+/// 10000 synthetic contacts, each with a name, an email address and a phone number
+- (NSArray *)syntheticContacts
+{
+    NSArray *firstNames = @[@"Anna", @"Björn", @"Chloé", @"Dmitri", @"Élodie", @"Farid", @"Greta", @"Hiroshi", @"Ingrid", @"José"];
+    NSArray *lastNames = @[@"Andersson", @"Brown", @"Çelik", @"Dupont", @"Eriksen", @"Fischer", @"García", @"Hansen", @"Ivanov", @"Jørgensen"];
+    
+    NSMutableArray *contacts = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 10000; ++i) {
+        ZMAddressBookContact *contact = [[ZMAddressBookContact alloc] init];
+        contact.firstName = firstNames[i % firstNames.count];
+        contact.lastName = [NSString stringWithFormat:@"%@%lu", lastNames[(i / firstNames.count) % lastNames.count], (unsigned long) (i / 100)];
+        contact.emailAddresses = @[[NSString stringWithFormat:@"contact%lu@example.com", (unsigned long) i]];
+        contact.phoneNumbers = @[[NSString stringWithFormat:@"+4930%07lu", (unsigned long) i]];
+        [contacts addObject:contact];
+    }
+    return contacts;
+}
+
+- (NSArray *)queries
+{
+    return @[@"a", @"an", @"ANNA", @"bjorn", @"chloe", @"celik", @"sen", @"gar", @"garcia1", @"o g", @"na a", @"99", @"xyz", @" "];
+}
+
+- (void)testThatContactsMatchingQueryReturnsTheSameContactsAsAPredicate
+{
+    // given
+    NSArray *contacts = [self syntheticContacts];
+    ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithContacts:contacts];
+    
+    for (NSString *query in self.queries) {
+        // when
+        NSArray *expected = [contacts filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"SELF.name CONTAINS[cd] %@", query]];
+        NSArray *matchingContacts = [matcher contactsMatchingQuery:query];
+        
+        // then
+        XCTAssertEqualObjects(matchingContacts, expected, @"Different contacts for \"%@\"", query);
+    }
+}
+
+- (void)testThatContactForUserFindsTheContactInALargeAddressBook
+{
+    // given
+    NSArray *contacts = [self syntheticContacts];
+    ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithContacts:contacts];
+    ZMUser *user1 = [ZMUser insertNewObjectInManagedObjectContext:self.uiMOC];
+    user1.emailAddress = @"contact9876@example.com";
+    ZMUser *user2 = [ZMUser insertNewObjectInManagedObjectContext:self.uiMOC];
+    user2.phoneNumber = @"+49300001234";
+    
+    // then
+    XCTAssertEqual([matcher contactForUser:user1], contacts[9876]);
+    XCTAssertEqual([matcher contactForUser:user2], contacts[1234]);
+}
+
+- (void)testPerformanceOfMatchingUsersAndQueriesAgainst10000Contacts
+{
+    // given
+    NSArray *contacts = [self syntheticContacts];
+    ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithContacts:contacts];
+    NSMutableArray *users = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 500; ++i) {
+        ZMUser *user = [ZMUser insertNewObjectInManagedObjectContext:self.uiMOC];
+        user.emailAddress = [NSString stringWithFormat:@"contact%lu@example.com", (unsigned long) (i * 19)];
+        [users addObject:user];
+    }
+    NSArray *queries = self.queries;
+    
+    // when
+    [self measureBlock:^{
+        for (ZMUser *user in users) {
+            [matcher contactForUser:user];
+        }
+        for (NSString *query in queries) {
+            [matcher contactsMatchingQuery:query];
+        }
+    }];
+}
+
+- (void)testPerformanceOfIndexing10000Contacts
+{
+    // given
+    NSArray *contacts = [self syntheticContacts];
+    
+    // when
+    [self measureBlock:^{
+        ZMAddressBookMatcher *matcher = [[ZMAddressBookMatcher alloc] initWithContacts:contacts];
+        XCTAssertEqual(matcher.contacts.count, 10000u);
+    }];
+}
+
 @end
@@ -23,6 +23,8 @@
 
 #include "ZMUserSessionTestsBase.h"
 #import "ZMPushToken.h"
+#import "ZMAddressBook.h"
+#import "ZMAddressBookMatcher.h"
 
 @interface ZMUserSessionTests : ZMUserSessionTestsBase
 
@@ -1798,3 +1800,88 @@
 }
 
 @end
+
+
+
+@implementation ZMUserSessionTests (AddressBook)
+
+- (id)mockAddressBookWithContacts:(NSArray *)contacts
+{
+    id addressBook = [OCMockObject mockForClass:ZMAddressBook.class];
+    [[[[addressBook stub] classMethod] andReturnValue:@YES] userHasAuthorizedAccess];
+    [[[[addressBook stub] classMethod] andReturn:addressBook] addressBook];
+    [(ZMAddressBook *)[[addressBook stub] andReturn:contacts] contacts];
+    return addressBook;
+}
+
+- (ZMAddressBookContact *)contactWithEmailAddress:(NSString *)emailAddress
+{
+    ZMAddressBookContact *contact = [[ZMAddressBookContact alloc] init];
+    contact.firstName = @"John";
+    contact.emailAddresses = @[emailAddress];
+    return contact;
+}
+
+- (void)testThatItBuildsTheAddressBookMatcherInTheBackground
+{
+    // given
+    id addressBook = [self mockAddressBookWithContacts:@[[self contactWithEmailAddress:@"john@example.com"]]];
+    
+    // when
+    ZMAddressBookMatcher *matcher = self.sut.addressBookMatcher;
+    
+    // then
+    XCTAssertNil(matcher);
+    
+    // and when
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertNotNil(self.sut.addressBookMatcher);
+    XCTAssertEqual(self.sut.addressBookMatcher.contacts.count, 1u);
+    
+    [addressBook stopMocking];
+}
+
+- (void)testThatItCallsTheCompletionHandlerOnceTheAddressBookMatcherIsBuilt
+{
+    // given
+    id addressBook = [self mockAddressBookWithContacts:@[[self contactWithEmailAddress:@"john@example.com"]]];
+    __block NSUInteger numberOfCalls = 0;
+    __block ZMAddressBookMatcher *matcher;
+    
+    // when
+    [self.sut addressBookMatcherWithCompletionHandler:^(ZMAddressBookMatcher *builtMatcher) {
+        matcher = builtMatcher;
+        ++numberOfCalls;
+    }];
+    WaitForAllGroupsToBeEmpty(0.5);
+    
+    // then
+    XCTAssertEqual(numberOfCalls, 1u);
+    XCTAssertNotNil(matcher);
+    XCTAssertEqual(matcher, self.sut.addressBookMatcher);
+    
+    [addressBook stopMocking];
+}
+
+- (void)testThatItCallsTheCompletionHandlerRightAwayWhenTheAddressBookMatcherIsAlreadyBuilt
+{
+    // given
+    id addressBook = [self mockAddressBookWithContacts:@[[self contactWithEmailAddress:@"john@example.com"]]];
+    [self.sut addressBookMatcher];
+    WaitForAllGroupsToBeEmpty(0.5);
+    __block ZMAddressBookMatcher *matcher;
+    
+    // when
+    [self.sut addressBookMatcherWithCompletionHandler:^(ZMAddressBookMatcher *builtMatcher) {
+        matcher = builtMatcher;
+    }];
+    
+    // then
+    XCTAssertNotNil(matcher);
+    
+    [addressBook stopMocking];
+}
+
+@end